@@ -0,0 +1,83 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#include "ImageGraphCut3DBatchSegmentation.h"
+
+#include <fstream>
+#include <sstream>
+
+/** This example segments a list of independent cases on several threads. Every line of the job list describes one
+* case:
+*   image foregroundMask backgroundMask output sigma [boundaryDirection]
+* with the arguments of ImageGraphCut3DSegmentationExample. Empty lines and lines starting with # are skipped.
+*
+* Instead of a number of threads, "pipelined" overlaps reading, graph building, solving and writing of consecutive cases.
+*/
+int main(int argc, char *argv[]) {
+    // Verify arguments
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Required: jobList [threads|pipelined]" << std::endl;
+        std::cerr << "jobList:             text file with one case per line:" << std::endl;
+        std::cerr << "                     image foregroundMask backgroundMask output sigma [boundaryDirection]" << std::endl;
+        std::cerr << "threads              number of cases segmented at the same time, default one per core" << std::endl;
+        std::cerr << "pipelined            one thread per stage instead of one per case" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Parse arguments
+    std::string jobListFilename = argv[1];
+    bool pipelined = argc > 2 && std::string(argv[2]) == "pipelined";
+    unsigned int numberOfThreads = argc > 2 && !pipelined ? atoi(argv[2]) : 0;
+
+    // Define all image types
+    typedef itk::Image<short, 3> ImageType;
+    typedef itk::Image<unsigned char, 3> ForegroundMaskType;
+    typedef itk::Image<unsigned char, 3> BackgroundMaskType;
+    typedef itk::Image<unsigned char, 3> OutputImageType;
+
+    typedef itk::ImageGraphCut3DBatchSegmentation<ImageType, ForegroundMaskType, BackgroundMaskType, OutputImageType> BatchType;
+    BatchType::Pointer batch = BatchType::New();
+
+    // Read the job list
+    std::ifstream jobList(jobListFilename.c_str());
+    if (!jobList) {
+        std::cerr << "ERROR: Can not read " << jobListFilename << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string line;
+    while (std::getline(jobList, line)) {
+        std::istringstream fields(line);
+        BatchType::Job job;
+        int boundaryDirection = 0;  // 0->bidirectional; 1->bright to dark; 2->dark to bright
+        if (!(fields >> job.inputFileName) || job.inputFileName[0] == '#') {
+            continue;
+        }
+        if (!(fields >> job.foregroundFileName >> job.backgroundFileName >> job.outputFileName >> job.sigma)) {
+            std::cerr << "ERROR: Incomplete job: " << line << std::endl;
+            return EXIT_FAILURE;
+        }
+        fields >> boundaryDirection;
+        job.boundaryDirection = boundaryDirection == 1 ? BatchType::FilterType::BrightDark :
+                                (boundaryDirection == 2 ? BatchType::FilterType::DarkBright : BatchType::FilterType::NoDirection);
+        batch->AddJob(job);
+    }
+    std::cout << "*** Segmenting " << batch->GetNumberOfJobs() << " cases ***" << std::endl;
+
+    itk::TimeProbe probe;
+    probe.Start();
+    batch->SetNumberOfThreads(numberOfThreads);
+    batch->SetPipelined(pipelined);
+    batch->SetVerboseOutput(true);
+    batch->Update();
+    probe.Stop();
+
+    std::cout << "Total: " << probe.GetTotal() << " " << probe.GetUnit() << ", failed cases: "
+              << batch->GetNumberOfFailedJobs() << std::endl;
+    return batch->GetNumberOfFailedJobs() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
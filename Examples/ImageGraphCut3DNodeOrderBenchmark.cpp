@@ -0,0 +1,132 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#include "ImageGraphCut3DKolmogorovFilter.hxx"
+
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+/** This example compares the raster and the brick node order of the Kolmogorov solver on one image. It prints the mean
+* wall time of each order and the number of voxels they label differently, which can only be voxels where several
+* minimum cuts exist.
+*
+* With only one order per run, the cache misses can be counted by an external profiler, e.g.
+*   perf stat -e cache-misses,cache-references ImageGraphCut3DNodeOrderBenchmark ... raster 3
+*/
+static void printUsage() {
+    std::cerr << "Required: image foregroundMask backgroundMask sigma order [repetitions]" << std::endl;
+    std::cerr << "image:               3D image, e.g. data/test/left_femur/input.nrrd" << std::endl;
+    std::cerr << "foregroundMask:      3D image non-zero pixels indicating foreground and 0 elsewhere" << std::endl;
+    std::cerr << "backgroundMask:      3D image non-zero pixels indicating background and 0 elsewhere" << std::endl;
+    std::cerr << "sigma                estimated noise in boundary term, try 50.0" << std::endl;
+    std::cerr << "order                raster, brick size (e.g. 4) or both" << std::endl;
+    std::cerr << "repetitions          number of runs per order, at least 1, default 3" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    // Verify arguments
+    if (argc < 6 || argc > 7) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Parse arguments
+    std::string imageFilename = argv[1];
+    std::string foregroundFilename = argv[2];
+    std::string backgroundFilename = argv[3];
+    double sigma = atof(argv[4]);
+    std::string order = argv[5];
+    int repetitions = argc > 6 ? atoi(argv[6]) : 3;
+
+    bool runRaster = order == "raster" || order == "both";
+    int brickSize = order == "both" ? 4 : (order == "raster" ? 0 : atoi(order.c_str()));
+
+    // An unknown order, e.g. "brick", or no repetitions would time nothing
+    if ((!runRaster && brickSize <= 0) || repetitions < 1) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Define all image types
+    typedef itk::Image<short, 3> ImageType;
+    typedef itk::Image<unsigned char, 3> ForegroundMaskType;
+    typedef itk::Image<unsigned char, 3> BackgroundMaskType;
+    typedef itk::Image<unsigned char, 3> OutputImageType;
+
+    // Read the images once, only the graph cut is timed
+    std::cout << "*** Reading images ***" << std::endl;
+    typedef itk::ImageFileReader<ImageType> ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName(imageFilename);
+    typedef itk::ImageFileReader<ForegroundMaskType> ForegroundMaskReaderType;
+    ForegroundMaskReaderType::Pointer foregroundMaskReader = ForegroundMaskReaderType::New();
+    foregroundMaskReader->SetFileName(foregroundFilename);
+    typedef itk::ImageFileReader<BackgroundMaskType> BackgroundMaskReaderType;
+    BackgroundMaskReaderType::Pointer backgroundMaskReader = BackgroundMaskReaderType::New();
+    backgroundMaskReader->SetFileName(backgroundFilename);
+    try {
+        reader->Update();
+        foregroundMaskReader->Update();
+        backgroundMaskReader->Update();
+    }
+    catch (itk::ExceptionObject &err) {
+        std::cerr << "ERROR: Exception caught while reading the images" << std::endl;
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    typedef itk::ImageGraphCut3DKolmogorovFilter<ImageType, ForegroundMaskType, BackgroundMaskType, OutputImageType> GraphCutFilterType;
+
+    OutputImageType::Pointer rasterResult;
+    OutputImageType::Pointer brickResult;
+    for (int pass = 0; pass < 2; ++pass) {
+        bool brick = pass == 1;
+        if ((brick && brickSize == 0) || (!brick && !runRaster)) {
+            continue;
+        }
+
+        itk::TimeProbe probe;
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            GraphCutFilterType::Pointer graphCutFilter = GraphCutFilterType::New();
+            graphCutFilter->SetInputImage(reader->GetOutput());
+            graphCutFilter->SetForegroundImage(foregroundMaskReader->GetOutput());
+            graphCutFilter->SetBackgroundImage(backgroundMaskReader->GetOutput());
+            graphCutFilter->SetSigma(sigma);
+            if (brick) {
+                graphCutFilter->SetNodeOrderToBrick();
+                graphCutFilter->SetBrickSize(brickSize);
+            }
+
+            probe.Start();
+            graphCutFilter->Update();
+            probe.Stop();
+
+            (brick ? brickResult : rasterResult) = graphCutFilter->GetOutput();
+        }
+
+        std::cout << (brick ? "brick order (" : "raster order");
+        if (brick) {
+            std::cout << brickSize << "^3)";
+        }
+        std::cout << ": " << probe.GetMean() << " " << probe.GetUnit() << " per segmentation" << std::endl;
+    }
+
+    // both orders describe the same graph
+    if (rasterResult && brickResult) {
+        itk::ImageRegionConstIterator<OutputImageType> rasterIterator(rasterResult, rasterResult->GetLargestPossibleRegion());
+        itk::ImageRegionConstIterator<OutputImageType> brickIterator(brickResult, brickResult->GetLargestPossibleRegion());
+        unsigned long differences = 0;
+        for (; !rasterIterator.IsAtEnd(); ++rasterIterator, ++brickIterator) {
+            differences += rasterIterator.Get() != brickIterator.Get();
+        }
+        std::cout << "Voxels labelled differently: " << differences << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#include "ImageGraphCut3DOutOfCoreSegmentation.h"
+
+/** This example segments an image which does not need to fit into memory and writes the segmentation mask to a file.
+* The images are streamed from and to disk, so they should be MetaImages (.mhd) or another format which ITK can read
+* and write partially.
+*/
+int main(int argc, char *argv[]) {
+    // Verify arguments
+    if (argc != 9) {
+        std::cerr << "Required: image.mhd foregroundMask.mhd backgroundMask.mhd output.mhd sigma boundaryDirection memoryBudget scratchDirectory" << std::endl;
+        std::cerr << "image.mhd:           3D image in Hounsfield Units -1024 to 3071" << std::endl;
+        std::cerr << "foregroundMask.mhd:  3D image non-zero pixels indicating foreground and 0 elsewhere" << std::endl;
+        std::cerr << "backgroundMask.mhd:  3D image non-zero pixels indicating background and 0 elsewhere" << std::endl;
+        std::cerr << "output.mhd:          3D image resulting segmentation" << std::endl;
+        std::cerr << "                     Foreground as 255 and Background as 0" << std::endl;
+        std::cerr << "sigma                estimated noise in boundary term, try 50.0" << std::endl;
+        std::cerr << "boundaryDirection    0->bidirectional; 1->bright to dark; 2->dark to bright" << std::endl;
+        std::cerr << "memoryBudget         memory for the solver in megabytes" << std::endl;
+        std::cerr << "scratchDirectory     directory for the temporary solver files" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Parse arguments
+    std::string imageFilename = argv[1];
+    std::string foregroundFilename = argv[2];   // This image should have non-zero pixels indicating foreground pixels and 0 elsewhere.
+    std::string backgroundFilename = argv[3];   // This image should have non-zero pixels indicating background pixels and 0 elsewhere.
+    std::string outputFilename = argv[4];
+    double sigma = atof(argv[5]);               // Noise parameter
+    int boundaryDirection = atoi(argv[6]);      // 0->bidirectional; 1->bright to dark; 2->dark to bright
+    std::size_t memoryBudget = atol(argv[7]);   // in megabytes
+    std::string scratchDirectory = argv[8];
+
+    // Print arguments
+    std::cout << "imageFilename: " << imageFilename << std::endl
+            << "foregroundFilename: " << foregroundFilename << std::endl
+            << "backgroundFilename: " << backgroundFilename << std::endl
+            << "outputFilename: " << outputFilename << std::endl
+            << "sigma: " << sigma << std::endl
+            << "boundaryDirection: " << boundaryDirection << std::endl
+            << "memoryBudget: " << memoryBudget << " MB" << std::endl
+            << "scratchDirectory: " << scratchDirectory << std::endl;
+
+    // Define all image types
+    typedef itk::Image<short, 3> ImageType;
+    typedef itk::Image<unsigned char, 3> ForegroundMaskType;
+    typedef itk::Image<unsigned char, 3> BackgroundMaskType;
+    typedef itk::Image<unsigned char, 3> OutputImageType;
+
+    // Set up the graph cut
+    typedef itk::ImageGraphCut3DOutOfCoreSegmentation<ImageType, ForegroundMaskType, BackgroundMaskType, OutputImageType> GraphCutType;
+    GraphCutType::Pointer graphCut = GraphCutType::New();
+    graphCut->SetInputFileName(imageFilename);
+    graphCut->SetForegroundFileName(foregroundFilename);
+    graphCut->SetBackgroundFileName(backgroundFilename);
+    graphCut->SetOutputFileName(outputFilename);
+
+    // Set graph cut parameters
+    graphCut->SetVerboseOutput(true);
+    graphCut->SetSigma(sigma);
+    switch (boundaryDirection) {
+        case 1:
+            graphCut->SetBoundaryDirectionTypeToBrightDark();
+            break;
+        case 2:
+            graphCut->SetBoundaryDirectionTypeToDarkBright();
+            break;
+        default:
+            graphCut->SetBoundaryDirectionTypeToNoDirection();
+    }
+    graphCut->SetMemoryBudget(memoryBudget * 1024 * 1024);
+    graphCut->SetScratchDirectory(scratchDirectory);
+
+    // Define the color values of the output
+    graphCut->SetForegroundPixelValue(255);
+    graphCut->SetBackgroundPixelValue(0);
+
+    // Start the computation, the result is written block by block
+    std::cout << "*** Performing Graph Cut ***" << std::endl;
+    try {
+        graphCut->Update();
+    }
+    catch (itk::ExceptionObject &err) {
+        std::cerr << "ERROR: Exception caught during the graph cut" << std::endl;
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#include "ImageGraphCut3DKolmogorovFilter.hxx"
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkExtractImageFilter.h"
+#include "itkJoinSeriesImageFilter.h"
+#include "itkTimeProbe.h"
+
+/** This example segments the frames of a 4D series (e.g. cardiac or longitudinal scans) with the same seeds. The graph
+* is built for the first frame only, every following frame updates the capacities that changed and the solver continues
+* from the flow of the previous frame.
+*/
+int main(int argc, char *argv[]) {
+    // Verify arguments
+    if (argc < 6 || argc > 7) {
+        std::cerr << "Required: series foregroundMask backgroundMask output sigma [threshold]" << std::endl;
+        std::cerr << "series:              4D image, the frames along the 4th dimension" << std::endl;
+        std::cerr << "foregroundMask:      3D image non-zero pixels indicating foreground and 0 elsewhere" << std::endl;
+        std::cerr << "backgroundMask:      3D image non-zero pixels indicating background and 0 elsewhere" << std::endl;
+        std::cerr << "output:              4D image resulting segmentation" << std::endl;
+        std::cerr << "sigma                estimated noise in boundary term, try 50.0" << std::endl;
+        std::cerr << "threshold            capacity changes up to this are ignored between frames, default 0" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Parse arguments
+    std::string seriesFilename = argv[1];
+    std::string foregroundFilename = argv[2];
+    std::string backgroundFilename = argv[3];
+    std::string outputFilename = argv[4];
+    double sigma = atof(argv[5]);
+    double threshold = argc > 6 ? atof(argv[6]) : 0.0;
+
+    // Define all image types
+    typedef itk::Image<short, 4> SeriesType;
+    typedef itk::Image<short, 3> ImageType;
+    typedef itk::Image<unsigned char, 3> ForegroundMaskType;
+    typedef itk::Image<unsigned char, 3> BackgroundMaskType;
+    typedef itk::Image<unsigned char, 3> OutputImageType;
+    typedef itk::Image<unsigned char, 4> OutputSeriesType;
+
+    // Read the images
+    std::cout << "*** Reading images ***" << std::endl;
+    typedef itk::ImageFileReader<SeriesType> ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName(seriesFilename);
+    typedef itk::ImageFileReader<ForegroundMaskType> ForegroundMaskReaderType;
+    ForegroundMaskReaderType::Pointer foregroundMaskReader = ForegroundMaskReaderType::New();
+    foregroundMaskReader->SetFileName(foregroundFilename);
+    typedef itk::ImageFileReader<BackgroundMaskType> BackgroundMaskReaderType;
+    BackgroundMaskReaderType::Pointer backgroundMaskReader = BackgroundMaskReaderType::New();
+    backgroundMaskReader->SetFileName(backgroundFilename);
+    try {
+        reader->Update();
+        foregroundMaskReader->Update();
+        backgroundMaskReader->Update();
+    }
+    catch (itk::ExceptionObject &err) {
+        std::cerr << "ERROR: Exception caught while reading the images" << std::endl;
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // one frame after the other
+    SeriesType::RegionType seriesRegion = reader->GetOutput()->GetLargestPossibleRegion();
+    unsigned int numberOfFrames = seriesRegion.GetSize()[3];
+    SeriesType::RegionType frameRegion = seriesRegion;
+    frameRegion.SetSize(3, 0);
+
+    typedef itk::ExtractImageFilter<SeriesType, ImageType> ExtractFilterType;
+    ExtractFilterType::Pointer extractFilter = ExtractFilterType::New();
+    extractFilter->SetInput(reader->GetOutput());
+    extractFilter->SetDirectionCollapseToSubmatrix();
+
+    typedef itk::ImageGraphCut3DKolmogorovFilter<ImageType, ForegroundMaskType, BackgroundMaskType, OutputImageType> GraphCutFilterType;
+    GraphCutFilterType::Pointer graphCutFilter = GraphCutFilterType::New();
+    graphCutFilter->SetInputImage(extractFilter->GetOutput());
+    graphCutFilter->SetForegroundImage(foregroundMaskReader->GetOutput());
+    graphCutFilter->SetBackgroundImage(backgroundMaskReader->GetOutput());
+    graphCutFilter->SetSigma(sigma);
+    graphCutFilter->SetForegroundPixelValue(255);
+    graphCutFilter->SetBackgroundPixelValue(0);
+    graphCutFilter->SetWarmStart(true);
+    graphCutFilter->SetWarmStartThreshold(threshold);
+
+    typedef itk::JoinSeriesImageFilter<OutputImageType, OutputSeriesType> JoinFilterType;
+    JoinFilterType::Pointer joinFilter = JoinFilterType::New();
+    joinFilter->SetSpacing(reader->GetOutput()->GetSpacing()[3]);
+    joinFilter->SetOrigin(reader->GetOutput()->GetOrigin()[3]);
+
+    try {
+        for (unsigned int frame = 0; frame < numberOfFrames; ++frame) {
+            frameRegion.SetIndex(3, seriesRegion.GetIndex()[3] + frame);
+            extractFilter->SetExtractionRegion(frameRegion);
+
+            itk::TimeProbe probe;
+            probe.Start();
+            graphCutFilter->Update();
+            probe.Stop();
+
+            std::cout << "Frame " << frame << ": " << probe.GetTotal() << " " << probe.GetUnit();
+            if (graphCutFilter->WasWarmStarted()) {
+                std::cout << ", warm start with " << graphCutFilter->GetNumberOfUpdatedCapacities() << " updated capacities";
+            }
+            std::cout << std::endl;
+
+            // the filter creates a new output for the next frame
+            OutputImageType::Pointer segmentation = graphCutFilter->GetOutput();
+            segmentation->DisconnectPipeline();
+            joinFilter->SetInput(frame, segmentation);
+        }
+    }
+    catch (itk::ExceptionObject &err) {
+        std::cerr << "ERROR: Exception caught while segmenting the series" << std::endl;
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Write output
+    std::cout << "*** Writing Result ***" << std::endl;
+    typedef itk::ImageFileWriter<OutputSeriesType> WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName(outputFilename);
+    writer->SetInput(joinFilter->GetOutput());
+    try {
+        writer->Update();
+        std::cout << "*** Done! ***" << std::endl;
+    }
+    catch (itk::ExceptionObject &err) {
+        std::cerr << "ERROR: Exception caught while writing the segmentation" << std::endl;
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
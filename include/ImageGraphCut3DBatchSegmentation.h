@@ -0,0 +1,221 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DBatchSegmentation_h_
+#define __ImageGraphCut3DBatchSegmentation_h_
+
+// ITK
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkTimeProbe.h"
+#include "itkTimeProbesCollectorBase.h"
+
+#include "ImageGraphCut3DKolmogorovFilter.hxx"
+
+// STL
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace itk {
+    //! Segments many independent cases concurrently
+    /*
+     * Every job names its image, masks and output file and carries its own parameters. Update() runs the jobs on a pool
+     * of threads; each thread owns one ImageGraphCut3DKolmogorovFilter for the lifetime of this object. The filter
+     * recycles its graph for every image that fits into it, so after the first jobs a thread segments without
+     * allocating solver memory and the threads do not compete for the allocator.
+     *
+     * In pipelined mode the jobs run in order through four stages instead, each on its own thread and connected by
+     * queues of one job: reading job N+2, building the graph of job N+1, solving job N (and querying its labels) and
+     * writing job N-1 overlap. This hides the file I/O behind the graph cut on I/O bound machines. Three filters, i.e.
+     * graphs, are in use at a time.
+     *
+     * A failing job does not stop the batch, its error is reported in the job's result.
+     */
+    template<typename TInput, typename TForeground, typename TBackground, typename TOutput>
+    class ImageGraphCut3DBatchSegmentation : public Object {
+    public:
+        // ITK related defaults
+        typedef ImageGraphCut3DBatchSegmentation Self;
+        typedef Object Superclass;
+        typedef SmartPointer<Self> Pointer;
+        typedef SmartPointer<const Self> ConstPointer;
+
+        itkNewMacro(Self);
+        itkTypeMacro(ImageGraphCut3DBatchSegmentation, Object);
+
+        // image types
+        typedef TInput InputImageType;
+        typedef TForeground ForegroundImageType;
+        typedef TBackground BackgroundImageType;
+        typedef TOutput OutputImageType;
+
+        typedef ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> FilterType;
+        typedef typename FilterType::BoundaryDirectionType BoundaryDirectionType;
+
+        struct Job {
+            std::string inputFileName;
+            std::string foregroundFileName;
+            std::string backgroundFileName;
+            std::string outputFileName;
+            double sigma;
+            BoundaryDirectionType boundaryDirection;
+        };
+
+        struct JobResult {
+            bool succeeded;
+            std::string errorMessage;
+            double seconds;         // reading, segmenting and writing
+            unsigned int thread;
+        };
+
+        // jobs
+        void AddJob(const Job &job) {
+            m_Jobs.push_back(job);
+        }
+
+        void AddJob(const std::string &inputFileName, const std::string &foregroundFileName,
+                    const std::string &backgroundFileName, const std::string &outputFileName, double sigma,
+                    BoundaryDirectionType boundaryDirection = FilterType::NoDirection) {
+            Job job = {inputFileName, foregroundFileName, backgroundFileName, outputFileName, sigma, boundaryDirection};
+            AddJob(job);
+        }
+
+        void ClearJobs() {
+            m_Jobs.clear();
+            m_Results.clear();
+        }
+
+        unsigned int GetNumberOfJobs() const {
+            return m_Jobs.size();
+        }
+
+        // parameter setters
+        // 0 uses one thread per core
+        void SetNumberOfThreads(unsigned int n) {
+            m_NumberOfThreads = n;
+        }
+
+        void SetForegroundPixelValue(typename OutputImageType::PixelType v) {
+            m_ForegroundPixelValue = v;
+        }
+
+        void SetBackgroundPixelValue(typename OutputImageType::PixelType v) {
+            m_BackgroundPixelValue = v;
+        }
+
+        // overlap the stages of consecutive jobs instead of running whole jobs in parallel, see above
+        void SetPipelined(bool b) {
+            m_Pipelined = b;
+        }
+
+        void SetVerboseOutput(bool b) {
+            m_PrintTimer = b;
+        }
+
+        // runs all jobs and returns when they are done
+        void Update();
+
+        // results of the last Update(), in the order of the jobs
+        const JobResult &GetJobResult(unsigned int i) const {
+            return m_Results[i];
+        }
+
+        unsigned int GetNumberOfFailedJobs() const;
+
+    protected:
+        ImageGraphCut3DBatchSegmentation();
+
+        virtual ~ImageGraphCut3DBatchSegmentation();
+
+        // reads, segments and writes one job with the filter of the calling thread
+        void RunJob(FilterType *filter, const Job &job, JobResult &result);
+
+        // a job between the stages of the pipeline
+        struct Case {
+            unsigned int job;       // m_Jobs.size() ends the pipeline
+            typename InputImageType::Pointer input;
+            typename ForegroundImageType::Pointer foreground;
+            typename BackgroundImageType::Pointer background;
+            typename FilterType::Pointer filter;
+            typename OutputImageType::Pointer output;
+            TimeProbe probe;
+        };
+
+        // blocking queue with a fixed capacity between two stages
+        template<typename T>
+        class BoundedQueue {
+        public:
+            BoundedQueue(std::size_t capacity) : m_Capacity(capacity) {}
+
+            void Push(const T &item) {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_NotFull.wait(lock, [this]() { return m_Items.size() < m_Capacity; });
+                m_Items.push_back(item);
+                m_NotEmpty.notify_one();
+            }
+
+            T Pop() {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_NotEmpty.wait(lock, [this]() { return !m_Items.empty(); });
+                T item = m_Items.front();
+                m_Items.pop_front();
+                m_NotFull.notify_one();
+                return item;
+            }
+
+        private:
+            std::size_t m_Capacity;
+            std::deque<T> m_Items;
+            std::mutex m_Mutex;
+            std::condition_variable m_NotEmpty;
+            std::condition_variable m_NotFull;
+        };
+
+        typedef std::shared_ptr<Case> CasePointer;
+
+        void UpdatePipelined();
+
+        // the stages of the pipeline, every case is passed on even if it failed
+        void ReadCase(Case &c, TimeProbesCollectorBase &timer);
+
+        void BuildCase(Case &c, TimeProbesCollectorBase &timer);
+
+        void SolveCase(Case &c, TimeProbesCollectorBase &timer);
+
+        void WriteCase(Case &c, TimeProbesCollectorBase &timer);
+
+        void FailCase(Case &c, const std::string &errorMessage);
+
+        std::vector<Job> m_Jobs;
+        std::vector<JobResult> m_Results;
+        std::vector<typename FilterType::Pointer> m_Filters;    // one per thread, kept between updates
+
+        unsigned int m_NumberOfThreads;
+        bool m_Pipelined;
+        typename OutputImageType::PixelType m_ForegroundPixelValue;
+        typename OutputImageType::PixelType m_BackgroundPixelValue;
+        bool m_PrintTimer;
+
+    private:
+        ImageGraphCut3DBatchSegmentation(const Self &); // intentionally not implemented
+        void operator=(const Self &); // intentionally not implemented
+    };
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+
+#include "ImageGraphCut3DBatchSegmentation.hxx"
+
+#endif
+
+#endif //__ImageGraphCut3DBatchSegmentation_h_
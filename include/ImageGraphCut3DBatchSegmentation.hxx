@@ -0,0 +1,371 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DBatchSegmentation_hxx_
+#define __ImageGraphCut3DBatchSegmentation_hxx_
+
+#include "ImageGraphCut3DBatchSegmentation.h"
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace itk {
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::ImageGraphCut3DBatchSegmentation()
+            : m_NumberOfThreads(0),
+              m_Pipelined(false),
+              m_ForegroundPixelValue(255),
+              m_BackgroundPixelValue(0),
+              m_PrintTimer(false) {
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::~ImageGraphCut3DBatchSegmentation() {
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::Update() {
+        JobResult notRun = {false, "not run", 0, 0};
+        m_Results.assign(m_Jobs.size(), notRun);
+        if (m_Jobs.empty()) {
+            return;
+        }
+        if (m_Pipelined) {
+            UpdatePipelined();
+            return;
+        }
+
+        unsigned int numberOfThreads = m_NumberOfThreads;
+        if (numberOfThreads == 0) {
+            numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        numberOfThreads = std::min<unsigned int>(numberOfThreads, m_Jobs.size());
+
+        // the filters, and with them the graphs, are created once per thread
+        while (m_Filters.size() < numberOfThreads) {
+            m_Filters.push_back(FilterType::New());
+        }
+
+        // every thread keeps taking the next job until none are left, so long jobs do not hold up the others
+        std::atomic<unsigned int> nextJob(0);
+        auto worker = [&](unsigned int thread) {
+            for (unsigned int i = nextJob++; i < m_Jobs.size(); i = nextJob++) {
+                m_Results[i].thread = thread;
+                RunJob(m_Filters[thread].GetPointer(), m_Jobs[i], m_Results[i]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int iThread = 1; iThread < numberOfThreads; ++iThread) {
+            threads.push_back(std::thread(worker, iThread));
+        }
+        worker(0);
+        for (unsigned int iThread = 0; iThread < threads.size(); ++iThread) {
+            threads[iThread].join();
+        }
+
+        if (m_PrintTimer) {
+            for (unsigned int i = 0; i < m_Results.size(); ++i) {
+                std::cout << m_Jobs[i].inputFileName << ": thread " << m_Results[i].thread << ", "
+                          << m_Results[i].seconds << " s";
+                if (!m_Results[i].succeeded) {
+                    std::cout << ", failed: " << m_Results[i].errorMessage;
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::UpdatePipelined() {
+        // the stage building a graph, the one in the queue to the solver and the solving one each hold a filter
+        BoundedQueue<typename FilterType::Pointer> freeFilters(3);
+        while (m_Filters.size() < 3) {
+            m_Filters.push_back(FilterType::New());
+        }
+        for (unsigned int i = 0; i < 3; ++i) {
+            freeFilters.Push(m_Filters[i]);
+        }
+
+        BoundedQueue<CasePointer> readQueue(1);
+        BoundedQueue<CasePointer> buildQueue(1);
+        BoundedQueue<CasePointer> solveQueue(1);
+
+        // one timer per stage, probes which are not thread safe are never shared
+        TimeProbesCollectorBase readTimer, buildTimer, solveTimer, writeTimer;
+
+        std::thread reader([&]() {
+            for (unsigned int i = 0; i <= m_Jobs.size(); ++i) {
+                CasePointer c = std::make_shared<Case>();
+                c->job = i;
+                if (i < m_Jobs.size()) {
+                    c->probe.Start();
+                    ReadCase(*c, readTimer);
+                }
+                readQueue.Push(c);
+            }
+        });
+
+        std::thread builder([&]() {
+            for (CasePointer c = readQueue.Pop(); ; c = readQueue.Pop()) {
+                if (c->job < m_Jobs.size() && m_Results[c->job].succeeded) {
+                    c->filter = freeFilters.Pop();
+                    BuildCase(*c, buildTimer);
+                }
+                buildQueue.Push(c);
+                if (c->job == m_Jobs.size()) {
+                    break;
+                }
+            }
+        });
+
+        std::thread solver([&]() {
+            for (CasePointer c = buildQueue.Pop(); ; c = buildQueue.Pop()) {
+                if (c->filter) {
+                    if (m_Results[c->job].succeeded) {
+                        SolveCase(*c, solveTimer);
+                    }
+                    freeFilters.Push(c->filter);
+                    c->filter = NULL;
+                }
+                solveQueue.Push(c);
+                if (c->job == m_Jobs.size()) {
+                    break;
+                }
+            }
+        });
+
+        // the calling thread writes
+        for (CasePointer c = solveQueue.Pop(); c->job < m_Jobs.size(); c = solveQueue.Pop()) {
+            if (m_Results[c->job].succeeded) {
+                WriteCase(*c, writeTimer);
+            }
+            c->probe.Stop();
+            m_Results[c->job].seconds = c->probe.GetTotal();
+        }
+
+        reader.join();
+        builder.join();
+        solver.join();
+
+        if (m_PrintTimer) {
+            readTimer.Report(std::cout);
+            buildTimer.Report(std::cout);
+            solveTimer.Report(std::cout);
+            writeTimer.Report(std::cout);
+            for (unsigned int i = 0; i < m_Results.size(); ++i) {
+                if (!m_Results[i].succeeded) {
+                    std::cout << m_Jobs[i].inputFileName << " failed: " << m_Results[i].errorMessage << std::endl;
+                }
+            }
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::ReadCase(Case &c, TimeProbesCollectorBase &timer) {
+        const Job &job = m_Jobs[c.job];
+        timer.Start("Read");
+        try {
+            typename ImageFileReader<InputImageType>::Pointer inputReader = ImageFileReader<InputImageType>::New();
+            inputReader->SetFileName(job.inputFileName);
+            inputReader->Update();
+            c.input = inputReader->GetOutput();
+            c.input->DisconnectPipeline();
+
+            typename ImageFileReader<ForegroundImageType>::Pointer foregroundReader = ImageFileReader<ForegroundImageType>::New();
+            foregroundReader->SetFileName(job.foregroundFileName);
+            foregroundReader->Update();
+            c.foreground = foregroundReader->GetOutput();
+            c.foreground->DisconnectPipeline();
+
+            typename ImageFileReader<BackgroundImageType>::Pointer backgroundReader = ImageFileReader<BackgroundImageType>::New();
+            backgroundReader->SetFileName(job.backgroundFileName);
+            backgroundReader->Update();
+            c.background = backgroundReader->GetOutput();
+            c.background->DisconnectPipeline();
+
+            m_Results[c.job].succeeded = true;
+            m_Results[c.job].errorMessage.clear();
+        }
+        catch (ExceptionObject &err) {
+            FailCase(c, err.GetDescription());
+        }
+        catch (std::exception &e) {
+            FailCase(c, e.what());
+        }
+        timer.Stop("Read");
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::BuildCase(Case &c, TimeProbesCollectorBase &timer) {
+        const Job &job = m_Jobs[c.job];
+        FilterType *filter = c.filter.GetPointer();
+        try {
+            filter->SetInputImage(c.input);
+            filter->SetForegroundImage(c.foreground);
+            filter->SetBackgroundImage(c.background);
+            filter->SetSigma(job.sigma);
+            if (job.boundaryDirection == FilterType::BrightDark) {
+                filter->SetBoundaryDirectionTypeToBrightDark();
+            } else if (job.boundaryDirection == FilterType::DarkBright) {
+                filter->SetBoundaryDirectionTypeToDarkBright();
+            } else {
+                filter->SetBoundaryDirectionTypeToNoDirection();
+            }
+            filter->SetForegroundPixelValue(m_ForegroundPixelValue);
+            filter->SetBackgroundPixelValue(m_BackgroundPixelValue);
+
+            // what Update() would do before GenerateData()
+            filter->UpdateOutputInformation();
+            filter->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+            filter->RunGraphInit(timer);
+        }
+        catch (ExceptionObject &err) {
+            FailCase(c, err.GetDescription());
+        }
+        catch (std::exception &e) {
+            FailCase(c, e.what());
+        }
+        c.input = NULL;
+        c.foreground = NULL;
+        c.background = NULL;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::SolveCase(Case &c, TimeProbesCollectorBase &timer) {
+        FilterType *filter = c.filter.GetPointer();
+        try {
+            filter->RunGraphCut(timer);
+            filter->RunQueryResults(timer);
+
+            // the filter creates a new output for its next job
+            c.output = filter->GetOutput();
+            c.output->DisconnectPipeline();
+        }
+        catch (ExceptionObject &err) {
+            FailCase(c, err.GetDescription());
+        }
+        catch (std::exception &e) {
+            FailCase(c, e.what());
+        }
+        filter->SetInputImage(NULL);
+        filter->SetForegroundImage(NULL);
+        filter->SetBackgroundImage(NULL);
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::WriteCase(Case &c, TimeProbesCollectorBase &timer) {
+        timer.Start("Write");
+        try {
+            typename ImageFileWriter<OutputImageType>::Pointer writer = ImageFileWriter<OutputImageType>::New();
+            writer->SetFileName(m_Jobs[c.job].outputFileName);
+            writer->SetInput(c.output);
+            writer->Update();
+        }
+        catch (ExceptionObject &err) {
+            FailCase(c, err.GetDescription());
+        }
+        catch (std::exception &e) {
+            FailCase(c, e.what());
+        }
+        timer.Stop("Write");
+        c.output = NULL;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::FailCase(Case &c, const std::string &errorMessage) {
+        m_Results[c.job].succeeded = false;
+        m_Results[c.job].errorMessage = errorMessage;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    unsigned int ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::GetNumberOfFailedJobs() const {
+        unsigned int numberOfFailedJobs = 0;
+        for (unsigned int i = 0; i < m_Results.size(); ++i) {
+            numberOfFailedJobs += !m_Results[i].succeeded;
+        }
+        return numberOfFailedJobs;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DBatchSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::RunJob(FilterType *filter, const Job &job, JobResult &result) {
+        typedef ImageFileReader<InputImageType> InputReaderType;
+        typedef ImageFileReader<ForegroundImageType> ForegroundReaderType;
+        typedef ImageFileReader<BackgroundImageType> BackgroundReaderType;
+        typedef ImageFileWriter<OutputImageType> WriterType;
+
+        TimeProbe probe;
+        probe.Start();
+        try {
+            typename InputReaderType::Pointer inputReader = InputReaderType::New();
+            inputReader->SetFileName(job.inputFileName);
+            typename ForegroundReaderType::Pointer foregroundReader = ForegroundReaderType::New();
+            foregroundReader->SetFileName(job.foregroundFileName);
+            typename BackgroundReaderType::Pointer backgroundReader = BackgroundReaderType::New();
+            backgroundReader->SetFileName(job.backgroundFileName);
+
+            filter->SetInputImage(inputReader->GetOutput());
+            filter->SetForegroundImage(foregroundReader->GetOutput());
+            filter->SetBackgroundImage(backgroundReader->GetOutput());
+            filter->SetSigma(job.sigma);
+            if (job.boundaryDirection == FilterType::BrightDark) {
+                filter->SetBoundaryDirectionTypeToBrightDark();
+            } else if (job.boundaryDirection == FilterType::DarkBright) {
+                filter->SetBoundaryDirectionTypeToDarkBright();
+            } else {
+                filter->SetBoundaryDirectionTypeToNoDirection();
+            }
+            filter->SetForegroundPixelValue(m_ForegroundPixelValue);
+            filter->SetBackgroundPixelValue(m_BackgroundPixelValue);
+
+            typename WriterType::Pointer writer = WriterType::New();
+            writer->SetFileName(job.outputFileName);
+            writer->SetInput(filter->GetOutput());
+            writer->Update();
+
+            result.succeeded = true;
+            result.errorMessage.clear();
+        }
+        catch (ExceptionObject &err) {
+            result.succeeded = false;
+            result.errorMessage = err.GetDescription();
+        }
+        catch (std::exception &e) {
+            result.succeeded = false;
+            result.errorMessage = e.what();
+        }
+        probe.Stop();
+        result.seconds = probe.GetTotal();
+
+        // release the images of this job, the graph stays for the next one
+        filter->SetInputImage(NULL);
+        filter->SetForegroundImage(NULL);
+        filter->SetBackgroundImage(NULL);
+        filter->GetOutput()->Initialize();
+    }
+} // namespace itk
+
+#endif //__ImageGraphCut3DBatchSegmentation_hxx_
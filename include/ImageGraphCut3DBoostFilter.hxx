@@ -10,16 +10,13 @@
 #ifndef __ImageGraphCut3DBoostFilter_h_
 #define __ImageGraphCut3DBoostFilter_h_
 
-#include <boost/assign/list_of.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/boykov_kolmogorov_max_flow.hpp>
-
-#include "ImageImageGraphCut3DKolmogorovBoostBase.h"
+#include "MaxFlowGraphBoost.hxx"
+#include "ImageGraphCut3DKolmogorovBoostBase.h"
 /*
- * Wraps kolmogorovs graph library
+ * Wraps boosts graph library
  */
 namespace itk{
-    //! GraphCut solver using boosts maxflow implementation
+    //! GraphCut solver using boosts maxflow implementation on a compressed sparse row graph
 	template<typename TInput, typename TForeground, typename TBackground, typename TOutput>
 	class ImageGraphCut3DBoostFilter : public ImageGraphCut3DKolmogorovBoostBase<TInput, TForeground, TBackground, TOutput>{
 	public:
@@ -42,14 +39,9 @@ namespace itk{
 
         typedef typename SuperClass::ImageContainer ImageContainer;
 
+        typedef MaxFlowGraphBoost GraphType;
 
-        typedef boost::adjacency_list<boost::listS, boost::vecS, boost::directedS,
-                boost::no_property,
-                boost::property<boost::edge_index_t, std::size_t> > GraphType;
-
-        typedef boost::graph_traits<GraphType>::edge_descriptor EdgeDescriptor;
-
-        virtual void InitializeGraph(const ImageContainer)
+        virtual void InitializeGraph(const ImageContainer) override
         {
             typename InputImageType::SizeType dimensions;
             dimensions = this->GetInputImage()->GetLargestPossibleRegion().GetSize();
@@ -58,69 +50,46 @@ namespace itk{
             int numberOfEdges = calculateNumberOfEdges(dimensions[0], dimensions[1], dimensions[2]);
 
             std::cout << "Number of vertices: " << numberOfVertices << ", number of edges: " << numberOfEdges << std::endl;
-            m_Graph = GraphType(numberOfVertices);
-            SOURCE = numberOfVertices - 2;
-            SINK = numberOfVertices - 1;
-            //m_Graph(numberOfVertices);
-            groups.resize(numberOfVertices);
+
+            // source and sink are added behind the image vertices
+            delete m_Graph;
+            m_Graph = new GraphType(dimensions[0], dimensions[1], dimensions[2]);
         }
 
 
         // boykov_kolmogorov_max_flow requires all edges to have a reverse edge.
-        virtual inline void addBidirectionalEdge(const unsigned int source, const unsigned int target, const float weight, const float reverseWeight){
-            // tracking the currentEdgeIndex manually instead of getting it via boost:num_edges(graph) results in a massive
-            // speedup: http://stackoverflow.com/questions/7890857/boost-graph-library-edge-insertion-slow-for-large-graph
-
-            // create both edges
-            EdgeDescriptor edge = boost::add_edge(source, target, ++currentEdgeIndex, *m_Graph).first;
-            EdgeDescriptor reverseEdge = boost::add_edge(target, source, ++currentEdgeIndex, *m_Graph).first;
-
-            // add them to out property maps
-            reverseEdges.push_back(reverseEdge);
-            reverseEdges.push_back(edge);
-            capacity.push_back(weight);
-            capacity.push_back(weight);
+        virtual inline void addBidirectionalEdge(const unsigned int source, const unsigned int target, const float weight, const float reverseWeight) override {
+            m_Graph->addBidirectionalEdge(source, target, weight, reverseWeight);
         }
 
-        virtual inline void addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight){
-            addBidirectionalEdge(node, SOURCE, sourceWeight, sinkWeight);
-            addBidirectionalEdge(node, SINK, sinkWeight, sinkWeight);
+        virtual inline void addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight) override {
+            m_Graph->addTerminalEdges(node, sourceWeight, sinkWeight);
         }
 
         // start the calculation
-        virtual void SolveGraph(){
-            std::vector<float> residualCapacity(getNumberOfEdges(), 0);
-
-            // max flow
-            boost::boykov_kolmogorov_max_flow(*m_Graph
-                    , boost::make_iterator_property_map(&capacity.front(), boost::get(boost::edge_index, *m_Graph))
-                    , boost::make_iterator_property_map(&residualCapacity.front(), boost::get(boost::edge_index, *m_Graph))
-                    , boost::make_iterator_property_map(&reverseEdges.front(), boost::get(boost::edge_index, *m_Graph))
-                    , boost::make_iterator_property_map(&groups.front(), boost::get(boost::vertex_index, *m_Graph))
-                    , boost::get(boost::vertex_index, *m_Graph)
-                    , SOURCE
-                    , SINK);
+        virtual void SolveGraph() override {
+            m_Graph->calculateMaxFlow();
         }
 
         // query the resulting segmentation group of a vertex.
-        virtual int inline groupOf(const unsigned int vertex) const{
-            return groups.at(vertex);
+        virtual int inline groupOf(const unsigned int vertex) const override {
+            return m_Graph->groupOf(vertex);
         }
 
-        virtual int groupOfSource(){
-            return groupOf(SOURCE);
+        virtual int groupOfSource() override {
+            return m_Graph->groupOfSource();
         }
 
-        virtual int groupOfSink(){
-            return groupOf(SINK);
+        virtual int groupOfSink() override {
+            return m_Graph->groupOfSink();
         }
 
-        virtual unsigned int getNumberOfVertices(){
-            return boost::num_vertices(*m_Graph) - 2;
+        virtual unsigned int getNumberOfVertices() override {
+            return m_Graph->getNumberOfVertices();
         }
 
-        virtual unsigned int getNumberOfEdges(){
-            return boost::num_edges(*m_Graph);
+        virtual unsigned int getNumberOfEdges() override {
+            return m_Graph->getNumberOfEdges();
         }
 
 
@@ -133,17 +102,8 @@ namespace itk{
         }
 
 	protected:
-        unsigned int SOURCE;
-        unsigned int SINK;
-        long currentEdgeIndex;
-
-        std::vector<EdgeDescriptor> reverseEdges;
-        std::vector<WeightType> capacity;
-        std::vector<int> groups;
-
-        ImageGraphCut3DBoostFilter(): currentEdgeIndex(-1), reverseEdges() , capacity()
+        ImageGraphCut3DBoostFilter() : m_Graph(NULL)
         {
-           m_Graph = new GraphType();
         };
 
         virtual ~ImageGraphCut3DBoostFilter(){
@@ -16,12 +16,12 @@
 #include <itkImageRegionIteratorWithIndex.h>
 #include "itkShapedNeighborhoodIterator.h"
 #include "itkImage.h"
-#include "itkSampleToHistogramFilter.h"
-#include "itkHistogram.h"
-#include "itkListSample.h"
+#include "itkVectorImage.h"
 #include "itkProgressReporter.h"
+#include "itkTimeProbesCollectorBase.h"
 
 // STL
+#include <algorithm>
 #include <vector>
 
 namespace itk {
@@ -44,8 +44,9 @@ namespace itk {
         typedef TForeground ForegroundImageType;
         typedef TBackground BackgroundImageType;
         typedef TOutput OutputImageType;
+        typedef Image<float, 3> CostImageType;
+        typedef VectorImage<float, 3> BoundaryWeightImageType;
 
-        typedef itk::Statistics::Histogram<short, itk::Statistics::DenseFrequencyContainer2> HistogramType;
         typedef std::vector<itk::Index<3> > IndexContainerType;     // container for sinks / sources
         typedef float WeightType;
 
@@ -53,11 +54,26 @@ namespace itk {
             NoDirection, BrightDark, DarkBright
         } BoundaryDirectionType;
 
+        typedef enum {
+            RasterOrder, BrickOrder
+        } NodeOrderType;
+
         // parameter setters
         void SetSigma(double d) {
             m_Sigma = d;
         }
 
+        // weight of the regional term against the boundary term, 0 (the default) uses the seeds only. The regional term
+        // is the negative log-likelihood of a voxel's intensity under the intensity histograms of the foreground and
+        // background seeds (Boykov & Jolly, ICCV 2001).
+        void SetLambda(double d) {
+            m_Lambda = d;
+        }
+
+        void SetNumberOfHistogramBins(int n) {
+            m_NumberOfHistogramBins = n;
+        }
+
         void SetBoundaryDirectionTypeToNoDirection() {
             m_BoundaryDirectionType = NoDirection;
         }
@@ -78,6 +94,21 @@ namespace itk {
             m_BackgroundPixelValue = v;
         }
 
+        // numbering of the voxels in the graph. RasterOrder follows the image buffer, BrickOrder numbers the voxels of
+        // each brick of BrickSize^3 voxels consecutively, which keeps the z-neighbors of a voxel close in the solver's
+        // node array. Solvers working on the image grid directly (GridCut) ignore it.
+        void SetNodeOrderToRaster() {
+            m_NodeOrder = RasterOrder;
+        }
+
+        void SetNodeOrderToBrick() {
+            m_NodeOrder = BrickOrder;
+        }
+
+        void SetBrickSize(unsigned int s) {
+            m_BrickSize = s;
+        }
+
         // image setters
         void SetInputImage(const InputImageType *image) {
             this->SetNthInput(0, const_cast<InputImageType *>(image));
@@ -91,22 +122,52 @@ namespace itk {
             this->SetNthInput(2, const_cast<BackgroundImageType *>(image));
         }
 
+        // optional terminal capacities of every voxel, e.g. from a classifier. The source cost is paid if a voxel is
+        // labeled background, the sink cost if it is labeled foreground. They are added to the regional term and the
+        // seeds and must have the size of the input image.
+        void SetSourceCostImage(const CostImageType *image) {
+            this->SetNthInput(3, const_cast<CostImageType *>(image));
+        }
+
+        void SetSinkCostImage(const CostImageType *image) {
+            this->SetNthInput(4, const_cast<CostImageType *>(image));
+        }
+
+        // optional precomputed boundary weights in [0, 1] replacing the intensity differences and sigma, e.g. from a
+        // gradient or sheetness map. With one component the weight of an edge is the mean of its two voxels. With three
+        // components, component d of a voxel is the weight of the edge to its neighbor at +1 along dimension d. The
+        // boundary direction applies as with the computed weights. Must have the size of the input image.
+        void SetBoundaryWeightImage(const BoundaryWeightImageType *image) {
+            this->SetNthInput(5, const_cast<BoundaryWeightImageType *>(image));
+        }
+
 
         void SetVerboseOutput(bool b) {
             m_PrintTimer = b;
         }
+
+        // The steps of Update(), named after their timer probes, for drivers which overlap the steps of several images
+        // (see ImageGraphCut3DBatchSegmentation with SetPipelined(true)). They replace Update() and must be called in
+        // this order. The inputs must be up to date and the output information and requested region must be set.
+        void RunGraphInit(TimeProbesCollectorBase &timer);
+
+        void RunGraphCut(TimeProbesCollectorBase &timer);
+
+        void RunQueryResults(TimeProbesCollectorBase &timer);
     protected:
         struct ImageContainer {
             typename InputImageType::ConstPointer input;
             typename InputImageType::RegionType inputRegion;
             typename ForegroundImageType::ConstPointer foreground;
             typename BackgroundImageType::ConstPointer background;
+            typename CostImageType::ConstPointer sourceCost;    // may be null
+            typename CostImageType::ConstPointer sinkCost;      // may be null
+            typename BoundaryWeightImageType::ConstPointer boundaryWeights;     // may be null
             typename OutputImageType::Pointer output;
             typename InputImageType::RegionType outputRegion;
         };
-        typedef itk::Vector<typename InputImageType::PixelType, 1> ListSampleMeasurementVectorType;
-        typedef itk::Statistics::ListSample<ListSampleMeasurementVectorType> SampleType;
-        typedef itk::Statistics::SampleToHistogramFilter<SampleType, HistogramType> SampleToHistogramFilterType;
+        typedef typename InputImageType::PixelType InputPixelType;
+        typedef std::vector<SizeValueType> BinContainerType;
 
         ImageGraphCut3DFilter();
 
@@ -124,7 +185,7 @@ namespace itk {
         template<typename TIndexImage>
         std::vector<itk::Index<3> > getPixelsLargerThanZero(const TIndexImage *const) const;
 
-        // convert 3d itk indices to a continuously numbered indices
+        // convert 3d itk indices to a continuously numbered indices, in the order selected by SetNodeOrderTo...()
         unsigned int ConvertIndexToVertexDescriptor(const itk::Index<3>, typename InputImageType::RegionType);
 
         // image getters
@@ -140,14 +201,76 @@ namespace itk {
             return static_cast< const BackgroundImageType * >(this->ProcessObject::GetInput(2));
         }
 
+        const CostImageType *GetSourceCostImage() {
+            return static_cast< const CostImageType * >(this->ProcessObject::GetInput(3));
+        }
+
+        const CostImageType *GetSinkCostImage() {
+            return static_cast< const CostImageType * >(this->ProcessObject::GetInput(4));
+        }
+
+        const BoundaryWeightImageType *GetBoundaryWeightImage() {
+            return static_cast< const BoundaryWeightImageType * >(this->ProcessObject::GetInput(5));
+        }
+
+        // weight of the edge between a voxel, given by its offset in the buffer, and its neighbor at +1 along dimension
+        inline WeightType GetBoundaryWeight(const ImageContainer &images, SizeValueType voxel,
+                                            unsigned int dimension) const {
+            const float *weights = images.boundaryWeights->GetBufferPointer();
+            if (images.boundaryWeights->GetNumberOfComponentsPerPixel() == 3) {
+                return weights[3 * voxel + dimension];
+            }
+            typename InputImageType::SizeType size = images.inputRegion.GetSize();
+            SizeValueType stride = dimension == 0 ? 1 : (dimension == 1 ? size[0] : size[0] * size[1]);
+            return 0.5f * (weights[voxel] + weights[voxel + stride]);
+        }
+
+        // builds the seed histograms and the table of regional t-link weights, see SetLambda()
+        void ComputeRegionalTerm(const ImageContainer &images);
+
+        // counts the seed intensities in [minimum, maximum] in one pass over the images, split into slabs along z. Each
+        // thread counts into its own dense bins, which are summed up at the end.
+        void CountSeedIntensities(const ImageContainer &images, double minimum, double maximum, double binWidth,
+                                  unsigned int numberOfBins, BinContainerType &foregroundBins,
+                                  BinContainerType &backgroundBins);
+
+        // the terminal weights of the regional term for an intensity, called in the graph building sweep
+        inline bool HasRegionalTerm() const {
+            return !m_RegionalSourceWeights.empty();
+        }
+
+        inline void GetRegionalWeights(const InputPixelType pixel, WeightType &sourceWeight,
+                                       WeightType &sinkWeight) const {
+            unsigned int bin = m_RegionalSourceWeights.size() - 1;  // outside the seed intensities
+            if (pixel >= m_HistogramMinimum && pixel <= m_HistogramMaximum) {
+                bin = std::min<unsigned int>((unsigned int) ((pixel - m_HistogramMinimum) / m_HistogramBinWidth),
+                                             bin - 1);
+            }
+            sourceWeight = m_RegionalSourceWeights[bin];
+            sinkWeight = m_RegionalSinkWeights[bin];
+        }
+
         // parameters
         double m_Sigma;                     // noise in boundary term
-        int m_NumberOfHistogramBins;     // bins per dimension of histograms
+        double m_Lambda;                    // weight of the regional term
+        int m_NumberOfHistogramBins;        // bins of the seed histograms
         BoundaryDirectionType m_BoundaryDirectionType;
         typename OutputImageType::PixelType m_ForegroundPixelValue;
         typename OutputImageType::PixelType m_BackgroundPixelValue;
+        NodeOrderType m_NodeOrder;
+        unsigned int m_BrickSize;           // edge length of the bricks in voxels
         bool m_PrintTimer;
 
+        ImageContainer m_Images;            // between RunGraphInit() and RunQueryResults()
+        float m_InitProgressWeight;         // share of RunGraphInit() in the progress
+
+        // regional term, one bin more than the histograms for intensities outside of them
+        double m_HistogramMinimum;
+        double m_HistogramMaximum;
+        double m_HistogramBinWidth;
+        std::vector<WeightType> m_RegionalSourceWeights;   // -lambda * log P(intensity | background)
+        std::vector<WeightType> m_RegionalSinkWeights;     // -lambda * log P(intensity | foreground)
+
 
     private:
         ImageGraphCut3DFilter(const Self &); // intentionally not implemented
@@ -11,16 +11,31 @@
 #define __ImageGraphCut3DFilter_hxx_
 
 #include "itkTimeProbesCollectorBase.h"
+#include "itkMinimumMaximumImageCalculator.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
 
 namespace itk {
     template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
     ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
     ::ImageGraphCut3DFilter()
             : m_Sigma(5.0),
+              m_Lambda(0.0),
+              m_NumberOfHistogramBins(64),
               m_BoundaryDirectionType(NoDirection),
               m_ForegroundPixelValue(255),
               m_BackgroundPixelValue(0),
-              m_PrintTimer(false) {
+              m_NodeOrder(RasterOrder),
+              m_BrickSize(4),
+              m_PrintTimer(false),
+              m_InitProgressWeight(0.5f),
+              m_HistogramMinimum(0.0),
+              m_HistogramMaximum(0.0),
+              m_HistogramBinWidth(1.0) {
         this->SetNumberOfRequiredInputs(3);
     }
 
@@ -34,53 +49,256 @@ namespace itk {
     ::GenerateData() {
         itk::TimeProbesCollectorBase timer;
 
+        RunGraphInit(timer);
+        RunGraphCut(timer);
+        RunQueryResults(timer);
+
+        if (m_PrintTimer) {
+            timer.Report(std::cout);
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
+    ::RunGraphInit(TimeProbesCollectorBase &timer) {
+        if (m_NodeOrder == BrickOrder && m_BrickSize == 0) {
+            itkExceptionMacro(<< "The brick size must be positive");
+        }
+
         timer.Start("ITK init");
         // get all images
-        ImageContainer images;
-        images.input = GetInputImage();
-        images.inputRegion = images.input->GetLargestPossibleRegion();
-        images.foreground = GetForegroundImage();
-        images.background = GetBackgroundImage();
-        images.output = this->GetOutput();
-        images.outputRegion = images.output->GetRequestedRegion();
+        m_Images.input = GetInputImage();
+        m_Images.inputRegion = m_Images.input->GetLargestPossibleRegion();
+        m_Images.foreground = GetForegroundImage();
+        m_Images.background = GetBackgroundImage();
+        m_Images.sourceCost = GetSourceCostImage();
+        m_Images.sinkCost = GetSinkCostImage();
+        m_Images.boundaryWeights = GetBoundaryWeightImage();
+        m_Images.output = this->GetOutput();
+        m_Images.outputRegion = m_Images.output->GetRequestedRegion();
+
+        // the graph builders read the cost images as buffers in the order of the input voxels
+        const CostImageType *costImages[2] = {m_Images.sourceCost, m_Images.sinkCost};
+        for (unsigned int i = 0; i < 2; ++i) {
+            if (costImages[i] && costImages[i]->GetBufferedRegion().GetSize() != m_Images.inputRegion.GetSize()) {
+                itkExceptionMacro(<< "The cost images must be buffered with the size of the input image");
+            }
+        }
+        if (m_Images.boundaryWeights) {
+            if (m_Images.boundaryWeights->GetBufferedRegion().GetSize() != m_Images.inputRegion.GetSize()) {
+                itkExceptionMacro(<< "The boundary weight image must be buffered with the size of the input image");
+            }
+            unsigned int components = m_Images.boundaryWeights->GetNumberOfComponentsPerPixel();
+            if (components != 1 && components != 3) {
+                itkExceptionMacro(<< "The boundary weight image must have 1 or 3 components, not " << components);
+            }
+            // the integer capacities and the bound of the seeds assume an edge weight is at most one
+            const float *weights = m_Images.boundaryWeights->GetBufferPointer();
+            const std::size_t numberOfWeights = m_Images.inputRegion.GetNumberOfPixels() * components;
+            for (std::size_t i = 0; i < numberOfWeights; ++i) {
+                if (!(weights[i] >= 0 && weights[i] <= 1)) {
+                    itkExceptionMacro(<< "The boundary weights must be in [0, 1], not " << weights[i]);
+                }
+            }
+        }
 
         // init ITK progress reporter
         // InitializeGraph() traverses the input image once
-        int numberOfPixelDuringInit = images.inputRegion.GetNumberOfPixels();
+        int numberOfPixelDuringInit = m_Images.inputRegion.GetNumberOfPixels();
         // CutGraph() traverses the output image once
-        int numberOfPixelDuringOutput = images.outputRegion.GetNumberOfPixels();
-        // since both report to the same ProgressReporter, we add the total amount of pixels
-        ProgressReporter progress(this, 0, numberOfPixelDuringInit + numberOfPixelDuringOutput);
+        int numberOfPixelDuringOutput = m_Images.outputRegion.GetNumberOfPixels();
+        // both report to the same progress, each step with its share of the pixels
+        m_InitProgressWeight = (float) numberOfPixelDuringInit / (numberOfPixelDuringInit + numberOfPixelDuringOutput);
+        ProgressReporter progress(this, 0, numberOfPixelDuringInit, 100, 0.0f, m_InitProgressWeight);
 
         // allocate output
-        images.output->SetBufferedRegion(images.outputRegion);
-        images.output->Allocate();
-
-        // init samples and histogram
-        typename SampleType::Pointer foregroundSample = SampleType::New();
-        typename SampleType::Pointer backgroundSample = SampleType::New();
-        typename SampleToHistogramFilterType::Pointer foregroundHistogramFilter = SampleToHistogramFilterType::New();
-        typename SampleToHistogramFilterType::Pointer backgroundHistogramFilter = SampleToHistogramFilterType::New();
+        m_Images.output->SetBufferedRegion(m_Images.outputRegion);
+        m_Images.output->Allocate();
 
-        // get the total image size
         timer.Stop("ITK init");
 
+        // the regional weights are added in the graph building sweep
+        timer.Start("Histograms");
+        ComputeRegionalTerm(m_Images);
+        timer.Stop("Histograms");
+
         // create graph
         timer.Start("Graph init");
-        FillGraph(images, progress);
+        FillGraph(m_Images, progress);
         timer.Stop("Graph init");
+    }
 
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
+    ::RunGraphCut(TimeProbesCollectorBase &timer) {
         // cut graph
         timer.Start("Graph cut");
         SolveGraph();
         timer.Stop("Graph cut");
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
+    ::RunQueryResults(TimeProbesCollectorBase &timer) {
+        ProgressReporter progress(this, 0, m_Images.outputRegion.GetNumberOfPixels(), 100, m_InitProgressWeight,
+                                  1.0f - m_InitProgressWeight);
 
         timer.Start("Query results");
-        CutGraph(images, progress);
+        CutGraph(m_Images, progress);
         timer.Stop("Query results");
 
-        if (m_PrintTimer) {
-            timer.Report(std::cout);
+        // the images belong to the pipeline again
+        m_Images = ImageContainer();
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
+    ::ComputeRegionalTerm(const ImageContainer &images) {
+        m_RegionalSourceWeights.clear();
+        m_RegionalSinkWeights.clear();
+        if (m_Lambda <= 0) {
+            return;
+        }
+        if (m_NumberOfHistogramBins < 1) {
+            itkExceptionMacro(<< "The number of histogram bins must be positive");
+        }
+        unsigned int numberOfBins = m_NumberOfHistogramBins;
+
+        BinContainerType foregroundBins, backgroundBins;
+        if (std::numeric_limits<InputPixelType>::is_integer && sizeof(InputPixelType) <= 2) {
+            // count every intensity, then spread the bins over the intensities of the seeds. this needs no extra pass
+            // for the intensity range.
+            double lowest = NumericTraits<InputPixelType>::NonpositiveMin();
+            double highest = NumericTraits<InputPixelType>::max();
+            BinContainerType foregroundValues, backgroundValues;
+            CountSeedIntensities(images, lowest, highest, 1.0, highest - lowest + 1, foregroundValues,
+                                 backgroundValues);
+
+            unsigned int first = 0, last = foregroundValues.size();
+            while (first < last && foregroundValues[first] + backgroundValues[first] == 0) {
+                first++;
+            }
+            while (last > first && foregroundValues[last - 1] + backgroundValues[last - 1] == 0) {
+                last--;
+            }
+            if (first == last) {
+                itkWarningMacro(<< "No seeds, the regional term is not used");
+                return;
+            }
+
+            m_HistogramMinimum = lowest + first;
+            m_HistogramMaximum = lowest + last - 1;
+            m_HistogramBinWidth = (double) (last - first) / numberOfBins;
+            foregroundBins.assign(numberOfBins, 0);
+            backgroundBins.assign(numberOfBins, 0);
+            for (unsigned int v = first; v < last; v++) {
+                unsigned int bin = std::min<unsigned int>((unsigned int) ((v - first) / m_HistogramBinWidth),
+                                                          numberOfBins - 1);
+                foregroundBins[bin] += foregroundValues[v];
+                backgroundBins[bin] += backgroundValues[v];
+            }
+        } else {
+            typedef MinimumMaximumImageCalculator<InputImageType> CalculatorType;
+            typename CalculatorType::Pointer calculator = CalculatorType::New();
+            calculator->SetImage(images.input);
+            calculator->SetRegion(images.inputRegion);
+            calculator->Compute();
+
+            m_HistogramMinimum = calculator->GetMinimum();
+            m_HistogramMaximum = calculator->GetMaximum();
+            m_HistogramBinWidth = (m_HistogramMaximum - m_HistogramMinimum) / numberOfBins;
+            if (m_HistogramBinWidth <= 0) {
+                m_HistogramBinWidth = 1.0;
+            }
+            CountSeedIntensities(images, m_HistogramMinimum, m_HistogramMaximum, m_HistogramBinWidth, numberOfBins,
+                                 foregroundBins, backgroundBins);
+        }
+
+        SizeValueType numberOfForegroundSeeds = 0, numberOfBackgroundSeeds = 0;
+        for (unsigned int bin = 0; bin < numberOfBins; bin++) {
+            numberOfForegroundSeeds += foregroundBins[bin];
+            numberOfBackgroundSeeds += backgroundBins[bin];
+        }
+
+        // the likelihoods are smoothed by one count in every bin (and in the bin of the unseen intensities), so that
+        // none of them is 0. only the difference of the two weights of a voxel matters for the cut, the smaller one
+        // is subtracted from both.
+        m_RegionalSourceWeights.resize(numberOfBins + 1);
+        m_RegionalSinkWeights.resize(numberOfBins + 1);
+        for (unsigned int bin = 0; bin <= numberOfBins; bin++) {
+            SizeValueType foregroundCount = bin < numberOfBins ? foregroundBins[bin] : 0;
+            SizeValueType backgroundCount = bin < numberOfBins ? backgroundBins[bin] : 0;
+            double foregroundLikelihood = (foregroundCount + 1.0) / (numberOfForegroundSeeds + numberOfBins + 1);
+            double backgroundLikelihood = (backgroundCount + 1.0) / (numberOfBackgroundSeeds + numberOfBins + 1);
+            double sourceWeight = -m_Lambda * std::log(backgroundLikelihood);
+            double sinkWeight = -m_Lambda * std::log(foregroundLikelihood);
+            double common = std::min(sourceWeight, sinkWeight);
+            m_RegionalSourceWeights[bin] = sourceWeight - common;
+            m_RegionalSinkWeights[bin] = sinkWeight - common;
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DFilter<TImage, TForeground, TBackground, TOutput>
+    ::CountSeedIntensities(const ImageContainer &images, double minimum, double maximum, double binWidth,
+                           unsigned int numberOfBins, BinContainerType &foregroundBins,
+                           BinContainerType &backgroundBins) {
+        typename InputImageType::RegionType region = images.inputRegion;
+        unsigned int depth = region.GetSize(2);
+        unsigned int numberOfThreads = std::max(1u, std::min<unsigned int>(this->GetNumberOfThreads(), depth));
+
+        std::vector<BinContainerType> threadForegroundBins(numberOfThreads, BinContainerType(numberOfBins, 0));
+        std::vector<BinContainerType> threadBackgroundBins(numberOfThreads, BinContainerType(numberOfBins, 0));
+
+        auto count = [&](unsigned int thread) {
+            typename InputImageType::RegionType slab = region;
+            unsigned int begin = (SizeValueType) depth * thread / numberOfThreads;
+            unsigned int end = (SizeValueType) depth * (thread + 1) / numberOfThreads;
+            slab.SetIndex(2, region.GetIndex(2) + begin);
+            slab.SetSize(2, end - begin);
+
+            BinContainerType &foreground = threadForegroundBins[thread];
+            BinContainerType &background = threadBackgroundBins[thread];
+            ImageRegionConstIterator<InputImageType> inputIterator(images.input, slab);
+            ImageRegionConstIterator<ForegroundImageType> foregroundIterator(images.foreground, slab);
+            ImageRegionConstIterator<BackgroundImageType> backgroundIterator(images.background, slab);
+            for (; !inputIterator.IsAtEnd(); ++inputIterator, ++foregroundIterator, ++backgroundIterator) {
+                bool isForeground =
+                        foregroundIterator.Get() > NumericTraits<typename ForegroundImageType::PixelType>::Zero;
+                bool isBackground =
+                        backgroundIterator.Get() > NumericTraits<typename BackgroundImageType::PixelType>::Zero;
+                double pixel = inputIterator.Get();
+                if ((!isForeground && !isBackground) || pixel < minimum || pixel > maximum) {
+                    continue;
+                }
+
+                unsigned int bin = std::min<unsigned int>((unsigned int) ((pixel - minimum) / binWidth),
+                                                          numberOfBins - 1);
+                if (isForeground) {
+                    foreground[bin]++;
+                }
+                if (isBackground) {
+                    background[bin]++;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int thread = 1; thread < numberOfThreads; thread++) {
+            threads.push_back(std::thread(count, thread));
+        }
+        count(0);
+        for (unsigned int i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+
+        foregroundBins.swap(threadForegroundBins[0]);
+        backgroundBins.swap(threadBackgroundBins[0]);
+        for (unsigned int thread = 1; thread < numberOfThreads; thread++) {
+            for (unsigned int bin = 0; bin < numberOfBins; bin++) {
+                foregroundBins[bin] += threadForegroundBins[thread][bin];
+                backgroundBins[bin] += threadBackgroundBins[thread][bin];
+            }
         }
     }
 
@@ -106,7 +324,23 @@ namespace itk {
     ::ConvertIndexToVertexDescriptor(const itk::Index<3> index, typename TImage::RegionType region) {
         typename TImage::SizeType size = region.GetSize();
 
-        return index[0] + index[1] * size[0] + index[2] * size[0] * size[1];
+        if (m_NodeOrder == RasterOrder) {
+            return index[0] + index[1] * size[0] + index[2] * size[0] * size[1];
+        }
+
+        // bricks in raster order, the voxels of a brick in raster order. the bricks at the upper borders are clipped.
+        unsigned int brick[3], offset[3], extent[3];
+        for (unsigned int d = 0; d < 3; ++d) {
+            brick[d] = index[d] / m_BrickSize;
+            offset[d] = index[d] % m_BrickSize;
+            extent[d] = std::min<unsigned int>(m_BrickSize, size[d] - brick[d] * m_BrickSize);
+        }
+
+        // all slabs of bricks below, all rows of bricks in this slab before and all bricks in this row before
+        unsigned int first = brick[2] * m_BrickSize * size[0] * size[1]
+                             + brick[1] * m_BrickSize * size[0] * extent[2]
+                             + brick[0] * m_BrickSize * extent[1] * extent[2];
+        return first + offset[0] + offset[1] * extent[0] + offset[2] * extent[0] * extent[1];
     }
 }
 
@@ -42,6 +42,9 @@ namespace itk{
 
         virtual void addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight) = 0;
 
+        // adds the cost images to the terminal edges of all nodes, solvers with a bulk interface override it
+        virtual void addTerminalCostImages(const ImageContainer &images);
+
 		// query the resulting segmentation group of a vertex.
 		virtual int groupOf(const unsigned int vertex) const = 0;
 
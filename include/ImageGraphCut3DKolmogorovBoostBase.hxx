@@ -60,8 +60,22 @@ namespace itk{
         iterator.ActivateOffset(front);
         iterator.ActivateOffset(center);
 
-        for (iterator.GoToBegin(); !iterator.IsAtEnd(); ++iterator) {
+        // dimension along which each of the neighbors lies
+        const unsigned int neighborDimensions[3] = {1, 0, 2};
+
+        bool hasRegionalTerm = this->HasRegionalTerm();
+        SizeValueType voxel = 0;
+
+        for (iterator.GoToBegin(); !iterator.IsAtEnd(); ++iterator, ++voxel) {
             typename InputImageType::PixelType centerPixel = iterator.GetPixel(center);
+            unsigned int nodeIndex1 = this->ConvertIndexToVertexDescriptor(iterator.GetIndex(center), images.inputRegion);
+
+            // regional term of the voxel
+            if (hasRegionalTerm) {
+                WeightType sourceWeight, sinkWeight;
+                this->GetRegionalWeights(centerPixel, sourceWeight, sinkWeight);
+                addTerminalEdges(nodeIndex1, sourceWeight, sinkWeight);
+            }
 
             for (unsigned int i = 0; i < neighbors.size(); i++) {
                 bool pixelIsValid;
@@ -72,12 +86,16 @@ namespace itk{
                     continue;
                 }
 
-                // Compute the edge weight
-                double weight = exp(-pow(centerPixel - neighborPixel, 2) / (2.0 * this->m_Sigma * this->m_Sigma));
+                // Compute the edge weight, or take it from the boundary weight image
+                double weight;
+                if (images.boundaryWeights) {
+                    weight = this->GetBoundaryWeight(images, voxel, neighborDimensions[i]);
+                } else {
+                    weight = exp(-pow(centerPixel - neighborPixel, 2) / (2.0 * this->m_Sigma * this->m_Sigma));
+                }
                 assert(weight >= 0);
 
                 // Add the edge to the graph
-                unsigned int nodeIndex1 = this->ConvertIndexToVertexDescriptor(iterator.GetIndex(center), images.inputRegion);
                 unsigned int nodeIndex2 = this->ConvertIndexToVertexDescriptor(iterator.GetIndex(neighbors[i]), images.inputRegion);
 
                 //Determine which direction is used
@@ -98,6 +116,10 @@ namespace itk{
             progress.CompletedPixel();
         }
 
+        if (images.sourceCost || images.sinkCost) {
+            addTerminalCostImages(images);
+        }
+
         // set the terminal connection capacity to max float
         for (unsigned int i = 0; i < sources.size(); i++) {
             unsigned int sourceIndex = this->ConvertIndexToVertexDescriptor(sources[i], images.inputRegion);
@@ -109,6 +131,20 @@ namespace itk{
         }
 	};
 
+	template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+	void ImageGraphCut3DKolmogorovBoostBase<TImage, TForeground, TBackground, TOutput>
+	::addTerminalCostImages(const ImageContainer &images){
+        const float *sourceCosts = images.sourceCost ? images.sourceCost->GetBufferPointer() : 0;
+        const float *sinkCosts = images.sinkCost ? images.sinkCost->GetBufferPointer() : 0;
+
+        // the buffers are in raster order, the nodes may not be
+        itk::ImageRegionConstIteratorWithIndex<InputImageType> iterator(images.input, images.inputRegion);
+        for (SizeValueType voxel = 0; !iterator.IsAtEnd(); ++iterator, ++voxel) {
+            unsigned int node = this->ConvertIndexToVertexDescriptor(iterator.GetIndex(), images.inputRegion);
+            addTerminalEdges(node, sourceCosts ? sourceCosts[voxel] : 0, sinkCosts ? sinkCosts[voxel] : 0);
+        }
+	};
+
 	template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
 	void ImageGraphCut3DKolmogorovBoostBase<TImage, TForeground, TBackground, TOutput>
 	::CutGraph(ImageContainer images, ProgressReporter &progress){
@@ -11,13 +11,54 @@
 #define __ImageGraphCut3DKolmogorovFilter_h_
 
 #include "lib/kolmogorov-3.03/graph.h"
+#include "lib/kolmogorov-3.03/graph_csr.h"
 #include "ImageGraphCut3DKolmogorovBoostBase.h"
+#include "itkMath.h"
+#include "itkTimeProbe.h"
+
+// STL
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
 /*
  * Wraps kolmogorovs graph library
  */
 namespace itk{
+    //! Graph types instantiated in lib/kolmogorov-3.03/instances.inc and instances_csr.inc, terminal capacities and flow must be 'larger'
+    template<typename TCapacity>
+    struct KolmogorovCapacityTraits {
+        typedef TCapacity TerminalCapacityType;
+        typedef TCapacity FlowType;
+    };
+
+    // the flow sums the scaled capacities of every cut edge and would overflow 32 bits on large cuts
+    template<>
+    struct KolmogorovCapacityTraits<int> {
+        typedef int TerminalCapacityType;
+        typedef long long FlowType;
+    };
+
+    template<>
+    struct KolmogorovCapacityTraits<short> {
+        typedef int TerminalCapacityType;
+        typedef long long FlowType;
+    };
+
     //! GraphCut solver using Yuri Boykov and Vladimir Kolmogorovs MAXFLOW implementation
-	template<typename TInput, typename TForeground, typename TBackground, typename TOutput>
+    /*
+     * With an integer capacity type the boundary weights in [0,1] are scaled and rounded to integers. The residual
+     * capacity of an edge can grow to the sum of both directions, the scale is therefore at most half of the largest
+     * capacity. Seeds can not be infinite anymore, they get a capacity larger than all edges of a node together, which
+     * is never cut.
+     *
+     * TGraph selects the storage of the solver: Graph (pointer linked) or GraphCSR (index based arrays, less memory).
+     */
+	template<typename TInput, typename TForeground, typename TBackground, typename TOutput, typename TCapacity = float,
+	        template<typename, typename, typename> class TGraph = Graph>
 	class ImageGraphCut3DKolmogorovFilter : public ImageGraphCut3DKolmogorovBoostBase<TInput, TForeground, TBackground, TOutput>{
 	public:
 		// ITK related defaults
@@ -38,7 +79,139 @@ namespace itk{
         typedef typename SuperClass::WeightType WeightType;
 
         typedef typename SuperClass::ImageContainer ImageContainer;
-		typedef Graph<WeightType , WeightType , WeightType> GraphType;
+        typedef TCapacity CapacityType;
+        typedef typename KolmogorovCapacityTraits<TCapacity>::TerminalCapacityType TerminalCapacityType;
+        typedef typename KolmogorovCapacityTraits<TCapacity>::FlowType FlowType;
+		typedef TGraph<CapacityType, TerminalCapacityType, FlowType> GraphType;
+
+        // factor mapping a weight of 1 to an integer capacity, ignored for floating point capacities
+        void SetCapacityScale(double d) {
+            m_CapacityScale = d;
+        }
+
+        double GetCapacityScale() const {
+            return m_CapacityScale;
+        }
+
+        // rounding error of the finite capacities of the last graph, in units of the weights
+        double GetMaximumQuantizationError() const {
+            return m_MaximumQuantizationError;
+        }
+
+        double GetMeanQuantizationError() const {
+            return m_NumberOfQuantizedCapacities > 0 ? m_SumOfQuantizationErrors / m_NumberOfQuantizedCapacities : 0;
+        }
+
+        // stop maxflow after this many augmenting paths, 0 for no limit
+        void SetAugmentationBudget(int n) {
+            m_AugmentationBudget = n;
+        }
+
+        int GetAugmentationBudget() const {
+            return m_AugmentationBudget;
+        }
+
+        // stop maxflow after this many seconds of wall-clock time, 0 for no limit
+        void SetTimeBudget(double seconds) {
+            m_TimeBudget = seconds;
+        }
+
+        double GetTimeBudget() const {
+            return m_TimeBudget;
+        }
+
+        // false if the budget stopped the last solve, the output is then the cut of the current search trees
+        bool IsOptimal() const {
+            return !m_Graph->maxflow_interrupted();
+        }
+
+        // the next Update() continues the interrupted solve on the same graph instead of building a new one, the inputs
+        // must not have changed in between
+        void ResumeSolve() {
+            m_ResumeSolve = true;
+            this->Modified();
+        }
+
+        // keep the graph between updates of images with the same size and seeds, e.g. the frames of a 4D series. The
+        // next Update() then only changes the capacities that differ and the solver continues from the previous flow
+        // and search trees. Costs a copy of all capacities.
+        void SetWarmStart(bool b) {
+            m_WarmStart = b;
+        }
+
+        bool GetWarmStart() const {
+            return m_WarmStart;
+        }
+
+        // capacities that changed by at most this, in units of the weights, keep their previous value when warm starting
+        void SetWarmStartThreshold(double d) {
+            m_WarmStartThreshold = d;
+        }
+
+        double GetWarmStartThreshold() const {
+            return m_WarmStartThreshold;
+        }
+
+        // true if the last update reused the graph of the previous one
+        bool WasWarmStarted() const {
+            return m_WarmStarting;
+        }
+
+        // edges and terminal connections changed by the last warm start
+        unsigned long GetNumberOfUpdatedCapacities() const {
+            return m_NumberOfUpdatedCapacities;
+        }
+
+        // GrabCut-like refinement (Rother et al., SIGGRAPH 2004): after the first cut, Gaussian mixtures of the
+        // intensities are fitted to the foreground and the background of the current segmentation, their negative
+        // log-likelihoods weighted by lambda replace the regional term and the graph is cut again. Only the t-links
+        // change, the solver continues from the previous flow. 1 (the default) cuts once, the regional term then
+        // stays the seed histograms, see SetLambda().
+        void SetNumberOfIterations(unsigned int n) {
+            m_NumberOfIterations = n;
+        }
+
+        unsigned int GetNumberOfIterations() const {
+            return m_NumberOfIterations;
+        }
+
+        // the refinement stops when at most this fraction of the voxels changed their label in an iteration
+        void SetConvergenceTolerance(double d) {
+            m_ConvergenceTolerance = d;
+        }
+
+        double GetConvergenceTolerance() const {
+            return m_ConvergenceTolerance;
+        }
+
+        // components of each Gaussian mixture
+        void SetNumberOfGaussians(unsigned int n) {
+            m_NumberOfGaussians = n;
+        }
+
+        unsigned int GetNumberOfGaussians() const {
+            return m_NumberOfGaussians;
+        }
+
+        // cuts of the last update, including the first one
+        unsigned int GetNumberOfPerformedIterations() const {
+            return m_NumberOfPerformedIterations;
+        }
+
+        virtual void FillGraph(const ImageContainer images, ProgressReporter &progress) override
+        {
+            if (m_ResumeSolve && m_Graph->maxflow_interrupted()) {
+                return;
+            }
+            m_ResumeSolve = false;
+
+            m_WarmStarting = m_WarmStart && canWarmStart(images);
+            m_HasSolution = false;
+            SuperClass::FillGraph(images, progress);
+            if (m_WarmStart) {
+                updateTerminalEdges();
+            }
+        }
 
         virtual void InitializeGraph(const ImageContainer) override
         {
@@ -50,23 +223,121 @@ namespace itk{
 
             std::cout << "Number of vertices: " << numberOfVertices << ", number of edges: " << numberOfEdges << std::endl;
 
-            m_Graph = new GraphType(numberOfVertices, numberOfEdges);
+            if (std::numeric_limits<CapacityType>::is_integer &&
+                (m_CapacityScale < 1 || 2 * m_CapacityScale > std::numeric_limits<CapacityType>::max())) {
+                itkExceptionMacro(<< "The capacity scale must be in [1, " << std::numeric_limits<CapacityType>::max() / 2 << "]");
+            }
+            m_MaximumQuantizationError = 0;
+            m_SumOfQuantizationErrors = 0;
+            m_NumberOfQuantizedCapacities = 0;
+            m_LargestTerminalCapacity = 0;
+            m_NumberOfUpdatedCapacities = 0;
+
+            if (m_WarmStarting) {
+                // the capacities are compared with the previous ones in the order they are added
+                m_WarmStartTolerance = m_WarmStartThreshold * (std::numeric_limits<CapacityType>::is_integer ? m_CapacityScale : 1);
+                m_NextArc = m_Graph->get_first_arc();
+                m_ArcIndex = 0;
+                std::fill(m_NewSourceCapacities.begin(), m_NewSourceCapacities.end(), 0);
+                std::fill(m_NewSinkCapacities.begin(), m_NewSinkCapacities.end(), 0);
+                return;
+            }
+
+            // the node and arc storage is recycled for every image that fits into it, so a filter processing a batch
+            // only allocates for the largest image
+            if (numberOfVertices <= m_NodeCapacity && numberOfEdges <= m_EdgeCapacity) {
+                m_Graph->reset();
+            } else {
+                delete m_Graph;
+                m_NodeCapacity = std::max(m_NodeCapacity, numberOfVertices);
+                m_EdgeCapacity = std::max(m_EdgeCapacity, numberOfEdges);
+                m_Graph = new GraphType(m_NodeCapacity, m_EdgeCapacity);
+            }
             m_Graph->add_node(numberOfVertices);
+
+            m_WarmStartTolerance = 0;
+            m_ArcCapacities.clear();
+            if (m_WarmStart) {
+                m_ArcCapacities.reserve(2 * numberOfEdges);
+                m_SourceCapacities.assign(numberOfVertices, 0);
+                m_SinkCapacities.assign(numberOfVertices, 0);
+                m_NewSourceCapacities.assign(numberOfVertices, 0);
+                m_NewSinkCapacities.assign(numberOfVertices, 0);
+            } else {
+                std::vector<CapacityType>().swap(m_ArcCapacities);
+                std::vector<TerminalCapacityType>().swap(m_SourceCapacities);
+                std::vector<TerminalCapacityType>().swap(m_SinkCapacities);
+                std::vector<TerminalCapacityType>().swap(m_NewSourceCapacities);
+                std::vector<TerminalCapacityType>().swap(m_NewSinkCapacities);
+            }
         }
 
 
         // boykov_kolmogorov_max_flow requires all edges to have a reverse edge.
         virtual inline void addBidirectionalEdge(const unsigned int source, const unsigned int target, const float weight, const float reverseWeight) override {
-            m_Graph->add_edge(source, target, weight, reverseWeight);
+            CapacityType capacity = quantize<CapacityType>(weight);
+            CapacityType reverseCapacity = quantize<CapacityType>(reverseWeight);
+            if (m_WarmStarting) {
+                updateEdge(source, target, capacity, reverseCapacity);
+                return;
+            }
+            m_Graph->add_edge(source, target, capacity, reverseCapacity);
+            if (m_WarmStart) {
+                m_ArcCapacities.push_back(capacity);
+                m_ArcCapacities.push_back(reverseCapacity);
+            }
         }
 
+        // with warm start the terminal capacities are collected and added by updateTerminalEdges()
         virtual inline void addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight) override{
-            m_Graph->add_tweights(node, sourceWeight, sinkWeight);
+            if (m_WarmStart) {
+                m_NewSourceCapacities[node] += quantizeTerminal(sourceWeight);
+                m_NewSinkCapacities[node] += quantizeTerminal(sinkWeight);
+                return;
+            }
+            m_Graph->add_tweights(node, quantizeTerminal(sourceWeight), quantizeTerminal(sinkWeight));
+        }
+
+        // Floating point capacities are added straight from the buffers of the cost images if the nodes are in raster
+        // order. Otherwise the costs are quantized or reordered voxel by voxel, and warm start compares them one by one.
+        virtual void addTerminalCostImages(const ImageContainer &images) override{
+            const float *sourceCosts = images.sourceCost ? images.sourceCost->GetBufferPointer() : 0;
+            const float *sinkCosts = images.sinkCost ? images.sinkCost->GetBufferPointer() : 0;
+            if (!std::numeric_limits<CapacityType>::is_integer && !m_WarmStart &&
+                this->m_NodeOrder == SuperClass::RasterOrder) {
+                m_Graph->add_tweights(0, m_Graph->get_node_num(), sourceCosts, sinkCosts);
+                return;
+            }
+
+            ImageRegionConstIteratorWithIndex<InputImageType> iterator(images.input, images.inputRegion);
+            for (SizeValueType voxel = 0; !iterator.IsAtEnd(); ++iterator, ++voxel) {
+                unsigned int node = this->ConvertIndexToVertexDescriptor(iterator.GetIndex(), images.inputRegion);
+                Self::addTerminalEdges(node, sourceCosts ? sourceCosts[voxel] : 0, sinkCosts ? sinkCosts[voxel] : 0);
+            }
         }
 
         // start the calculation
         virtual void SolveGraph() override{
-            m_Graph->maxflow();
+            m_Graph->set_maxflow_budget(m_AugmentationBudget, m_TimeBudget);
+            m_Graph->maxflow(m_ResumeSolve || m_WarmStarting);
+            m_ResumeSolve = false;
+            m_HasSolution = true;
+            m_NumberOfPerformedIterations = 1;
+            if (!IsOptimal()) {
+                if (this->m_PrintTimer) {
+                    std::cout << "Maxflow interrupted, the segmentation is approximate" << std::endl;
+                }
+            } else if (m_NumberOfIterations > 1) {
+                refineSegmentation();
+            }
+            if (this->m_PrintTimer && m_WarmStarting) {
+                std::cout << "Warm start, updated capacities: " << m_NumberOfUpdatedCapacities << std::endl;
+            }
+
+            if (this->m_PrintTimer && std::numeric_limits<CapacityType>::is_integer) {
+                std::cout << "Quantization error: maximum " << GetMaximumQuantizationError()
+                          << ", mean " << GetMeanQuantizationError() << std::endl;
+            }
         }
 
         // query the resulting segmentation group of a vertex.
@@ -100,14 +371,418 @@ namespace itk{
         }
 
 	protected:
-        ImageGraphCut3DKolmogorovFilter(){
+        ImageGraphCut3DKolmogorovFilter()
+                : m_CapacityScale(DefaultCapacityScale()),
+                  m_MaximumQuantizationError(0),
+                  m_SumOfQuantizationErrors(0),
+                  m_NumberOfQuantizedCapacities(0),
+                  m_LargestTerminalCapacity(0),
+                  m_AugmentationBudget(0),
+                  m_TimeBudget(0),
+                  m_ResumeSolve(false),
+                  m_WarmStart(false),
+                  m_WarmStartThreshold(0),
+                  m_WarmStarting(false),
+                  m_HasSolution(false),
+                  m_WarmStartTolerance(0),
+                  m_WarmStartBrickSize(0),
+                  m_ArcIndex(0),
+                  m_NumberOfUpdatedCapacities(0),
+                  m_NodeCapacity(0),
+                  m_EdgeCapacity(0),
+                  m_NumberOfIterations(1),
+                  m_ConvergenceTolerance(0.001),
+                  m_NumberOfGaussians(5),
+                  m_NumberOfPerformedIterations(0) {
            m_Graph = new GraphType(1,1);
         };
 
         virtual ~ImageGraphCut3DKolmogorovFilter(){
             delete m_Graph;
         };
+
+        // half of the largest capacity for integers, see above
+        static double DefaultCapacityScale() {
+            if (!std::numeric_limits<CapacityType>::is_integer) {
+                return 1.0;
+            }
+            return std::min<double>(std::numeric_limits<CapacityType>::max() / 2, 1 << 20);
+        }
+
+        // rounds a weight to an integer capacity and records the error
+        template<typename TValue>
+        inline TValue quantize(const float weight) {
+            if (!std::numeric_limits<CapacityType>::is_integer) {
+                return weight;
+            }
+            double capacity = std::floor(weight * m_CapacityScale + 0.5);
+            if (std::fabs(capacity) > std::numeric_limits<TValue>::max()) {
+                itkExceptionMacro(<< "The weight " << weight << " scaled by " << m_CapacityScale
+                                  << " exceeds the capacity type, lower the capacity scale");
+            }
+            double error = std::fabs(weight - capacity / m_CapacityScale);
+            m_MaximumQuantizationError = std::max(m_MaximumQuantizationError, error);
+            m_SumOfQuantizationErrors += error;
+            m_NumberOfQuantizedCapacities++;
+            return (TValue) capacity;
+        }
+
+        // infinite seeds are bounded by the capacity of all six edges of a node and any finite terminal weight
+        inline TerminalCapacityType quantizeTerminal(const float weight) {
+            if (std::numeric_limits<CapacityType>::is_integer && weight >= FLT_MAX) {
+                double seedCapacity = 6 * m_CapacityScale + (double) m_LargestTerminalCapacity + 1;
+                if (seedCapacity > std::numeric_limits<TerminalCapacityType>::max()) {
+                    itkExceptionMacro(<< "The capacity of the seeds exceeds the terminal capacity type, lower the "
+                                      << "capacity scale");
+                }
+                return (TerminalCapacityType) seedCapacity;
+            }
+            TerminalCapacityType capacity = quantize<TerminalCapacityType>(weight);
+            m_LargestTerminalCapacity = std::max(m_LargestTerminalCapacity, capacity);
+            return capacity;
+        }
+
+        // the graph of the previous image can be reused if its size, node order and seeds are the same
+        bool canWarmStart(const ImageContainer &images) {
+            IndexContainerType sources = this->template getPixelsLargerThanZero<ForegroundImageType>(images.foreground);
+            IndexContainerType sinks = this->template getPixelsLargerThanZero<BackgroundImageType>(images.background);
+            bool sameGraph = m_HasSolution && m_WarmStartSize == images.inputRegion.GetSize() &&
+                             m_WarmStartNodeOrder == this->m_NodeOrder && m_WarmStartBrickSize == this->m_BrickSize &&
+                             m_WarmStartSources == sources && m_WarmStartSinks == sinks;
+
+            m_WarmStartSize = images.inputRegion.GetSize();
+            m_WarmStartNodeOrder = this->m_NodeOrder;
+            m_WarmStartBrickSize = this->m_BrickSize;
+            m_WarmStartSources.swap(sources);
+            m_WarmStartSinks.swap(sinks);
+            return sameGraph;
+        }
+
+        template<typename TValue>
+        inline bool capacityChanged(const TValue capacity, const TValue previous) const {
+            return capacity != previous && std::fabs((double) capacity - (double) previous) > m_WarmStartTolerance;
+        }
+
+        // Sets the capacities of the next edge without changing its flow. If the new capacity is smaller than the flow,
+        // the excess e is moved to the terminals: c(i->j) += e, c(j->i) -= e, c(s->i) += e and c(j->t) += e leave the
+        // energy of every cut unchanged. The solver has to revisit both nodes.
+        inline void updateEdge(const unsigned int source, const unsigned int target, const CapacityType capacity,
+                               const CapacityType reverseCapacity) {
+            typename GraphType::arc_id arc = m_NextArc;
+            typename GraphType::arc_id reverseArc = m_Graph->get_next_arc(arc);
+            m_NextArc = m_Graph->get_next_arc(reverseArc);
+            CapacityType &previousCapacity = m_ArcCapacities[m_ArcIndex++];
+            CapacityType &previousReverseCapacity = m_ArcCapacities[m_ArcIndex++];
+            if (!capacityChanged(capacity, previousCapacity) && !capacityChanged(reverseCapacity, previousReverseCapacity)) {
+                return;
+            }
+
+            CapacityType residual = m_Graph->get_rcap(arc) + (capacity - previousCapacity);
+            CapacityType reverseResidual = m_Graph->get_rcap(reverseArc) + (reverseCapacity - previousReverseCapacity);
+            if (residual < 0) {
+                m_Graph->add_tweights(source, -residual, 0);
+                m_Graph->add_tweights(target, 0, -residual);
+                reverseResidual += residual;
+                residual = 0;
+            } else if (reverseResidual < 0) {
+                m_Graph->add_tweights(target, -reverseResidual, 0);
+                m_Graph->add_tweights(source, 0, -reverseResidual);
+                residual += reverseResidual;
+                reverseResidual = 0;
+            }
+            m_Graph->set_rcap(arc, residual);
+            m_Graph->set_rcap(reverseArc, reverseResidual);
+            m_Graph->mark_node(source);
+            m_Graph->mark_node(target);
+
+            previousCapacity = capacity;
+            previousReverseCapacity = reverseCapacity;
+            m_NumberOfUpdatedCapacities++;
+        }
+
+        // adds the difference of the collected terminal capacities to the ones in the graph
+        void updateTerminalEdges() {
+            for (unsigned int node = 0; node < m_NewSourceCapacities.size(); ++node) {
+                TerminalCapacityType source = m_NewSourceCapacities[node];
+                TerminalCapacityType sink = m_NewSinkCapacities[node];
+                if (!capacityChanged(source, m_SourceCapacities[node]) && !capacityChanged(sink, m_SinkCapacities[node])) {
+                    continue;
+                }
+                m_Graph->add_tweights(node, source - m_SourceCapacities[node], sink - m_SinkCapacities[node]);
+                m_SourceCapacities[node] = source;
+                m_SinkCapacities[node] = sink;
+                if (m_WarmStarting) {
+                    m_Graph->mark_node(node);
+                    m_NumberOfUpdatedCapacities++;
+                }
+            }
+        }
+
+        //! Gaussian mixture of the intensities of one segment
+        struct GaussianMixture {
+            std::vector<double> weights;
+            std::vector<double> means;
+            std::vector<double> variances;
+
+            inline double weightedDensity(unsigned int k, double x) const {
+                double d = x - means[k];
+                return weights[k] * std::exp(-d * d / (2 * variances[k])) / std::sqrt(2 * Math::pi * variances[k]);
+            }
+
+            inline double likelihood(double x) const {
+                double p = 0;
+                for (unsigned int k = 0; k < weights.size(); ++k) {
+                    p += weightedDensity(k, x);
+                }
+                return p;
+            }
+
+            // component most likely to have generated x
+            inline unsigned int component(double x) const {
+                unsigned int best = 0;
+                double bestDensity = -1;
+                for (unsigned int k = 0; k < weights.size(); ++k) {
+                    double density = weightedDensity(k, x);
+                    if (density > bestDensity) {
+                        best = k;
+                        bestDensity = density;
+                    }
+                }
+                return best;
+            }
+        };
+
+        // One step of hard EM: every voxel is assigned to the most likely component of the mixture of its segment, the
+        // components are then estimated from their voxels. Without a previous mixture the intensity range of a segment
+        // is split evenly into the components. The nodes are split among the threads, each thread sums up into its own
+        // moments.
+        void fitGaussianMixtures(const std::vector<float> &intensities, const std::vector<unsigned char> &labels,
+                                 GaussianMixture mixtures[2], bool initialize) {
+            unsigned int numberOfNodes = intensities.size();
+            unsigned int numberOfGaussians = std::max(1u, m_NumberOfGaussians);
+            double minimum[2] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+            double maximum[2] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+            if (initialize) {
+                for (unsigned int node = 0; node < numberOfNodes; ++node) {
+                    minimum[labels[node]] = std::min<double>(minimum[labels[node]], intensities[node]);
+                    maximum[labels[node]] = std::max<double>(maximum[labels[node]], intensities[node]);
+                }
+            }
+
+            // count, sum and sum of squares of every component of both segments
+            unsigned int numberOfThreads = std::max(1u, std::min<unsigned int>(this->GetNumberOfThreads(), numberOfNodes));
+            std::vector<std::vector<double> > moments(numberOfThreads, std::vector<double>(2 * numberOfGaussians * 3, 0));
+            auto accumulate = [&](unsigned int thread) {
+                std::vector<double> &m = moments[thread];
+                unsigned int begin = (unsigned long) numberOfNodes * thread / numberOfThreads;
+                unsigned int end = (unsigned long) numberOfNodes * (thread + 1) / numberOfThreads;
+                for (unsigned int node = begin; node < end; ++node) {
+                    unsigned int label = labels[node];
+                    double x = intensities[node];
+                    unsigned int k;
+                    if (initialize) {
+                        double range = maximum[label] - minimum[label];
+                        k = range > 0 ? std::min<unsigned int>((unsigned int) ((x - minimum[label]) / range * numberOfGaussians),
+                                                               numberOfGaussians - 1) : 0;
+                    } else {
+                        k = mixtures[label].component(x);
+                    }
+                    double *c = &m[(label * numberOfGaussians + k) * 3];
+                    c[0] += 1;
+                    c[1] += x;
+                    c[2] += x * x;
+                }
+            };
+            std::vector<std::thread> threads;
+            for (unsigned int thread = 1; thread < numberOfThreads; ++thread) {
+                threads.push_back(std::thread(accumulate, thread));
+            }
+            accumulate(0);
+            for (unsigned int i = 0; i < threads.size(); ++i) {
+                threads[i].join();
+            }
+            for (unsigned int thread = 1; thread < numberOfThreads; ++thread) {
+                for (unsigned int i = 0; i < moments[0].size(); ++i) {
+                    moments[0][i] += moments[thread][i];
+                }
+            }
+
+            // empty components are dropped, the variance is bounded below so that a component of a single intensity
+            // does not become a spike
+            for (unsigned int label = 0; label < 2; ++label) {
+                GaussianMixture &mixture = mixtures[label];
+                mixture = GaussianMixture();
+                double total = 0;
+                for (unsigned int k = 0; k < numberOfGaussians; ++k) {
+                    total += moments[0][(label * numberOfGaussians + k) * 3];
+                }
+                for (unsigned int k = 0; k < numberOfGaussians; ++k) {
+                    const double *c = &moments[0][(label * numberOfGaussians + k) * 3];
+                    if (c[0] == 0) {
+                        continue;
+                    }
+                    double mean = c[1] / c[0];
+                    mixture.weights.push_back(c[0] / total);
+                    mixture.means.push_back(mean);
+                    mixture.variances.push_back(std::max(c[2] / c[0] - mean * mean, MinimumVariance()));
+                }
+            }
+        }
+
+        static double MinimumVariance() {
+            return 1e-4;
+        }
+
+        // Alternates between fitting the mixtures to the segmentation and cutting the graph with their t-links. The
+        // t-links of a node are built as for the first cut, from the cost images and the regional term, with the
+        // mixtures in place of the histograms. The difference to the t-links in the graph is added and the node marked
+        // for the solver, seeds keep theirs. The changed list of the solver tells which labels have to be read again.
+        void refineSegmentation() {
+            if (this->m_Lambda <= 0) {
+                itkExceptionMacro(<< "The iterative refinement needs a positive lambda");
+            }
+            const ImageContainer &images = this->m_Images;
+            unsigned int numberOfNodes = m_Graph->get_node_num();
+
+            // intensities, labels, costs and terminal capacities of the first cut in node order
+            std::vector<float> intensities(numberOfNodes);
+            std::vector<unsigned char> labels(numberOfNodes);     // 1 for the foreground
+            std::vector<bool> isSeed(numberOfNodes);
+            std::vector<TerminalCapacityType> sourceCosts(numberOfNodes, 0);
+            std::vector<TerminalCapacityType> sinkCosts(numberOfNodes, 0);
+            std::vector<TerminalCapacityType> sourceCapacities(numberOfNodes, 0);
+            std::vector<TerminalCapacityType> sinkCapacities(numberOfNodes, 0);
+            const float *sourceCostBuffer = images.sourceCost ? images.sourceCost->GetBufferPointer() : 0;
+            const float *sinkCostBuffer = images.sinkCost ? images.sinkCost->GetBufferPointer() : 0;
+            ImageRegionConstIteratorWithIndex<InputImageType> inputIterator(images.input, images.inputRegion);
+            ImageRegionConstIterator<ForegroundImageType> foregroundIterator(images.foreground, images.inputRegion);
+            ImageRegionConstIterator<BackgroundImageType> backgroundIterator(images.background, images.inputRegion);
+            for (SizeValueType voxel = 0; !inputIterator.IsAtEnd();
+                 ++inputIterator, ++foregroundIterator, ++backgroundIterator, ++voxel) {
+                unsigned int node = this->ConvertIndexToVertexDescriptor(inputIterator.GetIndex(), images.inputRegion);
+                intensities[node] = inputIterator.Get();
+                labels[node] = groupOf(node) == groupOfSource();
+                isSeed[node] = foregroundIterator.Get() > NumericTraits<typename ForegroundImageType::PixelType>::Zero ||
+                               backgroundIterator.Get() > NumericTraits<typename BackgroundImageType::PixelType>::Zero;
+                if (sourceCostBuffer) {
+                    sourceCosts[node] = quantize<TerminalCapacityType>(sourceCostBuffer[voxel]);
+                }
+                if (sinkCostBuffer) {
+                    sinkCosts[node] = quantize<TerminalCapacityType>(sinkCostBuffer[voxel]);
+                }
+                sourceCapacities[node] = sourceCosts[node];
+                sinkCapacities[node] = sinkCosts[node];
+                if (this->HasRegionalTerm()) {
+                    WeightType sourceWeight, sinkWeight;
+                    this->GetRegionalWeights(inputIterator.Get(), sourceWeight, sinkWeight);
+                    sourceCapacities[node] += quantize<TerminalCapacityType>(sourceWeight);
+                    sinkCapacities[node] += quantize<TerminalCapacityType>(sinkWeight);
+                }
+            }
+
+            GaussianMixture mixtures[2];
+            Block<typename GraphType::node_id> changedList(128);
+            for (unsigned int iteration = 1; iteration < m_NumberOfIterations; ++iteration) {
+                TimeProbe fitProbe, updateProbe, cutProbe;
+
+                fitProbe.Start();
+                fitGaussianMixtures(intensities, labels, mixtures, iteration == 1);
+                fitProbe.Stop();
+
+                // a likelihood of 0 would be an infinite weight
+                updateProbe.Start();
+                const double minimumLikelihood = 1e-30;
+                for (unsigned int node = 0; node < numberOfNodes; ++node) {
+                    if (isSeed[node]) {
+                        continue;
+                    }
+                    double sourceWeight = -this->m_Lambda * std::log(std::max(mixtures[0].likelihood(intensities[node]), minimumLikelihood));
+                    double sinkWeight = -this->m_Lambda * std::log(std::max(mixtures[1].likelihood(intensities[node]), minimumLikelihood));
+                    double common = std::min(sourceWeight, sinkWeight);
+                    TerminalCapacityType source = sourceCosts[node] + quantize<TerminalCapacityType>(sourceWeight - common);
+                    TerminalCapacityType sink = sinkCosts[node] + quantize<TerminalCapacityType>(sinkWeight - common);
+                    if (source == sourceCapacities[node] && sink == sinkCapacities[node]) {
+                        continue;
+                    }
+                    m_Graph->add_tweights(node, source - sourceCapacities[node], sink - sinkCapacities[node]);
+                    m_Graph->mark_node(node);
+                    if (m_WarmStart) {
+                        m_SourceCapacities[node] += source - sourceCapacities[node];
+                        m_SinkCapacities[node] += sink - sinkCapacities[node];
+                    }
+                    sourceCapacities[node] = source;
+                    sinkCapacities[node] = sink;
+                }
+                updateProbe.Stop();
+
+                cutProbe.Start();
+                m_Graph->maxflow(true, &changedList);
+                cutProbe.Stop();
+                m_NumberOfPerformedIterations++;
+
+                unsigned long numberOfChangedLabels = 0;
+                for (typename GraphType::node_id *node = changedList.ScanFirst(); node; node = changedList.ScanNext()) {
+                    unsigned char label = groupOf(*node) == groupOfSource();
+                    if (label != labels[*node]) {
+                        labels[*node] = label;
+                        numberOfChangedLabels++;
+                    }
+                    m_Graph->remove_from_changed_list(*node);
+                }
+                changedList.Reset();
+
+                if (this->m_PrintTimer) {
+                    std::cout << "Iteration " << iteration << ": fit " << fitProbe.GetTotal() << " s, update "
+                              << updateProbe.GetTotal() << " s, graph cut " << cutProbe.GetTotal() << " s, changed labels "
+                              << numberOfChangedLabels << std::endl;
+                }
+                if (numberOfChangedLabels <= m_ConvergenceTolerance * numberOfNodes) {
+                    break;
+                }
+            }
+        }
+
         GraphType* m_Graph;
+
+        double m_CapacityScale;
+        double m_MaximumQuantizationError;
+        double m_SumOfQuantizationErrors;
+        unsigned long m_NumberOfQuantizedCapacities;
+        TerminalCapacityType m_LargestTerminalCapacity;
+
+        int m_AugmentationBudget;
+        double m_TimeBudget;
+        bool m_ResumeSolve;
+
+        // warm start
+        bool m_WarmStart;
+        double m_WarmStartThreshold;
+        bool m_WarmStarting;                // the current update reuses the graph
+        bool m_HasSolution;                 // maxflow() was called on the graph
+        double m_WarmStartTolerance;        // m_WarmStartThreshold in units of the capacities
+        typename InputImageType::SizeType m_WarmStartSize;
+        typename SuperClass::NodeOrderType m_WarmStartNodeOrder;
+        unsigned int m_WarmStartBrickSize;
+        IndexContainerType m_WarmStartSources;
+        IndexContainerType m_WarmStartSinks;
+        std::vector<CapacityType> m_ArcCapacities;          // capacities in the graph, in the order of the arcs
+        std::vector<TerminalCapacityType> m_SourceCapacities;
+        std::vector<TerminalCapacityType> m_SinkCapacities;
+        std::vector<TerminalCapacityType> m_NewSourceCapacities;    // collected while filling the graph
+        std::vector<TerminalCapacityType> m_NewSinkCapacities;
+        typename GraphType::arc_id m_NextArc;
+        unsigned long m_ArcIndex;
+        unsigned long m_NumberOfUpdatedCapacities;
+
+        // sizes m_Graph was allocated for
+        int m_NodeCapacity;
+        int m_EdgeCapacity;
+
+        // iterative refinement
+        unsigned int m_NumberOfIterations;
+        double m_ConvergenceTolerance;
+        unsigned int m_NumberOfGaussians;
+        unsigned int m_NumberOfPerformedIterations;
     private:
         ImageGraphCut3DKolmogorovFilter(const Self &); // intentionally not implemented
         void operator=(const Self &); // intentionally not implemented
@@ -0,0 +1,177 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DOutOfCoreSegmentation_h_
+#define __ImageGraphCut3DOutOfCoreSegmentation_h_
+
+// ITK
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "MaxFlowGraphOutOfCore.hxx"
+
+// STL
+#include <string>
+
+namespace itk {
+    //! Graph cut segmentation of volumes which do not fit into memory
+    /*
+     * Computes the same segmentation as ImageGraphCut3DFilter, but works from files instead of a pipeline: the image
+     * and the masks are streamed block by block into a MaxFlowGraphOutOfCore which keeps its blocks in the scratch
+     * directory, and the result is pasted block by block into the output file. Apart from the solver blocks, which are
+     * limited by the memory budget, only the image data of a single block is held in memory.
+     *
+     * The input files must be in a format ITK can read partially and the output must be in a format ITK can write
+     * partially (e.g. MetaImage), otherwise ITK falls back to whole images.
+     */
+    template<typename TInput, typename TForeground, typename TBackground, typename TOutput>
+    class ImageGraphCut3DOutOfCoreSegmentation : public Object {
+    public:
+        // ITK related defaults
+        typedef ImageGraphCut3DOutOfCoreSegmentation Self;
+        typedef Object Superclass;
+        typedef SmartPointer<Self> Pointer;
+        typedef SmartPointer<const Self> ConstPointer;
+
+        itkNewMacro(Self);
+        itkTypeMacro(ImageGraphCut3DOutOfCoreSegmentation, Object);
+
+        // image types
+        typedef TInput InputImageType;
+        typedef TForeground ForegroundImageType;
+        typedef TBackground BackgroundImageType;
+        typedef TOutput OutputImageType;
+
+        typedef MaxFlowGraphOutOfCore GraphType;
+        typedef GraphType::NodeType NodeType;
+
+        typedef enum {
+            NoDirection, BrightDark, DarkBright
+        } BoundaryDirectionType;
+
+        // parameter setters
+        void SetSigma(double d) {
+            m_Sigma = d;
+        }
+
+        void SetBoundaryDirectionTypeToNoDirection() {
+            m_BoundaryDirectionType = NoDirection;
+        }
+
+        void SetBoundaryDirectionTypeToBrightDark() {
+            m_BoundaryDirectionType = BrightDark;
+        }
+
+        void SetBoundaryDirectionTypeToDarkBright() {
+            m_BoundaryDirectionType = DarkBright;
+        }
+
+        void SetForegroundPixelValue(typename OutputImageType::PixelType v) {
+            m_ForegroundPixelValue = v;
+        }
+
+        void SetBackgroundPixelValue(typename OutputImageType::PixelType v) {
+            m_BackgroundPixelValue = v;
+        }
+
+        // memory available to the resident solver blocks in bytes. at least three z-planes are always resident.
+        void SetMemoryBudget(std::size_t bytes) {
+            m_MemoryBudget = bytes;
+        }
+
+        // directory for the solver blocks, they are removed once the segmentation is written
+        void SetScratchDirectory(const std::string &directory) {
+            m_ScratchDirectory = directory;
+        }
+
+        // file setters
+        void SetInputFileName(const std::string &fileName) {
+            m_InputFileName = fileName;
+        }
+
+        void SetForegroundFileName(const std::string &fileName) {
+            m_ForegroundFileName = fileName;
+        }
+
+        void SetBackgroundFileName(const std::string &fileName) {
+            m_BackgroundFileName = fileName;
+        }
+
+        void SetOutputFileName(const std::string &fileName) {
+            m_OutputFileName = fileName;
+        }
+
+        void SetVerboseOutput(bool b) {
+            m_PrintTimer = b;
+        }
+
+        // reads the input files, segments and writes the output file
+        void Update();
+
+    protected:
+        typedef ImageFileReader<InputImageType> InputReaderType;
+        typedef ImageFileReader<ForegroundImageType> ForegroundReaderType;
+        typedef ImageFileReader<BackgroundImageType> BackgroundReaderType;
+        typedef ImageFileWriter<OutputImageType> WriterType;
+
+        ImageGraphCut3DOutOfCoreSegmentation();
+
+        virtual ~ImageGraphCut3DOutOfCoreSegmentation();
+
+        // streams one block of planes into the graph. the input additionally needs the first plane of the next block.
+        void FillBlock(GraphType &graph, typename InputImageType::RegionType blockRegion);
+
+        // streams the segmentation of one block of planes into the output file
+        void CutBlock(GraphType &graph, typename OutputImageType::RegionType blockRegion);
+
+        // region covering the planes [firstPlane, firstPlane + numberOfPlanes)
+        typename InputImageType::RegionType GetPlanes(unsigned int firstPlane, unsigned int numberOfPlanes) const;
+
+        // reads only the requested region of the file
+        template<typename TReader>
+        void ReadRegion(TReader *reader, typename TReader::OutputImageType::RegionType region);
+
+        NodeType ConvertIndexToVertexDescriptor(const itk::Index<3> &index) const;
+
+        // parameters
+        double m_Sigma;                     // noise in boundary term
+        BoundaryDirectionType m_BoundaryDirectionType;
+        typename OutputImageType::PixelType m_ForegroundPixelValue;
+        typename OutputImageType::PixelType m_BackgroundPixelValue;
+        std::size_t m_MemoryBudget;
+        std::string m_ScratchDirectory;
+        bool m_PrintTimer;
+
+        std::string m_InputFileName;
+        std::string m_ForegroundFileName;
+        std::string m_BackgroundFileName;
+        std::string m_OutputFileName;
+
+        // streaming
+        typename InputReaderType::Pointer m_InputReader;
+        typename ForegroundReaderType::Pointer m_ForegroundReader;
+        typename BackgroundReaderType::Pointer m_BackgroundReader;
+        typename WriterType::Pointer m_Writer;
+        typename InputImageType::RegionType m_LargestRegion;
+
+    private:
+        ImageGraphCut3DOutOfCoreSegmentation(const Self &); // intentionally not implemented
+        void operator=(const Self &); // intentionally not implemented
+    };
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+
+#include "ImageGraphCut3DOutOfCoreSegmentation.hxx"
+
+#endif
+
+#endif //__ImageGraphCut3DOutOfCoreSegmentation_h_
@@ -0,0 +1,250 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DOutOfCoreSegmentation_hxx_
+#define __ImageGraphCut3DOutOfCoreSegmentation_hxx_
+
+#include "ImageGraphCut3DOutOfCoreSegmentation.h"
+
+#include "itkTimeProbesCollectorBase.h"
+#include "itkShapedNeighborhoodIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageIORegion.h"
+
+// STL
+#include <cfloat>
+#include <exception>
+
+namespace itk {
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::ImageGraphCut3DOutOfCoreSegmentation()
+            : m_Sigma(5.0),
+              m_BoundaryDirectionType(NoDirection),
+              m_ForegroundPixelValue(255),
+              m_BackgroundPixelValue(0),
+              m_MemoryBudget(1024 * 1024 * 1024),
+              m_ScratchDirectory("."),
+              m_PrintTimer(false) {
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::~ImageGraphCut3DOutOfCoreSegmentation() {
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::Update() {
+        itk::TimeProbesCollectorBase timer;
+
+        timer.Start("ITK init");
+        // only the image information is read here
+        m_InputReader = InputReaderType::New();
+        m_InputReader->SetFileName(m_InputFileName);
+        m_InputReader->UpdateOutputInformation();
+        m_ForegroundReader = ForegroundReaderType::New();
+        m_ForegroundReader->SetFileName(m_ForegroundFileName);
+        m_ForegroundReader->UpdateOutputInformation();
+        m_BackgroundReader = BackgroundReaderType::New();
+        m_BackgroundReader->SetFileName(m_BackgroundFileName);
+        m_BackgroundReader->UpdateOutputInformation();
+
+        m_LargestRegion = m_InputReader->GetOutput()->GetLargestPossibleRegion();
+        if (m_ForegroundReader->GetOutput()->GetLargestPossibleRegion() != m_LargestRegion ||
+            m_BackgroundReader->GetOutput()->GetLargestPossibleRegion() != m_LargestRegion) {
+            itkExceptionMacro(<< "The foreground and background masks must have the same size as the input image");
+        }
+
+        m_Writer = WriterType::New();
+        m_Writer->SetFileName(m_OutputFileName);
+        typename InputImageType::SizeType size = m_LargestRegion.GetSize();
+        timer.Stop("ITK init");
+
+        try {
+            GraphType graph(size[0], size[1], size[2], m_MemoryBudget, m_ScratchDirectory);
+            unsigned int planesPerBlock = graph.getPlanesPerBlock();
+
+            // create graph
+            timer.Start("Graph init");
+            for (unsigned int plane = 0; plane < size[2]; plane += planesPerBlock) {
+                FillBlock(graph, GetPlanes(plane, std::min<unsigned int>(planesPerBlock, size[2] - plane)));
+            }
+            timer.Stop("Graph init");
+
+            // cut graph
+            timer.Start("Graph cut");
+            graph.calculateMaxFlow();
+            timer.Stop("Graph cut");
+
+            timer.Start("Query results");
+            for (unsigned int plane = 0; plane < size[2]; plane += planesPerBlock) {
+                CutBlock(graph, GetPlanes(plane, std::min<unsigned int>(planesPerBlock, size[2] - plane)));
+            }
+            timer.Stop("Query results");
+        }
+        catch (std::exception &e) {
+            itkExceptionMacro(<< e.what());
+        }
+
+        m_InputReader = NULL;
+        m_ForegroundReader = NULL;
+        m_BackgroundReader = NULL;
+        m_Writer = NULL;
+
+        if (m_PrintTimer) {
+            timer.Report(std::cout);
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::FillBlock(GraphType &graph, typename InputImageType::RegionType blockRegion) {
+        // the edges to the front reach into the first plane of the next block
+        typename InputImageType::RegionType inputRegion = blockRegion;
+        if (blockRegion.GetUpperIndex()[2] < m_LargestRegion.GetUpperIndex()[2]) {
+            inputRegion.SetSize(2, blockRegion.GetSize(2) + 1);
+        }
+        ReadRegion(m_InputReader.GetPointer(), inputRegion);
+        const InputImageType *input = m_InputReader->GetOutput();
+
+        // the same 6-connected edges as ImageGraphCut3DKolmogorovBoostBase::FillGraph()
+        itk::Size<3> radius;
+        radius.Fill(1);
+
+        typedef itk::ConstShapedNeighborhoodIterator<InputImageType> IteratorType;
+
+        std::vector<typename IteratorType::OffsetType> neighbors;
+        typename IteratorType::OffsetType bottom = {{0, 1, 0}};
+        neighbors.push_back(bottom);
+        typename IteratorType::OffsetType right = {{1, 0, 0}};
+        neighbors.push_back(right);
+        typename IteratorType::OffsetType front = {{0, 0, 1}};
+        neighbors.push_back(front);
+
+        typename IteratorType::OffsetType center = {{0, 0, 0}};
+
+        IteratorType iterator(radius, input, blockRegion);
+        iterator.ClearActiveList();
+        iterator.ActivateOffset(bottom);
+        iterator.ActivateOffset(right);
+        iterator.ActivateOffset(front);
+        iterator.ActivateOffset(center);
+
+        for (iterator.GoToBegin(); !iterator.IsAtEnd(); ++iterator) {
+            typename InputImageType::PixelType centerPixel = iterator.GetPixel(center);
+
+            for (unsigned int i = 0; i < neighbors.size(); i++) {
+                bool pixelIsValid;
+                typename InputImageType::PixelType neighborPixel = iterator.GetPixel(neighbors[i], pixelIsValid);
+
+                // If the current neighbor is outside the image, skip it
+                if (!pixelIsValid || !m_LargestRegion.IsInside(iterator.GetIndex(neighbors[i]))) {
+                    continue;
+                }
+
+                // Compute the edge weight
+                double weight = exp(-pow(centerPixel - neighborPixel, 2) / (2.0 * m_Sigma * m_Sigma));
+                assert(weight >= 0);
+
+                NodeType nodeIndex1 = ConvertIndexToVertexDescriptor(iterator.GetIndex(center));
+                NodeType nodeIndex2 = ConvertIndexToVertexDescriptor(iterator.GetIndex(neighbors[i]));
+
+                //Determine which direction is used
+                if (m_BoundaryDirectionType == BrightDark) {
+                    if (centerPixel > neighborPixel)
+                        graph.addBidirectionalEdge(nodeIndex1, nodeIndex2, weight, 1.0);
+                    else
+                        graph.addBidirectionalEdge(nodeIndex1, nodeIndex2, 1.0, weight);
+                } else if (m_BoundaryDirectionType == DarkBright) {
+                    if (centerPixel > neighborPixel)
+                        graph.addBidirectionalEdge(nodeIndex1, nodeIndex2, 1.0, weight);
+                    else
+                        graph.addBidirectionalEdge(nodeIndex1, nodeIndex2, weight, 1.0);
+                } else {
+                    graph.addBidirectionalEdge(nodeIndex1, nodeIndex2, weight, weight);
+                }
+            }
+        }
+
+        // set the terminal connection capacity to max float
+        ReadRegion(m_ForegroundReader.GetPointer(), blockRegion);
+        itk::ImageRegionConstIteratorWithIndex<ForegroundImageType> foregroundIterator(m_ForegroundReader->GetOutput(), blockRegion);
+        for (; !foregroundIterator.IsAtEnd(); ++foregroundIterator) {
+            if (foregroundIterator.Get() > itk::NumericTraits<typename ForegroundImageType::PixelType>::Zero) {
+                graph.addTerminalEdges(ConvertIndexToVertexDescriptor(foregroundIterator.GetIndex()), FLT_MAX, 0);
+            }
+        }
+
+        ReadRegion(m_BackgroundReader.GetPointer(), blockRegion);
+        itk::ImageRegionConstIteratorWithIndex<BackgroundImageType> backgroundIterator(m_BackgroundReader->GetOutput(), blockRegion);
+        for (; !backgroundIterator.IsAtEnd(); ++backgroundIterator) {
+            if (backgroundIterator.Get() > itk::NumericTraits<typename BackgroundImageType::PixelType>::Zero) {
+                graph.addTerminalEdges(ConvertIndexToVertexDescriptor(backgroundIterator.GetIndex()), 0, FLT_MAX);
+            }
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::CutBlock(GraphType &graph, typename OutputImageType::RegionType blockRegion) {
+        // an image of the full size with only the block buffered, the writer pastes it into the output file
+        typename OutputImageType::Pointer output = OutputImageType::New();
+        output->CopyInformation(m_InputReader->GetOutput());
+        output->SetBufferedRegion(blockRegion);
+        output->SetRequestedRegion(blockRegion);
+        output->Allocate();
+
+        int sourceGroup = graph.groupOfSource();
+        itk::ImageRegionIteratorWithIndex<OutputImageType> outputImageIterator(output, blockRegion);
+        for (; !outputImageIterator.IsAtEnd(); ++outputImageIterator) {
+            if (graph.groupOf(ConvertIndexToVertexDescriptor(outputImageIterator.GetIndex())) == sourceGroup) {
+                outputImageIterator.Set(m_ForegroundPixelValue);
+            } else {
+                outputImageIterator.Set(m_BackgroundPixelValue);
+            }
+        }
+
+        ImageIORegion ioRegion(3);
+        ImageIORegionAdaptor<3>::Convert(blockRegion, ioRegion, m_LargestRegion.GetIndex());
+        m_Writer->SetInput(output);
+        m_Writer->SetIORegion(ioRegion);
+        m_Writer->Update();
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    typename TImage::RegionType ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::GetPlanes(unsigned int firstPlane, unsigned int numberOfPlanes) const {
+        typename InputImageType::RegionType region = m_LargestRegion;
+        region.SetIndex(2, m_LargestRegion.GetIndex(2) + firstPlane);
+        region.SetSize(2, numberOfPlanes);
+        return region;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    template<typename TReader>
+    void ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::ReadRegion(TReader *reader, typename TReader::OutputImageType::RegionType region) {
+        reader->GetOutput()->SetRequestedRegion(region);
+        reader->GetOutput()->Update();
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    typename ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>::NodeType
+    ImageGraphCut3DOutOfCoreSegmentation<TImage, TForeground, TBackground, TOutput>
+    ::ConvertIndexToVertexDescriptor(const itk::Index<3> &index) const {
+        typename InputImageType::SizeType size = m_LargestRegion.GetSize();
+        typename InputImageType::IndexType start = m_LargestRegion.GetIndex();
+
+        return (index[0] - start[0]) + (index[1] - start[1]) * (NodeType) size[0]
+               + (index[2] - start[2]) * (NodeType) size[0] * size[1];
+    }
+} // namespace itk
+
+#endif // __ImageGraphCut3DOutOfCoreSegmentation_hxx_
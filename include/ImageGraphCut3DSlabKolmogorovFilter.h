@@ -0,0 +1,157 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DSlabKolmogorovFilter_h_
+#define __ImageGraphCut3DSlabKolmogorovFilter_h_
+
+#include "lib/kolmogorov-3.03/graph.h"
+#include "ImageGraphCut3DKolmogorovBoostBase.h"
+
+// STL
+#include <vector>
+
+namespace itk{
+    //! GraphCut solver splitting the volume into overlapping z-slabs which are solved in parallel
+    /*
+     * Every slab is an independent Kolmogorov graph. Two neighbouring slabs share one z-plane; the nodes of that plane
+     * exist in both graphs and their terminal weights are split in half. The slabs are solved on their own thread and
+     * the labels of the shared nodes are reconciled by dual decomposition (Strandmark & Kahl, CVPR 2010): a lagrange
+     * multiplier per shared node is moved along the label disagreement and the affected slabs are solved again,
+     * reusing their search trees. Once all shared nodes agree the cut is globally optimal. If that does not happen
+     * within the configured number of iterations, the whole volume is solved in a single graph instead.
+     */
+    template<typename TInput, typename TForeground, typename TBackground, typename TOutput>
+    class ImageGraphCut3DSlabKolmogorovFilter : public ImageGraphCut3DKolmogorovBoostBase<TInput, TForeground, TBackground, TOutput>{
+    public:
+        // ITK related defaults
+        typedef ImageGraphCut3DSlabKolmogorovFilter Self;
+        typedef ImageGraphCut3DKolmogorovBoostBase<TInput, TForeground, TBackground, TOutput> SuperClass;
+        typedef SmartPointer<Self> Pointer;
+        typedef SmartPointer<const Self> ConstPointer;
+
+        itkNewMacro(Self);
+        itkTypeMacro(ImageGraphCut3DSlabKolmogorovFilter, ImageGraphCut3DKolmogorovBoostBase);
+
+        typedef typename SuperClass::InputImageType InputImageType;
+
+        typedef typename SuperClass::ForegroundImageType ForegroundImageType;
+        typedef typename SuperClass::BackgroundImageType BackgroundImageType;
+        typedef typename SuperClass::OutputImageType OutputImageType;
+        typedef typename SuperClass::IndexContainerType IndexContainerType;     // container for sinks / sources
+        typedef typename SuperClass::WeightType WeightType;
+
+        typedef typename SuperClass::ImageContainer ImageContainer;
+        typedef Graph<WeightType, WeightType, WeightType> GraphType;
+
+        // parameter setters
+        // 0 creates one slab per thread
+        void SetNumberOfSlabs(unsigned int n) {
+            m_NumberOfSlabs = n;
+        }
+
+        void SetMaximumNumberOfDualIterations(unsigned int n) {
+            m_MaximumNumberOfDualIterations = n;
+        }
+
+        void SetDualStepSize(double d) {
+            m_DualStepSize = d;
+        }
+
+        // result of the last SolveGraph()
+        unsigned int GetNumberOfDualIterations() const {
+            return m_NumberOfDualIterations;
+        }
+
+        bool GetDualDecompositionConverged() const {
+            return m_DualDecompositionConverged;
+        }
+
+        virtual void InitializeGraph(const ImageContainer) override;
+
+        virtual void addBidirectionalEdge(const unsigned int source, const unsigned int target, const float weight, const float reverseWeight) override;
+
+        virtual void addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight) override;
+
+        virtual void SolveGraph() override;
+
+        // query the resulting segmentation group of a vertex.
+        virtual int groupOf(const unsigned int vertex) const override;
+
+        virtual int groupOfSource() override{
+            return (short) GraphType::SOURCE;
+        }
+
+        virtual int groupOfSink() override{
+            return (short) GraphType::SINK;
+        }
+
+        virtual unsigned int getNumberOfVertices() override;
+
+        virtual unsigned int getNumberOfEdges() override;
+
+    protected:
+        struct Slab {
+            unsigned int firstPlane;    // first z-plane, shared with the previous slab (except for the first slab)
+            unsigned int lastPlane;     // last z-plane, shared with the next slab (except for the last slab)
+            GraphType* graph;
+        };
+
+        ImageGraphCut3DSlabKolmogorovFilter();
+
+        virtual ~ImageGraphCut3DSlabKolmogorovFilter();
+
+        void ReleaseGraphs();
+
+        // solves all slabs flagged in needsSolve on their own thread
+        void SolveSlabs(const std::vector<bool> &needsSolve, bool reuseTrees);
+
+        // falls back to solving the whole volume in one graph
+        void SolveMonolithic();
+
+        // adds a multiplier to the cost of assigning a node to the sink
+        void addMultiplier(GraphType* graph, const int node, const WeightType multiplier);
+
+        // the slab containing both planes. in-plane edges on a shared plane belong to the lower slab.
+        inline unsigned int slabOfPlanes(const unsigned int planeA, const unsigned int planeB) const {
+            return m_PlaneToSlab[std::max(planeA, planeB)];
+        }
+
+        inline int localNode(const unsigned int slab, const unsigned int vertex) const {
+            return (int) (vertex - m_Slabs[slab].firstPlane * m_SliceSize);
+        }
+
+        // parameters
+        unsigned int m_NumberOfSlabs;
+        unsigned int m_MaximumNumberOfDualIterations;
+        double m_DualStepSize;
+
+        // results
+        unsigned int m_NumberOfDualIterations;
+        bool m_DualDecompositionConverged;
+
+        // decomposition
+        unsigned int m_SliceSize;
+        std::vector<Slab> m_Slabs;
+        std::vector<unsigned int> m_PlaneToSlab;   // lowest slab containing a plane
+        GraphType* m_MonolithicGraph;
+        bool m_FillingMonolithicGraph;
+
+    private:
+        ImageGraphCut3DSlabKolmogorovFilter(const Self &); // intentionally not implemented
+        void operator=(const Self &); // intentionally not implemented
+    };
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+
+#include "ImageGraphCut3DSlabKolmogorovFilter.hxx"
+
+#endif
+
+#endif //__ImageGraphCut3DSlabKolmogorovFilter_h_
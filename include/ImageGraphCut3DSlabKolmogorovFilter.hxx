@@ -0,0 +1,289 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageGraphCut3DSlabKolmogorovFilter_hxx_
+#define __ImageGraphCut3DSlabKolmogorovFilter_hxx_
+
+#include "ImageGraphCut3DSlabKolmogorovFilter.h"
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace itk {
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::ImageGraphCut3DSlabKolmogorovFilter()
+            : m_NumberOfSlabs(0),
+              m_MaximumNumberOfDualIterations(100),
+              m_DualStepSize(0.5),
+              m_NumberOfDualIterations(0),
+              m_DualDecompositionConverged(false),
+              m_SliceSize(0),
+              m_MonolithicGraph(NULL),
+              m_FillingMonolithicGraph(false) {
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::~ImageGraphCut3DSlabKolmogorovFilter() {
+        ReleaseGraphs();
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::ReleaseGraphs() {
+        for (unsigned int i = 0; i < m_Slabs.size(); ++i) {
+            delete m_Slabs[i].graph;
+        }
+        m_Slabs.clear();
+        delete m_MonolithicGraph;
+        m_MonolithicGraph = NULL;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::InitializeGraph(const ImageContainer images) {
+        // the fallback refills the graph which SolveMonolithic() already allocated
+        if (m_FillingMonolithicGraph) {
+            return;
+        }
+
+        // the slabs are found from the plane of a node
+        if (this->m_NodeOrder != SuperClass::RasterOrder) {
+            itkExceptionMacro(<< "The slab decomposition requires the raster node order");
+        }
+
+        ReleaseGraphs();
+
+        typename InputImageType::SizeType dimensions = images.input->GetLargestPossibleRegion().GetSize();
+        m_SliceSize = dimensions[0] * dimensions[1];
+        unsigned int numberOfPlanes = dimensions[2];
+
+        // neighbouring slabs share a plane, so each slab needs at least two planes
+        unsigned int numberOfSlabs = m_NumberOfSlabs > 0 ? m_NumberOfSlabs : this->GetNumberOfThreads();
+        numberOfSlabs = std::max(1u, std::min(numberOfSlabs, numberOfPlanes - 1));
+
+        m_Slabs.resize(numberOfSlabs);
+        m_PlaneToSlab.assign(numberOfPlanes, 0);
+        for (unsigned int iSlab = 0; iSlab < numberOfSlabs; ++iSlab) {
+            Slab &slab = m_Slabs[iSlab];
+            slab.firstPlane = (iSlab * (numberOfPlanes - 1)) / numberOfSlabs;
+            slab.lastPlane = ((iSlab + 1) * (numberOfPlanes - 1)) / numberOfSlabs;
+            for (unsigned int iPlane = slab.firstPlane + 1; iPlane <= slab.lastPlane; ++iPlane) {
+                m_PlaneToSlab[iPlane] = iSlab;
+            }
+
+            int numberOfVertices = (slab.lastPlane - slab.firstPlane + 1) * m_SliceSize;
+            slab.graph = new GraphType(numberOfVertices, 3 * numberOfVertices);
+            slab.graph->add_node(numberOfVertices);
+        }
+
+        if (this->m_PrintTimer) {
+            std::cout << "Number of slabs: " << numberOfSlabs << ", planes per slab: "
+                      << m_Slabs[0].lastPlane - m_Slabs[0].firstPlane + 1 << std::endl;
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::addBidirectionalEdge(const unsigned int source, const unsigned int target, const float weight, const float reverseWeight) {
+        if (m_MonolithicGraph) {
+            m_MonolithicGraph->add_edge(source, target, weight, reverseWeight);
+            return;
+        }
+
+        unsigned int slab = slabOfPlanes(source / m_SliceSize, target / m_SliceSize);
+        m_Slabs[slab].graph->add_edge(localNode(slab, source), localNode(slab, target), weight, reverseWeight);
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::addTerminalEdges(const unsigned int node, const float sourceWeight, const float sinkWeight) {
+        if (m_MonolithicGraph) {
+            m_MonolithicGraph->add_tweights(node, sourceWeight, sinkWeight);
+            return;
+        }
+
+        unsigned int plane = node / m_SliceSize;
+        unsigned int slab = m_PlaneToSlab[plane];
+
+        // nodes on a shared plane exist in both slabs, each of them gets half of the terminal weights
+        if (plane == m_Slabs[slab].lastPlane && slab + 1 < m_Slabs.size()) {
+            m_Slabs[slab].graph->add_tweights(localNode(slab, node), sourceWeight / 2, sinkWeight / 2);
+            m_Slabs[slab + 1].graph->add_tweights(localNode(slab + 1, node), sourceWeight / 2, sinkWeight / 2);
+        } else {
+            m_Slabs[slab].graph->add_tweights(localNode(slab, node), sourceWeight, sinkWeight);
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::addMultiplier(GraphType* graph, const int node, const WeightType multiplier) {
+        if (multiplier > 0) {
+            graph->add_tweights(node, multiplier, 0);
+        } else {
+            graph->add_tweights(node, 0, -multiplier);
+        }
+        graph->mark_node(node);
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::SolveSlabs(const std::vector<bool> &needsSolve, bool reuseTrees) {
+        std::vector<unsigned int> pending;
+        for (unsigned int iSlab = 0; iSlab < needsSolve.size(); ++iSlab) {
+            if (needsSolve[iSlab]) {
+                pending.push_back(iSlab);
+            }
+        }
+
+        // every thread keeps taking slabs until none are left
+        std::atomic<unsigned int> nextSlab(0);
+        auto worker = [&]() {
+            for (unsigned int i = nextSlab++; i < pending.size(); i = nextSlab++) {
+                m_Slabs[pending[i]].graph->maxflow(reuseTrees);
+            }
+        };
+
+        unsigned int numberOfThreads = std::min<unsigned int>(this->GetNumberOfThreads(), pending.size());
+        std::vector<std::thread> threads;
+        for (unsigned int iThread = 1; iThread < numberOfThreads; ++iThread) {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (unsigned int iThread = 0; iThread < threads.size(); ++iThread) {
+            threads[iThread].join();
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::SolveGraph() {
+        m_NumberOfDualIterations = 0;
+        m_DualDecompositionConverged = false;
+
+        std::vector<bool> needsSolve(m_Slabs.size(), true);
+        SolveSlabs(needsSolve, false);
+
+        double stepSize = m_DualStepSize;
+        while (true) {
+            // compare the labels of the shared planes and move the multipliers along the disagreement
+            unsigned int numberOfDisagreements = 0;
+            std::fill(needsSolve.begin(), needsSolve.end(), false);
+            for (unsigned int iSlab = 1; iSlab < m_Slabs.size(); ++iSlab) {
+                Slab &lower = m_Slabs[iSlab - 1];
+                Slab &upper = m_Slabs[iSlab];
+                int lowerOffset = (upper.firstPlane - lower.firstPlane) * m_SliceSize;
+
+                for (unsigned int i = 0; i < m_SliceSize; ++i) {
+                    typename GraphType::termtype lowerSegment = lower.graph->what_segment(lowerOffset + i);
+                    typename GraphType::termtype upperSegment = upper.graph->what_segment(i);
+                    if (lowerSegment == upperSegment) {
+                        continue;
+                    }
+
+                    // supergradient of the dual: x_lower - x_upper, with x = 1 for the sink
+                    WeightType multiplier = (lowerSegment == GraphType::SINK) ? stepSize : -stepSize;
+                    addMultiplier(lower.graph, lowerOffset + i, multiplier);
+                    addMultiplier(upper.graph, i, -multiplier);
+                    needsSolve[iSlab - 1] = true;
+                    needsSolve[iSlab] = true;
+                    ++numberOfDisagreements;
+                }
+            }
+
+            if (numberOfDisagreements == 0) {
+                m_DualDecompositionConverged = true;
+                break;
+            }
+            if (m_NumberOfDualIterations >= m_MaximumNumberOfDualIterations) {
+                break;
+            }
+
+            SolveSlabs(needsSolve, true);
+            ++m_NumberOfDualIterations;
+            stepSize = m_DualStepSize / std::sqrt(m_NumberOfDualIterations + 1.0);
+        }
+
+        if (this->m_PrintTimer) {
+            std::cout << "Dual decomposition: " << m_NumberOfDualIterations << " iterations, "
+                      << (m_DualDecompositionConverged ? "converged" : "not converged") << std::endl;
+        }
+
+        if (!m_DualDecompositionConverged) {
+            itkWarningMacro(<< "Slabs did not agree after " << m_NumberOfDualIterations
+                            << " dual iterations, solving the whole volume at once.");
+            SolveMonolithic();
+        }
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    void ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::SolveMonolithic() {
+        ReleaseGraphs();
+
+        typename InputImageType::SizeType dimensions = this->m_Images.input->GetLargestPossibleRegion().GetSize();
+        int numberOfVertices = dimensions[0] * dimensions[1] * dimensions[2];
+        m_MonolithicGraph = new GraphType(numberOfVertices, 3 * numberOfVertices);
+        m_MonolithicGraph->add_node(numberOfVertices);
+
+        ProgressReporter progress(this, 0, this->m_Images.inputRegion.GetNumberOfPixels());
+        m_FillingMonolithicGraph = true;
+        SuperClass::FillGraph(this->m_Images, progress);
+        m_FillingMonolithicGraph = false;
+
+        m_MonolithicGraph->maxflow();
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    int ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::groupOf(const unsigned int vertex) const {
+        if (m_MonolithicGraph) {
+            return (short) m_MonolithicGraph->what_segment(vertex);
+        }
+
+        // the slabs agree on the shared planes, so the lower one can answer for them
+        unsigned int slab = m_PlaneToSlab[vertex / m_SliceSize];
+        return (short) m_Slabs[slab].graph->what_segment(localNode(slab, vertex));
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    unsigned int ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::getNumberOfVertices() {
+        if (m_MonolithicGraph) {
+            return m_MonolithicGraph->get_node_num();
+        }
+
+        // nodes on the shared planes are counted once
+        unsigned int numberOfVertices = 0;
+        for (unsigned int i = 0; i < m_Slabs.size(); ++i) {
+            numberOfVertices += m_Slabs[i].graph->get_node_num();
+        }
+        return numberOfVertices - (m_Slabs.size() - 1) * m_SliceSize;
+    }
+
+    template<typename TImage, typename TForeground, typename TBackground, typename TOutput>
+    unsigned int ImageGraphCut3DSlabKolmogorovFilter<TImage, TForeground, TBackground, TOutput>
+    ::getNumberOfEdges() {
+        if (m_MonolithicGraph) {
+            return m_MonolithicGraph->get_arc_num();
+        }
+
+        unsigned int numberOfEdges = 0;
+        for (unsigned int i = 0; i < m_Slabs.size(); ++i) {
+            numberOfEdges += m_Slabs[i].graph->get_arc_num();
+        }
+        return numberOfEdges;
+    }
+}
+
+#endif //__ImageGraphCut3DSlabKolmogorovFilter_hxx_
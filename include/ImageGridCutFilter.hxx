@@ -78,18 +78,69 @@ namespace itk {
         }
 
         CapacityType capacities(neighbors.size() + 2, std::vector<WeightType>(nGraphNodes, 0));
+
+        // the cost images are the initial terminal capacities, they have the layout of the capacity planes
+        if (images.sourceCost)
+            std::copy(images.sourceCost->GetBufferPointer(), images.sourceCost->GetBufferPointer() + nGraphNodes,
+                      capacities[0].begin());
+        if (images.sinkCost)
+            std::copy(images.sinkCost->GetBufferPointer(), images.sinkCost->GetBufferPointer() + nGraphNodes,
+                      capacities[1].begin());
+
+        // precomputed boundary weights are copied into the planes of both directions of each dimension, with the
+        // boundary direction as in the sweep. The sweep then only fills the terminal capacities.
+        if (images.boundaryWeights) {
+            const typename InputImageType::PixelType *pixels = images.input->GetBufferPointer();
+            SizeValueType strides[3] = {1, graphSize[0], graphSize[0] * graphSize[1]};
+            for (unsigned int d = 0; d < 3; ++d) {
+                std::vector<WeightType> &lower = capacities[2 + 2 * d];     // to the neighbor at -1
+                std::vector<WeightType> &upper = capacities[3 + 2 * d];     // to the neighbor at +1
+                for (SizeValueType voxel = 0; voxel < nGraphNodes; ++voxel) {
+                    if ((voxel / strides[d]) % graphSize[d] + 1 < graphSize[d]) {
+                        WeightType weight = this->GetBoundaryWeight(images, voxel, d);
+                        SizeValueType neighbor = voxel + strides[d];
+                        bool brighter = pixels[voxel] > pixels[neighbor];
+                        if (this->m_BoundaryDirectionType == SuperClass::BrightDark) {
+                            upper[voxel] = brighter ? weight : 1.0;
+                            lower[neighbor] = brighter ? 1.0 : weight;
+                        } else if (this->m_BoundaryDirectionType == SuperClass::DarkBright) {
+                            upper[voxel] = brighter ? 1.0 : weight;
+                            lower[neighbor] = brighter ? weight : 1.0;
+                        } else {
+                            upper[voxel] = weight;
+                            lower[neighbor] = weight;
+                        }
+                    }
+                }
+            }
+        }
+
+        bool hasRegionalTerm = this->HasRegionalTerm();
         unsigned int iVoxel(0);
         for (iterator.GoToBegin(); !iterator.IsAtEnd(); ++iterator, ++iVoxel) {
             typename InputImageType::PixelType centerPixel = iterator.GetPixel(center);
             // Add the edge to the graph
             itk::Index<3> currentNodeIndex = iterator.GetIndex(center);
 
+            // regional term of the voxel
+            if (hasRegionalTerm) {
+                WeightType sourceWeight, sinkWeight;
+                this->GetRegionalWeights(centerPixel, sourceWeight, sinkWeight);
+                capacities[0][iVoxel] += sourceWeight;
+                capacities[1][iVoxel] += sinkWeight;
+            }
+
             // Fill the source
             if (images.foreground->GetPixel(currentNodeIndex) > itk::NumericTraits<typename ForegroundImageType::PixelType>::Zero)
                 capacities[0][iVoxel] =  std::numeric_limits<float>::max();
             if (images.background->GetPixel(currentNodeIndex) > itk::NumericTraits<typename BackgroundImageType::PixelType>::Zero)
                 capacities[1][iVoxel] =  std::numeric_limits<float>::max();
 
+            if (images.boundaryWeights) {
+                progress.CompletedPixel();
+                continue;
+            }
+
             for (unsigned int i = 0; i < neighbors.size(); i++) {
                 bool pixelIsValid;
                 typename InputImageType::PixelType neighborPixel  = iterator.GetPixel(neighbors[i], pixelIsValid);
@@ -112,6 +163,7 @@ namespace itk {
                             capacities[i + 2][iVoxel] = weight;
                         else
                             capacities[i + 2][iVoxel] = 1.0;
+                        break;
                     }
 
                     case SuperClass::DarkBright:{
@@ -119,6 +171,7 @@ namespace itk {
                             capacities[i + 2][iVoxel] = 1.0;
                         else
                             capacities[i + 2][iVoxel] = weight;
+                        break;
                     }
 
                     default:
@@ -20,8 +20,14 @@
 #include "itkHistogram.h"
 #include "itkListSample.h"
 #include "itkProgressReporter.h"
+#include "MultiLabelEnergy.hxx"
 
 // STL
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <thread>
 #include <vector>
 
 namespace itk {
@@ -47,6 +53,8 @@ namespace itk {
         typedef itk::Statistics::Histogram<short, itk::Statistics::DenseFrequencyContainer2> HistogramType;
         typedef std::vector<itk::Index<3> > IndexContainerType;     // container for sinks / sources
         typedef unsigned char WeightType;
+        typedef typename MultiLabelImageType::PixelType LabelPixelType;
+        typedef unsigned short LabelType;       // number of a label, 0 ... number of labels - 1
 
         typedef enum {
             NoDirection, BrightDark, DarkBright
@@ -82,6 +90,40 @@ namespace itk {
          void SetVerboseOutput(bool b) {
             m_PrintTimer = b;
         }
+
+        // A cycle moves every label (or pair of labels) once. The cycles stop when one does not lower the energy, after
+        // this many cycles, when one lowers the energy by less than the relative tolerance or when the time budget is
+        // used up. The criteria are checked after every cycle.
+        void SetMaximumNumberOfCycles(unsigned int n) {
+            m_MaximumNumberOfCycles = n;
+        }
+
+        unsigned int GetMaximumNumberOfCycles() const {
+            return m_MaximumNumberOfCycles;
+        }
+
+        // 0 runs until the energy stops decreasing
+        void SetRelativeEnergyTolerance(double d) {
+            m_RelativeEnergyTolerance = d;
+        }
+
+        // seconds for all cycles, 0 for no limit
+        void SetTimeBudget(double d) {
+            m_TimeBudget = d;
+        }
+
+        // energy after every cycle of the last update and the seconds the cycle took
+        const std::vector<double> &GetCycleEnergies() const {
+            return m_CycleEnergies;
+        }
+
+        const std::vector<double> &GetCycleTimes() const {
+            return m_CycleTimes;
+        }
+
+        unsigned int GetNumberOfPerformedCycles() const {
+            return m_CycleEnergies.size();
+        }
     protected:
         struct ImageContainer {
             typename InputImageType::ConstPointer input;
@@ -114,6 +156,61 @@ namespace itk {
         // convert 3d itk indices to a continuously numbered indices
         unsigned int ConvertIndexToVertexDescriptor(const itk::Index<3>, typename InputImageType::RegionType);
 
+        // Calls slabFunction(slab, firstPlane, endPlane) for slabs of planes [firstPlane, endPlane) of an image with
+        // the given number of planes, one slab per thread of the filter and the first one on the calling thread.
+        // Returns the number of slabs.
+        template<typename TSlabFunction>
+        unsigned int ForEachSlab(SizeValueType depth, TSlabFunction slabFunction) const;
+
+        // Scans the multi-label image once in slabs on the threads of the filter: numbers the values > 0 in the order
+        // of their first voxel (m_LabelValues) and collects the labeled voxels as seeds of the sparse data costs. 8 and
+        // 16 bit label values are looked up in a table.
+        void ComputeDataCosts(const ImageContainer &images);
+
+        // the cost of a voxel taking a label other than its seed's, also the cost of every label of an unseeded voxel
+        static WeightType GetWeightFactor() {
+            if (std::numeric_limits<WeightType>::max() < std::numeric_limits<float>::max())
+                return std::numeric_limits<WeightType>::max();
+            return 1000;
+        }
+
+        // Computes the smoothness costs in factorized form: the cost of two neighbors taking the labels l and l' is the
+        // weight of their edge times the entry (l, l') of a matrix shared by all edges. Fills m_EdgeWeights and
+        // m_LabelCosts in slabs on the threads of the filter, reports one completed pixel per voxel. reuseEdgeWeights
+        // keeps the edge weights of the last call, see EdgeWeightsAreCurrent().
+        void ComputeSmoothnessCosts(const ImageContainer &images, unsigned int numberOfLabels,
+                                    ProgressReporter &progress, bool reuseEdgeWeights = false);
+
+        // true if the edge weights were computed from the same input image, unmodified since, and sigma
+        bool EdgeWeightsAreCurrent(const ImageContainer &images) const {
+            return m_EdgeWeightsInput == images.input.GetPointer() && m_EdgeWeightsSigma == m_Sigma &&
+                   m_Size == images.inputRegion.GetSize() && images.input->GetMTime() < m_EdgeWeightsTime.GetMTime();
+        }
+
+        // Numbers the labels as the given label values, e.g. those of the last update. Returns false and keeps the
+        // numbering if the label values are not the same.
+        bool RenumberLabelsAs(const std::vector<LabelPixelType> &labelValues);
+
+        // energy of a labeling given as label numbers in raster order, summed over slabs of planes on the threads of
+        // the filter
+        template<typename TLabelNumber>
+        double ComputeEnergy(const TLabelNumber *labeling) const;
+
+        void StartCycles() {
+            m_CycleEnergies.clear();
+            m_CycleTimes.clear();
+        }
+
+        // records a cycle, returns false if the cycles should stop because of the energy or the time budget
+        bool AddCycle(double energy, double seconds);
+
+        bool IsTimeBudgetExhausted() const;
+
+        // cost of the labels l and l' of two neighbors for an edge of weight 1, m_LabelCosts[l + l' * numberOfLabels]
+        WeightType GetLabelCost(unsigned int label, unsigned int otherLabel) const {
+            return m_LabelCosts[label + otherLabel * m_NumberOfLabels];
+        }
+
         // image getters
         const InputImageType *GetInputImage() {
             return static_cast< const InputImageType * >(this->ProcessObject::GetInput(0));
@@ -129,6 +226,32 @@ namespace itk {
         BoundaryDirectionType m_BoundaryDirectionType;
         bool m_PrintTimer;
 
+        std::vector<LabelPixelType> m_LabelValues;  // value of every label in the multi-label image
+
+        // data costs, see ComputeDataCosts(). Every label costs m_DefaultDataCost, except for the seeds: a voxel
+        // labeled in the multi-label image costs 0 for its own label.
+        WeightType m_DefaultDataCost;
+        std::vector<SizeValueType> m_SeedVoxels;    // in raster order
+        std::vector<LabelType> m_SeedLabels;
+
+        // smoothness costs, see ComputeSmoothnessCosts()
+        // weights of the edges of every voxel to its neighbors at +1 in x, y and z, m_EdgeWeights[3 * voxel + d]. The
+        // edges leaving the image have weight 0.
+        std::vector<WeightType> m_EdgeWeights;
+        std::vector<WeightType> m_LabelCosts;   // Potts model, 0 on the diagonal and 1 elsewhere
+        unsigned int m_NumberOfLabels;
+        typename InputImageType::SizeType m_Size;
+        const InputImageType *m_EdgeWeightsInput;  // compared only, the image of the last edge weights
+        double m_EdgeWeightsSigma;
+        TimeStamp m_EdgeWeightsTime;
+
+        // cycles
+        unsigned int m_MaximumNumberOfCycles;
+        double m_RelativeEnergyTolerance;
+        double m_TimeBudget;
+        std::vector<double> m_CycleEnergies;
+        std::vector<double> m_CycleTimes;
+
 
     private:
         ImageMultiLabelGraphCut3DFilter(const Self &); // intentionally not implemented
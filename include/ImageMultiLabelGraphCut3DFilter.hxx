@@ -18,7 +18,14 @@ namespace itk {
     ::ImageMultiLabelGraphCut3DFilter()
             : m_Sigma(5.0),
               m_BoundaryDirectionType(NoDirection),
-              m_PrintTimer(false) {
+              m_PrintTimer(false),
+              m_DefaultDataCost(0),
+              m_NumberOfLabels(0),
+              m_EdgeWeightsInput(NULL),
+              m_EdgeWeightsSigma(0),
+              m_MaximumNumberOfCycles(50),
+              m_RelativeEnergyTolerance(0),
+              m_TimeBudget(0) {
         this->SetNumberOfRequiredInputs(2);
     }
 
@@ -105,6 +112,209 @@ namespace itk {
 
         return index[0] + index[1] * size[0] + index[2] * size[0] * size[1];
     }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    template<typename TSlabFunction>
+    unsigned int ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::ForEachSlab(SizeValueType depth, TSlabFunction slabFunction) const {
+        const unsigned int numberOfThreads = std::max<SizeValueType>(1, std::min<SizeValueType>(this->GetNumberOfThreads(), depth));
+
+        auto runSlab = [&](unsigned int thread) {
+            slabFunction(thread, thread * depth / numberOfThreads, (thread + 1) * depth / numberOfThreads);
+        };
+        std::vector<std::thread> threads;
+        for (unsigned int thread = 1; thread < numberOfThreads; ++thread) {
+            threads.push_back(std::thread(runSlab, thread));
+        }
+        runSlab(0);
+        for (std::size_t thread = 0; thread < threads.size(); ++thread) {
+            threads[thread].join();
+        }
+        return numberOfThreads;
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::ComputeDataCosts(const ImageContainer &images) {
+        const typename MultiLabelImageType::SizeType size = images.multiLabel->GetLargestPossibleRegion().GetSize();
+        const SizeValueType planeSize = size[0] * size[1];
+        const LabelPixelType *labelBuffer = images.multiLabel->GetBufferPointer();
+
+        m_LabelValues.clear();
+        m_SeedVoxels.clear();
+        m_SeedLabels.clear();
+        m_DefaultDataCost = GetWeightFactor();
+
+        // the labeled voxels of every slab and their values
+        const unsigned int maximumNumberOfSlabs = std::max(1u, this->GetNumberOfThreads());
+        std::vector<std::vector<SizeValueType> > slabVoxels(maximumNumberOfSlabs);
+        std::vector<std::vector<LabelPixelType> > slabValues(maximumNumberOfSlabs);
+        const unsigned int numberOfSlabs = ForEachSlab(size[2], [&](unsigned int slab, SizeValueType firstPlane,
+                                                                    SizeValueType endPlane) {
+            for (SizeValueType voxel = firstPlane * planeSize; voxel < endPlane * planeSize; ++voxel) {
+                const LabelPixelType value = labelBuffer[voxel];
+                // Only consider the non zeros voxels
+                if (value > NumericTraits<LabelPixelType>::Zero) {
+                    slabVoxels[slab].push_back(voxel);
+                    slabValues[slab].push_back(value);
+                }
+            }
+        });
+
+        // number of the label of a value, or -1 before its first voxel
+        const bool useTable = std::numeric_limits<LabelPixelType>::is_integer && sizeof(LabelPixelType) <= 2;
+        std::vector<int> table(useTable ? std::size_t(1) << (8 * std::min<std::size_t>(sizeof(LabelPixelType), 2)) : 0, -1);
+        std::map<LabelPixelType, int> map;
+
+        // the labels are numbered in the order of their first voxel, as the slabs are in raster order
+        for (unsigned int slab = 0; slab < numberOfSlabs; ++slab) {
+            for (std::size_t seed = 0; seed < slabVoxels[slab].size(); ++seed) {
+                const LabelPixelType value = slabValues[slab][seed];
+                int &label = useTable ? table[static_cast<long>(value) - static_cast<long>(NumericTraits<LabelPixelType>::min())]
+                                      : map.insert(std::make_pair(value, -1)).first->second;
+                if (label < 0) {
+                    if (m_LabelValues.size() > std::numeric_limits<LabelType>::max()) {
+                        itkExceptionMacro(<< "More than " << std::numeric_limits<LabelType>::max() + 1 << " labels");
+                    }
+                    label = m_LabelValues.size();
+                    m_LabelValues.push_back(value);
+                }
+                m_SeedLabels.push_back(static_cast<LabelType>(label));
+            }
+            m_SeedVoxels.insert(m_SeedVoxels.end(), slabVoxels[slab].begin(), slabVoxels[slab].end());
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::ComputeSmoothnessCosts(const ImageContainer &images, unsigned int numberOfLabels, ProgressReporter &progress,
+                             bool reuseEdgeWeights) {
+        // label costs
+        m_NumberOfLabels = numberOfLabels;
+        m_LabelCosts.assign(numberOfLabels * numberOfLabels, 1);
+        for (unsigned int iLabel = 0; iLabel < numberOfLabels; ++iLabel) {
+            m_LabelCosts[iLabel + iLabel * numberOfLabels] = 0;
+        }
+
+        if (reuseEdgeWeights) {
+            for (SizeValueType voxel = 0; voxel < images.inputRegion.GetNumberOfPixels(); ++voxel) {
+                progress.CompletedPixel();
+            }
+            return;
+        }
+
+        // edge weights, one per voxel and direction, every thread fills those of a slab of planes
+        const typename InputImageType::SizeType size = images.inputRegion.GetSize();
+        m_Size = size;
+        const typename InputImageType::PixelType *buffer = images.input->GetBufferPointer();
+        const SizeValueType strides[3] = {1, size[0], size[0] * size[1]};
+        const WeightType weightFactor = GetWeightFactor();
+
+        m_EdgeWeights.resize(3 * images.inputRegion.GetNumberOfPixels());
+        const unsigned int numberOfSlabs = ForEachSlab(size[2], [&](unsigned int thread, SizeValueType firstPlane,
+                                                                    SizeValueType endPlane) {
+            SizeValueType voxel = firstPlane * strides[2];
+            for (SizeValueType z = firstPlane; z < endPlane; ++z) {
+                for (SizeValueType y = 0; y < size[1]; ++y) {
+                    for (SizeValueType x = 0; x < size[0]; ++x, ++voxel) {
+                        const SizeValueType coordinates[3] = {x, y, z};
+                        const typename InputImageType::PixelType centerPixel = buffer[voxel];
+                        for (unsigned int d = 0; d < 3; ++d) {
+                            // the neighbor is outside the image
+                            if (coordinates[d] + 1 >= size[d]) {
+                                m_EdgeWeights[3 * voxel + d] = 0;
+                                continue;
+                            }
+
+                            const typename InputImageType::PixelType neighborPixel = buffer[voxel + strides[d]];
+                            double weightTmp = 1;
+                            if (centerPixel >= neighborPixel) {
+                                const double difference = static_cast<double>(centerPixel) - neighborPixel;
+                                weightTmp = exp(-difference * difference / (2.0 * m_Sigma * m_Sigma));
+                            }
+                            m_EdgeWeights[3 * voxel + d] = static_cast<WeightType>(((weightFactor - 1) / 6.0) * weightTmp);
+                        }
+                        // the progress reporter is not thread safe, the other slabs are reported below
+                        if (thread == 0) {
+                            progress.CompletedPixel();
+                        }
+                    }
+                }
+            }
+        });
+
+        for (SizeValueType voxel = size[2] / numberOfSlabs * strides[2]; voxel < images.inputRegion.GetNumberOfPixels(); ++voxel) {
+            progress.CompletedPixel();
+        }
+
+        m_EdgeWeightsInput = images.input.GetPointer();
+        m_EdgeWeightsSigma = m_Sigma;
+        m_EdgeWeightsTime.Modified();
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    bool ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::RenumberLabelsAs(const std::vector<LabelPixelType> &labelValues) {
+        if (labelValues.size() != m_LabelValues.size()) {
+            return false;
+        }
+
+        // the given number of every current label
+        std::vector<LabelType> numbers(m_LabelValues.size());
+        for (unsigned int iLabel = 0; iLabel < m_LabelValues.size(); ++iLabel) {
+            const typename std::vector<LabelPixelType>::const_iterator value =
+                    std::find(labelValues.begin(), labelValues.end(), m_LabelValues[iLabel]);
+            if (value == labelValues.end()) {
+                return false;
+            }
+            numbers[iLabel] = static_cast<LabelType>(value - labelValues.begin());
+        }
+
+        for (std::size_t iSeed = 0; iSeed < m_SeedLabels.size(); ++iSeed) {
+            m_SeedLabels[iSeed] = numbers[m_SeedLabels[iSeed]];
+        }
+        m_LabelValues = labelValues;
+        return true;
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    template<typename TLabelNumber>
+    double ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::ComputeEnergy(const TLabelNumber *labeling) const {
+        const SizeValueType planeSize = m_Size[0] * m_Size[1];
+        std::vector<double> energies(std::max(1u, this->GetNumberOfThreads()), 0);
+        ForEachSlab(m_Size[2], [&](unsigned int thread, SizeValueType firstPlane, SizeValueType endPlane) {
+            energies[thread] = computeMultiLabelEnergy(m_Size, m_NumberOfLabels, m_EdgeWeights.data(),
+                                                       m_LabelCosts.data(), m_DefaultDataCost, m_SeedVoxels.size(),
+                                                       m_SeedVoxels.data(), m_SeedLabels.data(), labeling,
+                                                       firstPlane * planeSize, endPlane * planeSize);
+        });
+        return std::accumulate(energies.begin(), energies.end(), 0.0);
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    bool ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::AddCycle(double energy, double seconds) {
+        m_CycleEnergies.push_back(energy);
+        m_CycleTimes.push_back(seconds);
+
+        if (IsTimeBudgetExhausted()) {
+            return false;
+        }
+        if (m_CycleEnergies.size() < 2) {
+            return true;
+        }
+
+        const double previousEnergy = m_CycleEnergies[m_CycleEnergies.size() - 2];
+        const double decrease = previousEnergy - energy;
+        return decrease > 0 && decrease > m_RelativeEnergyTolerance * previousEnergy;
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    bool ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>
+    ::IsTimeBudgetExhausted() const {
+        return m_TimeBudget > 0 && std::accumulate(m_CycleTimes.begin(), m_CycleTimes.end(), 0.0) >= m_TimeBudget;
+    }
 }
 
-#endif // __ImageMultiLabelGraphCut3DFilter_hxx_
\ No newline at end of file
+#endif // __ImageMultiLabelGraphCut3DFilter_hxx_
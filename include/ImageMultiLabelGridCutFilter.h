@@ -12,12 +12,18 @@
 
 #include "ImageMultiLabelGraphCut3DFilter.h"
 #include "lib/gridcut/examples/include/AlphaExpansion/AlphaExpansion_3D_6C_MT.h"
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 #include <utility>
 
 namespace itk{
 
+/*
+ * Multi-label segmentation by GridCut's alpha-expansion. GridCut runs up to GetMaximumNumberOfCycles() cycles in one
+ * call and does not report them, so GetCycleEnergies() and GetCycleTimes() hold a single entry for the whole solve and
+ * the relative energy tolerance and the time budget do not apply.
+ */
 template<typename TInput, typename TMultiLabel, typename TOutput>
 class ImageMultiLabelGridCutFilter : public ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>{
 public:
@@ -42,9 +48,7 @@ public:
     typedef AlphaExpansion_3D_6C_MT<typename TMultiLabel::PixelType, WeightType, WeightType> GraphType;
 
 	virtual void FillGraph(const ImageContainer, ProgressReporter &progress) override;
-    virtual void SolveGraph() override {
-        m_Graph->perform(50);
-    }
+    virtual void SolveGraph() override;
 	virtual void CutGraph(ImageContainer, ProgressReporter &progress) override;
 
 
@@ -53,8 +57,10 @@ protected:
 	ImageMultiLabelGridCutFilter();
     virtual ~ImageMultiLabelGridCutFilter();
 
-    std::vector<unsigned int> mLabelIndex;
-    std::vector<std::vector<WeightType>> mWeights; // store here the smooth cost weights because the alpha expansion class does not do it
+    // the alpha expansion class does not copy its costs, they live here as long as the graph
+    std::vector<WeightType> m_DataCosts;
+    std::vector<WeightType> m_SmoothnessTables;     // one label cost table per edge weight
+    std::vector<WeightType *> m_SmoothnessCosts;    // table of every edge, into m_SmoothnessTables
 	std::unique_ptr<GraphType> m_Graph;
 
 private:
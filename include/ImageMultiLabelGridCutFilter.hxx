@@ -11,6 +11,8 @@
 #define __ImageMultiLabelGridCutFilter_hxx_
 
 #include "ImageMultiLabelGridCutFilter.h"
+#include "itkTimeProbe.h"
+
 namespace itk {
     template<typename TInput, typename TMultiLabel, typename TOutput>
     ImageMultiLabelGridCutFilter <TInput, TMultiLabel, TOutput>
@@ -28,59 +30,8 @@ namespace itk {
         typename InputImageType::SizeType dimensions;
         dimensions = this->GetInputImage()->GetLargestPossibleRegion().GetSize();
 
-        // We are only using a 6-connected structure, so the kernel (iteration neighborhood) must only be 3x3x3
-        // (specified by a radius of 1)
-        itk::Size<3> radius;
-        radius.Fill(1);
-
-        typedef itk::ConstShapedNeighborhoodIterator<InputImageType> IteratorType;
-
-        // Traverses the image adding the following bidirectional edges:
-        // 1. currentPixel <-> pixel to the right of it
-        // 2. currentPixel <-> pixel below it
-        // 3. currentPixel <-> pixel in front of it
-        // This prevents duplicate edges (i.e. we cannot add an edge to all 6-connected neighbors of every pixel or
-        // almost every edge would be duplicated.
-        std::vector<typename IteratorType::OffsetType> neighbors;
-        typename IteratorType::OffsetType right = {{1, 0, 0}};
-        neighbors.push_back(right);
-        typename IteratorType::OffsetType bottom = {{0, 1, 0}};
-        neighbors.push_back(bottom);
-        typename IteratorType::OffsetType front = {{0, 0, 1}};
-        neighbors.push_back(front);
-
-        typename IteratorType::OffsetType center = {{0, 0, 0}};
-
-        IteratorType iterator(radius, images.input, images.input->GetLargestPossibleRegion());
-        iterator.ClearActiveList();
-        iterator.ActivateOffset(right);
-        iterator.ActivateOffset(bottom);
-        iterator.ActivateOffset(front);
-        iterator.ActivateOffset(center);
-
-        // Iterate over the multiLabel image to get the number of labels
-        // A vector containing for each label a vector of image coordinates belonging to this label
-        typename std::vector<std::vector<typename TMultiLabel::IndexType>> labels;
-        itk::ImageRegionConstIterator<MultiLabelImageType > multiLabelImageIterator(images.multiLabel, this->GetMultiLabelImage()->GetLargestPossibleRegion());
-        multiLabelImageIterator.GoToBegin();
-        while (!multiLabelImageIterator.IsAtEnd()) {
-            auto currentPixelValue = multiLabelImageIterator.Get();
-            // Only consider the non zeros voxels
-            if(currentPixelValue > itk::NumericTraits<typename MultiLabelImageType::PixelType>::Zero){
-                std::vector<unsigned int>::iterator correspondingLabel = std::find(mLabelIndex.begin(), mLabelIndex.end(), currentPixelValue);
-                if(correspondingLabel == mLabelIndex.end()) {
-                    mLabelIndex.push_back(currentPixelValue);
-                    labels.resize(mLabelIndex.size());
-                    correspondingLabel = std::find(mLabelIndex.begin(), mLabelIndex.end(), currentPixelValue);
-                }
-                auto currentLabelIndex = multiLabelImageIterator.GetIndex();
-                // Add the index of the current pixel for the label it belongs to
-                labels[correspondingLabel - mLabelIndex.begin()].push_back(currentLabelIndex);
-            }
-            ++multiLabelImageIterator;
-        }
-
-        unsigned int nLabels = mLabelIndex.size();
+        this->ComputeDataCosts(images);
+        const unsigned int nLabels = this->m_LabelValues.size();
 
         typename InputImageType::SizeType graphSize = images.input->GetLargestPossibleRegion().GetSize();
 
@@ -91,73 +42,52 @@ namespace itk {
             nGraphNodes *= graphSize[iSize];
         }
 
-        WeightType * dataCosts = new WeightType[nGraphNodes * nLabels];
+        // GridCut takes dense data costs
+        m_DataCosts.assign(nGraphNodes * nLabels, this->m_DefaultDataCost);
+        for (std::size_t iSeed = 0; iSeed < this->m_SeedVoxels.size(); ++iSeed) {
+            m_DataCosts[this->m_SeedVoxels[iSeed] * nLabels + this->m_SeedLabels[iSeed]] = 0;
+        }
 
-        WeightType weightFactor;
-        if (std::numeric_limits<WeightType>::max()<std::numeric_limits<float>::max())
-            weightFactor = std::numeric_limits<WeightType >::max();
-        else
-            weightFactor = 1000;
+        this->ComputeSmoothnessCosts(images, nLabels, progress);
 
-        for (unsigned int iDatacost = 0; iDatacost < nGraphNodes * nLabels; ++iDatacost) {
-            dataCosts[iDatacost] = weightFactor;
+        // GridCut takes a label cost table per edge. The edges share one table per weight: the table of the weight w
+        // is w times the label costs.
+        const unsigned int tableSize = nLabels * nLabels;
+        WeightType maximumWeight = 0;
+        if (!this->m_EdgeWeights.empty()) {
+            maximumWeight = *std::max_element(this->m_EdgeWeights.begin(), this->m_EdgeWeights.end());
         }
-        for (unsigned int iLabel = 0; iLabel < nLabels; ++iLabel) {
-            auto indexArray = labels[iLabel]; // an array of 3d image coordinates for the iLabel
-            for (unsigned int iVoxel = 0; iVoxel < indexArray.size(); ++iVoxel) {
-                assert(images.multiLabel->ComputeOffset(indexArray[iVoxel]) == this->ConvertIndexToVertexDescriptor(indexArray[iVoxel], images.multiLabel->GetLargestPossibleRegion()));
-                dataCosts[images.multiLabel->ComputeOffset(indexArray[iVoxel]) * nLabels + iLabel] =  0;
+        m_SmoothnessTables.resize((maximumWeight + 1) * tableSize);
+        for (unsigned int weight = 0; weight <= maximumWeight; ++weight) {
+            for (unsigned int iCost = 0; iCost < tableSize; ++iCost) {
+                m_SmoothnessTables[weight * tableSize + iCost] = weight * this->m_LabelCosts[iCost];
             }
         }
 
-        WeightType** smoothnessCosts = new WeightType*[nGraphNodes * neighbors.size()];
-        // store the weight in a std vector because the pointers in the smoothnessCosts array are not released in the gridCut library
-        mWeights.resize(nGraphNodes * neighbors.size());
-        unsigned int iVoxel(0);
-        for (iterator.GoToBegin(); !iterator.IsAtEnd(); ++iterator, ++iVoxel) {
-            typename InputImageType::PixelType centerPixel = iterator.GetPixel(center);
-            // Add the edge to the graph
-            itk::Index<3> currentNodeIndex = iterator.GetIndex(center);
-            auto linearIndex = images.multiLabel->ComputeOffset(currentNodeIndex);
-            for (unsigned int iNeighbor = 0; iNeighbor< neighbors.size(); ++iNeighbor) {
-                mWeights[linearIndex * neighbors.size() + iNeighbor].resize(nLabels * nLabels);
-            }
-            for (unsigned int iLabel = 0; iLabel < nLabels; ++iLabel) {
-                for(unsigned int iOtherLabel = 0; iOtherLabel < nLabels; iOtherLabel++) {
-                    for (unsigned int iNeighbor = 0; iNeighbor < neighbors.size(); iNeighbor++) {
-                        bool pixelIsValid;
-                        typename InputImageType::PixelType neighborPixel = iterator.GetPixel(neighbors[iNeighbor],
-                                                                                             pixelIsValid);
-
-                        // If the current neighbor is outside the image, skip it
-                        if (!pixelIsValid || iLabel == iOtherLabel) {
-                            continue;
-                        }
-
-                        // Compute the edge weight
-                        double weightTmp = 0;
-                        if (centerPixel >= neighborPixel) {
-                            weightTmp = exp(-pow(centerPixel - neighborPixel, 2) / (2.0 * this->m_Sigma * this->m_Sigma));
-                        } else {
-                            weightTmp = 1;
-                        }
-                        WeightType weight(0);
-                        weight = ((weightFactor-1)/6.0) * weightTmp;// + 1;
-                        // std::cout << "weightTmp " << weightTmp << ", weight " << (int)weight << std::endl;
-
-                        assert(weight >= 0);
-                        mWeights[linearIndex * neighbors.size() + iNeighbor][iLabel + iOtherLabel * nLabels] = weight;
-                    }
-                }
-            }
-            for (unsigned int iNeighbor = 0; iNeighbor < neighbors.size(); ++iNeighbor) {
-                smoothnessCosts[linearIndex * neighbors.size() + iNeighbor] = mWeights[linearIndex * neighbors.size() + iNeighbor].data();
-            }
-
-            progress.CompletedPixel();
+        m_SmoothnessCosts.resize(this->m_EdgeWeights.size());
+        for (std::size_t iEdge = 0; iEdge < this->m_EdgeWeights.size(); ++iEdge) {
+            m_SmoothnessCosts[iEdge] = &m_SmoothnessTables[this->m_EdgeWeights[iEdge] * tableSize];
         }
-        m_Graph = std::make_unique<GraphType>(dimensions[0],dimensions[1],dimensions[2], nLabels, dataCosts, smoothnessCosts, this->GetNumberOfThreads(), 100);
 
+        m_Graph = std::make_unique<GraphType>(dimensions[0],dimensions[1],dimensions[2], nLabels, m_DataCosts.data(), m_SmoothnessCosts.data(), this->GetNumberOfThreads(), 100);
+
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelGridCutFilter <TInput, TMultiLabel, TOutput>
+    ::SolveGraph(){
+        // GridCut runs all its cycles in one call and reports none of them, so the energy is recorded once at the end
+        this->StartCycles();
+        itk::TimeProbe probe;
+        probe.Start();
+        m_Graph->perform(this->m_MaximumNumberOfCycles);
+        probe.Stop();
+
+        const double energy = this->ComputeEnergy(m_Graph->get_labeling());
+        if (this->m_PrintTimer) {
+            std::cout << "Expansion: energy " << energy << ", " << probe.GetTotal() << " s" << std::endl;
+        }
+        this->AddCycle(energy, probe.GetTotal());
     }
 
     template<typename TInput, typename TMultiLabel, typename TOutput>
@@ -174,7 +104,7 @@ namespace itk {
         while (!outputImageIterator.IsAtEnd()) {
             itk::Index<3> voxelIndex = outputImageIterator.GetIndex();
             auto linearIndex = images.output->ComputeOffset(voxelIndex);
-            outputImageIterator.Set(mLabelIndex[labeling[linearIndex]]);
+            outputImageIterator.Set(this->m_LabelValues[labeling[linearIndex]]);
             ++outputImageIterator;
             progress.CompletedPixel();
         }
@@ -0,0 +1,239 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageMultiLabelKolmogorovFilter_h_
+#define __ImageMultiLabelKolmogorovFilter_h_
+
+#include "ImageMultiLabelGraphCut3DFilter.h"
+#include "MultiLabelGraphKolmogorov.hxx"
+#include <memory>
+
+namespace itk{
+
+/*
+ * Multi-label segmentation by alpha-expansion on kolmogorovs graph library, see MultiLabelGraphKolmogorov. Minimizes
+ * the same energy as ImageMultiLabelGridCutFilter without depending on GridCut. The expansion graph is kept between
+ * updates as long as the image size and the number of labels do not change.
+ *
+ * Alpha-beta swap moves can be used instead of or before the expansion moves. A swap only builds the graph of the
+ * voxels labeled alpha or beta, which is cheaper if every label covers a small part of the image.
+ *
+ * Localized expansion moves only build the graph of the bounding box of every label and its seeds, dilated by a
+ * margin, which is much cheaper if every label covers a small part of the image.
+ *
+ * Fusion moves start from proposals, labelings in the label values of the multi-label image from e.g. a watershed,
+ * an atlas registration or a previous run. Every fusion chooses for each voxel between its current label and the one of
+ * a proposal. The proposal images are referenced, not copied.
+ *
+ * In incremental mode the filter keeps its labeling between updates. If only the seeds of the multi-label image
+ * changed, e.g. after an annotator corrected a few voxels, the next update starts from the previous labeling and only
+ * expands the labels involved in the changed seeds, reusing the edge weights, the graph and its search trees.
+ *
+ * For labels with a natural hierarchy, a binary tree over the label values replaces the cycles: every internal node is
+ * a binary cut between its two subtrees over the voxels its parent assigned to it, the cuts of sibling subtrees run in
+ * parallel. The tree is built bottom-up, its last node is the root.
+ */
+template<typename TInput, typename TMultiLabel, typename TOutput>
+class ImageMultiLabelKolmogorovFilter : public ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput>{
+public:
+	// ITK related defaults
+	typedef ImageMultiLabelKolmogorovFilter Self;
+	typedef ImageMultiLabelGraphCut3DFilter<TInput, TMultiLabel, TOutput> SuperClass;
+	typedef SmartPointer<Self> Pointer;
+	typedef SmartPointer<const Self> ConstPointer;
+	itkNewMacro(Self);
+
+	itkTypeMacro(ImageMultiLabelKolmogorovFilter, ImageMultiLabelGraphCut3DFilter);
+
+    typedef typename SuperClass::InputImageType InputImageType;
+
+    typedef typename SuperClass::MultiLabelImageType MultiLabelImageType;
+    typedef typename SuperClass::OutputImageType OutputImageType;
+    typedef typename SuperClass::WeightType WeightType;
+    typedef typename SuperClass::LabelType LabelType;
+    typedef typename SuperClass::LabelPixelType LabelPixelType;
+
+    typedef typename SuperClass::ImageContainer ImageContainer;
+    typedef MultiLabelGraphKolmogorov<WeightType, LabelType, SizeValueType> GraphType;
+    typedef typename GraphType::Cycle CycleType;
+
+    typedef enum {
+        Expansion, Swap, SwapThenExpansion, ParallelExpansion, LocalizedExpansion, Fusion, FusionThenExpansion,
+        Hierarchical
+    } MoveType;
+    typedef typename GraphType::EnergyType EnergyType;
+
+    void SetMoveTypeToExpansion() {
+        m_MoveType = Expansion;
+    }
+
+    void SetMoveTypeToSwap() {
+        m_MoveType = Swap;
+    }
+
+    // Swap cycles until they converge, then expansion cycles. The criteria of the base class end the cycles of a type,
+    // the maximum number of cycles applies to each type and the time budget to all.
+    void SetMoveTypeToSwapThenExpansion() {
+        m_MoveType = SwapThenExpansion;
+    }
+
+    // expansion cycles in slabs on GetNumberOfThreads() threads until they converge, then sequential expansion cycles.
+    // The maximum number of cycles applies to both together.
+    void SetMoveTypeToParallelExpansion() {
+        m_MoveType = ParallelExpansion;
+    }
+
+    // expansion of every label in its bounding box dilated by the expansion margin, moves beyond it are not found
+    void SetMoveTypeToLocalizedExpansion() {
+        m_MoveType = LocalizedExpansion;
+    }
+
+    // in voxels
+    void SetExpansionMargin(unsigned int margin) {
+        m_ExpansionMargin = margin;
+    }
+
+    unsigned int GetExpansionMargin() const {
+        return m_ExpansionMargin;
+    }
+
+    // Fusion cycles with all proposals until they converge. The result is a fusion of the proposals, voxels labeled by
+    // no proposal keep the first label.
+    void SetMoveTypeToFusion() {
+        m_MoveType = Fusion;
+    }
+
+    // fusion cycles, then expansion cycles from the fused labeling
+    void SetMoveTypeToFusionThenExpansion() {
+        m_MoveType = FusionThenExpansion;
+    }
+
+    // A proposal has the size of the input image, its voxels with a value that is no label of the multi-label image
+    // keep their label in a fusion. The fusions take the proposals in the order of their addition.
+    void AddProposal(const MultiLabelImageType *image) {
+        m_Proposals.push_back(image);
+        this->Modified();
+    }
+
+    void ClearProposals() {
+        m_Proposals.clear();
+        this->Modified();
+    }
+
+    unsigned int GetNumberOfProposals() const {
+        return m_Proposals.size();
+    }
+
+    // one cut per level of the label tree on GetNumberOfThreads() threads, see AddLabelTreeLeaf()
+    void SetMoveTypeToHierarchical() {
+        m_MoveType = Hierarchical;
+    }
+
+    // Label tree of the hierarchical mode. Every label value of the multi-label image must be a leaf, every node a
+    // child of one node, except for the last added node which is the root. Return the number of the new node.
+    unsigned int AddLabelTreeLeaf(LabelPixelType value) {
+        LabelTreeNode node = {{-1, -1}, value};
+        m_LabelTree.push_back(node);
+        return m_LabelTree.size() - 1;
+    }
+
+    unsigned int AddLabelTreeNode(unsigned int firstChild, unsigned int secondChild) {
+        LabelTreeNode node = {{static_cast<int>(firstChild), static_cast<int>(secondChild)}, LabelPixelType()};
+        m_LabelTree.push_back(node);
+        return m_LabelTree.size() - 1;
+    }
+
+    void ClearLabelTree() {
+        m_LabelTree.clear();
+    }
+
+    // Off by default. If the input image, sigma and the label values did not change since the last update, the next
+    // update compares the seeds to those of the last one and expands the labels of the changed seeds (before and
+    // after) and the labels of their voxels until the energy converges, whatever the type of moves. Labels not
+    // involved are not expanded again. Otherwise the update solves from scratch.
+    void SetIncrementalUpdate(bool b) {
+        m_IncrementalUpdate = b;
+    }
+
+    bool GetIncrementalUpdate() const {
+        return m_IncrementalUpdate;
+    }
+
+    // true if the last update only re-solved the changed seeds
+    bool GetUpdatedIncrementally() const {
+        return m_UpdatedIncrementally;
+    }
+
+    // seeds added, removed or relabeled since the previous update, if the last update was incremental
+    const std::vector<SizeValueType> &GetChangedSeedVoxels() const {
+        return m_ChangedSeedVoxels;
+    }
+
+    // type and changed voxels of every cycle of the last update, besides its energy and time
+    const std::vector<CycleType> &GetCycles() const {
+        return m_Graph->getCycles();
+    }
+
+    // energy of the slabs of every thread after each of its expansions in the last update, parallel expansion only
+    const std::vector<std::vector<EnergyType> > &GetThreadEnergies() const {
+        return m_Graph->getThreadEnergies();
+    }
+
+	virtual void FillGraph(const ImageContainer, ProgressReporter &progress) override;
+    virtual void SolveGraph() override;
+	virtual void CutGraph(ImageContainer, ProgressReporter &progress) override;
+
+
+protected:
+
+	ImageMultiLabelKolmogorovFilter();
+    virtual ~ImageMultiLabelKolmogorovFilter();
+
+    // checks the label tree and numbers its leaves as the labels of the graph
+    void ConvertLabelTree();
+
+    // Compares the seeds to those of the last update, given in the same label numbering. Collects the changed seeds and
+    // the labels to expand.
+    void CollectChangedSeeds(const std::vector<SizeValueType> &previousSeedVoxels,
+                             const std::vector<LabelType> &previousSeedLabels);
+
+    // expansion cycles of the labels of the changed seeds
+    void SolveChangedSeeds();
+
+	std::unique_ptr<GraphType> m_Graph;
+    MoveType m_MoveType;
+    unsigned int m_ExpansionMargin;
+
+    bool m_IncrementalUpdate;
+    bool m_UpdatedIncrementally;
+    bool m_HasLabeling;         // the graph holds the labeling of the seeds of the last complete update
+    std::vector<SizeValueType> m_ChangedSeedVoxels;
+    std::vector<LabelType> m_ChangedLabels;
+
+    struct LabelTreeNode {
+        int children[2];        // -1 for leaves
+        LabelPixelType value;   // leaves only
+    };
+    std::vector<typename MultiLabelImageType::ConstPointer> m_Proposals;
+    std::vector<LabelTreeNode> m_LabelTree;
+    std::vector<typename GraphType::LabelTreeNode> m_GraphLabelTree;
+
+private:
+	ImageMultiLabelKolmogorovFilter(const Self &); // intentionally not implemented
+	void operator=(const Self &); // intentionally not implemented
+};
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+
+#include "ImageMultiLabelKolmogorovFilter.hxx"
+
+#endif
+
+#endif //__ImageMultiLabelKolmogorovFilter_h_
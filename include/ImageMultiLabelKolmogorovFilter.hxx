@@ -0,0 +1,330 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __ImageMultiLabelKolmogorovFilter_hxx_
+#define __ImageMultiLabelKolmogorovFilter_hxx_
+
+#include "ImageMultiLabelKolmogorovFilter.h"
+namespace itk {
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::ImageMultiLabelKolmogorovFilter()
+            : m_MoveType(Expansion),
+              m_ExpansionMargin(5),
+              m_IncrementalUpdate(false),
+              m_UpdatedIncrementally(false),
+              m_HasLabeling(false) {
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::~ImageMultiLabelKolmogorovFilter() {
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::FillGraph(const ImageContainer images, ProgressReporter &progress){
+        const typename InputImageType::SizeType dimensions = images.inputRegion.GetSize();
+
+        // the seeds of the last update
+        std::vector<SizeValueType> previousSeedVoxels;
+        std::vector<LabelType> previousSeedLabels;
+        previousSeedVoxels.swap(this->m_SeedVoxels);
+        previousSeedLabels.swap(this->m_SeedLabels);
+        const std::vector<LabelPixelType> previousLabelValues = this->m_LabelValues;
+        const bool hasLabeling = m_HasLabeling;
+        m_HasLabeling = false;
+
+        this->ComputeDataCosts(images);
+        const unsigned int nLabels = this->m_LabelValues.size();
+        if (nLabels == 0) {
+            itkExceptionMacro(<< "The multi-label image contains no labels");
+        }
+
+        // only the seeds changed, the labeling of the last update is kept
+        m_UpdatedIncrementally = m_IncrementalUpdate && hasLabeling &&
+                                 m_Graph->fits(dimensions[0], dimensions[1], dimensions[2], nLabels) &&
+                                 this->EdgeWeightsAreCurrent(images) && this->RenumberLabelsAs(previousLabelValues);
+
+        if (m_MoveType == Hierarchical) {
+            ConvertLabelTree();
+        }
+        if (m_MoveType == Fusion || m_MoveType == FusionThenExpansion) {
+            if (m_Proposals.empty()) {
+                itkExceptionMacro(<< "Fusion moves need at least one proposal");
+            }
+            for (unsigned int iProposal = 0; iProposal < m_Proposals.size(); ++iProposal) {
+                if (m_Proposals[iProposal]->GetBufferedRegion().GetSize() != dimensions) {
+                    itkExceptionMacro(<< "The proposal " << iProposal << " does not have the size of the input image");
+                }
+            }
+        }
+        this->ComputeSmoothnessCosts(images, nLabels, progress, m_UpdatedIncrementally);
+
+        // the graph only depends on the size of the image and the number of labels
+        if (!m_Graph || !m_Graph->fits(dimensions[0], dimensions[1], dimensions[2], nLabels)) {
+            m_Graph.reset();
+            m_Graph = std::make_unique<GraphType>(dimensions[0], dimensions[1], dimensions[2], nLabels);
+        }
+        m_Graph->setDataCosts(this->m_DefaultDataCost, this->m_SeedVoxels.size(), this->m_SeedVoxels.data(),
+                              this->m_SeedLabels.data());
+        m_Graph->setSmoothnessCosts(this->m_EdgeWeights.data(), this->m_LabelCosts.data());
+
+        m_ChangedSeedVoxels.clear();
+        m_ChangedLabels.clear();
+        if (m_UpdatedIncrementally) {
+            CollectChangedSeeds(previousSeedVoxels, previousSeedLabels);
+            m_Graph->clearCycles();
+        } else {
+            m_Graph->resetLabeling();
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::SolveGraph(){
+        this->StartCycles();
+        m_Graph->setNumberOfThreads(this->GetNumberOfThreads());
+        m_HasLabeling = true;
+        if (m_UpdatedIncrementally) {
+            SolveChangedSeeds();
+            return;
+        }
+        if (m_MoveType == Hierarchical) {
+            const CycleType &cycle = m_Graph->performHierarchicalCut(m_GraphLabelTree, m_GraphLabelTree.size() - 1,
+                                                                     this->GetNumberOfThreads());
+            this->AddCycle(cycle.energy, cycle.seconds);
+            if (this->m_PrintTimer) {
+                std::cout << "Hierarchical cut: energy " << cycle.energy << ", " << cycle.seconds << " s" << std::endl;
+            }
+            return;
+        }
+
+        // the types of moves in the order of their cycles
+        enum { ExpansionCycles, SwapCycles, ParallelExpansionCycles, LocalizedExpansionCycles, FusionCycles };
+        std::vector<int> phases;
+        if (m_MoveType == Swap || m_MoveType == SwapThenExpansion) {
+            phases.push_back(SwapCycles);
+        }
+        if (m_MoveType == Fusion || m_MoveType == FusionThenExpansion) {
+            phases.push_back(FusionCycles);
+        }
+        if (m_MoveType == ParallelExpansion) {
+            phases.push_back(ParallelExpansionCycles);
+        }
+        if (m_MoveType == LocalizedExpansion) {
+            phases.push_back(LocalizedExpansionCycles);
+        } else if (m_MoveType != Swap && m_MoveType != Fusion) {
+            phases.push_back(ExpansionCycles);
+        }
+
+        // the proposals are read in place, their values are looked up in the sorted label values
+        std::vector<const LabelPixelType *> proposals;
+        for (unsigned int iProposal = 0; iProposal < m_Proposals.size(); ++iProposal) {
+            proposals.push_back(m_Proposals[iProposal]->GetBufferPointer());
+        }
+        std::vector<std::pair<LabelPixelType, int> > labelNumbers;
+        for (unsigned int iLabel = 0; iLabel < this->m_LabelValues.size(); ++iLabel) {
+            labelNumbers.push_back(std::make_pair(this->m_LabelValues[iLabel], iLabel));
+        }
+        std::sort(labelNumbers.begin(), labelNumbers.end());
+        auto labelOf = [&labelNumbers](LabelPixelType value) {
+            const typename std::vector<std::pair<LabelPixelType, int> >::const_iterator label =
+                    std::lower_bound(labelNumbers.begin(), labelNumbers.end(), std::make_pair(value, -1));
+            return label != labelNumbers.end() && label->first == value ? label->second : -1;
+        };
+
+        // the sequential expansion cycles after the parallel ones share their maximum number of cycles
+        unsigned int numberOfParallelCycles = 0;
+        for (unsigned int iPhase = 0; iPhase < phases.size(); ++iPhase) {
+            const unsigned int maximumNumberOfCycles =
+                    this->m_MaximumNumberOfCycles - (phases[iPhase] == ExpansionCycles ? numberOfParallelCycles : 0);
+            for (unsigned int iCycle = 0; iCycle < maximumNumberOfCycles; ++iCycle) {
+                if (this->IsTimeBudgetExhausted()) {
+                    break;
+                }
+
+                const CycleType *cycle;
+                switch (phases[iPhase]) {
+                    case SwapCycles:
+                        cycle = &m_Graph->performSwapCycle();
+                        break;
+                    case ParallelExpansionCycles:
+                        cycle = &m_Graph->performParallelExpansionCycle(this->GetNumberOfThreads());
+                        ++numberOfParallelCycles;
+                        break;
+                    case LocalizedExpansionCycles:
+                        cycle = &m_Graph->performLocalizedExpansionCycle(m_ExpansionMargin);
+                        break;
+                    case FusionCycles:
+                        cycle = &m_Graph->performFusionCycle(proposals, labelOf);
+                        break;
+                    default:
+                        cycle = &m_Graph->performExpansionCycle();
+                }
+                if (!this->AddCycle(cycle->energy, cycle->seconds) || cycle->changed == 0) {
+                    break;
+                }
+            }
+        }
+
+        if (this->m_PrintTimer) {
+            const std::vector<CycleType> &cycles = m_Graph->getCycles();
+            for (unsigned int iCycle = 0; iCycle < cycles.size(); ++iCycle) {
+                std::cout << (cycles[iCycle].swap ? "Swap" : (cycles[iCycle].parallel ? "Parallel expansion" :
+                                                              (cycles[iCycle].localized ? "Localized expansion" :
+                                                               (cycles[iCycle].fusion ? "Fusion" : "Expansion"))))
+                          << " cycle " << iCycle + 1
+                          << ": energy " << cycles[iCycle].energy << ", " << cycles[iCycle].changed
+                          << " voxels changed, " << cycles[iCycle].seconds << " s" << std::endl;
+            }
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::CollectChangedSeeds(const std::vector<SizeValueType> &previousSeedVoxels,
+                          const std::vector<LabelType> &previousSeedLabels){
+        const std::vector<SizeValueType> &seedVoxels = this->m_SeedVoxels;
+        const std::vector<LabelType> &seedLabels = this->m_SeedLabels;
+        const std::vector<LabelType> &labeling = m_Graph->getLabeling();
+        std::vector<bool> changedLabels(this->m_LabelValues.size(), false);
+
+        // both lists are in raster order
+        std::size_t previousSeed = 0, seed = 0;
+        while (previousSeed < previousSeedVoxels.size() || seed < seedVoxels.size()) {
+            SizeValueType voxel;
+            if (seed == seedVoxels.size() ||
+                (previousSeed < previousSeedVoxels.size() && previousSeedVoxels[previousSeed] < seedVoxels[seed])) {
+                // removed
+                voxel = previousSeedVoxels[previousSeed];
+                changedLabels[previousSeedLabels[previousSeed++]] = true;
+            } else if (previousSeed == previousSeedVoxels.size() || seedVoxels[seed] < previousSeedVoxels[previousSeed]) {
+                // added
+                voxel = seedVoxels[seed];
+                changedLabels[seedLabels[seed++]] = true;
+            } else if (previousSeedLabels[previousSeed] != seedLabels[seed]) {
+                // relabeled
+                voxel = seedVoxels[seed];
+                changedLabels[previousSeedLabels[previousSeed++]] = true;
+                changedLabels[seedLabels[seed++]] = true;
+            } else {
+                ++previousSeed;
+                ++seed;
+                continue;
+            }
+            m_ChangedSeedVoxels.push_back(voxel);
+            changedLabels[labeling[voxel]] = true;
+        }
+
+        for (unsigned int iLabel = 0; iLabel < changedLabels.size(); ++iLabel) {
+            if (changedLabels[iLabel]) {
+                m_ChangedLabels.push_back(iLabel);
+            }
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::SolveChangedSeeds(){
+        if (m_ChangedLabels.empty()) {
+            return;
+        }
+        for (unsigned int iCycle = 0; iCycle < this->m_MaximumNumberOfCycles; ++iCycle) {
+            if (this->IsTimeBudgetExhausted()) {
+                break;
+            }
+            const CycleType &cycle = m_Graph->performExpansionCycle(m_ChangedLabels);
+            if (this->m_PrintTimer) {
+                std::cout << "Expansion cycle " << iCycle + 1 << " of " << m_ChangedLabels.size() << " labels for "
+                          << m_ChangedSeedVoxels.size() << " changed seeds: energy " << cycle.energy << ", "
+                          << cycle.changed << " voxels changed, " << cycle.seconds << " s" << std::endl;
+            }
+            if (!this->AddCycle(cycle.energy, cycle.seconds) || cycle.changed == 0) {
+                break;
+            }
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::ConvertLabelTree(){
+        if (m_LabelTree.empty()) {
+            itkExceptionMacro(<< "The hierarchical mode needs a label tree");
+        }
+
+        // every node but the root is the child of one node, the children were added before their parent
+        std::vector<int> parents(m_LabelTree.size(), -1);
+        std::vector<int> leafOfLabel(this->m_LabelValues.size(), -1);
+        m_GraphLabelTree.resize(m_LabelTree.size());
+        for (unsigned int iNode = 0; iNode < m_LabelTree.size(); ++iNode) {
+            const LabelTreeNode &node = m_LabelTree[iNode];
+            typename GraphType::LabelTreeNode &graphNode = m_GraphLabelTree[iNode];
+            graphNode.children[0] = node.children[0];
+            graphNode.children[1] = node.children[1];
+            graphNode.label = 0;
+
+            if (node.children[0] >= 0) {
+                for (unsigned int iChild = 0; iChild < 2; ++iChild) {
+                    const int child = node.children[iChild];
+                    if (child < 0 || child >= static_cast<int>(iNode) || parents[child] >= 0) {
+                        itkExceptionMacro(<< "Node " << iNode << " of the label tree has an invalid child " << child);
+                    }
+                    parents[child] = iNode;
+                }
+                continue;
+            }
+
+            const typename std::vector<LabelPixelType>::const_iterator value =
+                    std::find(this->m_LabelValues.begin(), this->m_LabelValues.end(), node.value);
+            if (value == this->m_LabelValues.end()) {
+                itkExceptionMacro(<< "The label " << static_cast<double>(node.value)
+                                  << " of the label tree is not in the multi-label image");
+            }
+            graphNode.label = static_cast<LabelType>(value - this->m_LabelValues.begin());
+            if (leafOfLabel[graphNode.label] >= 0) {
+                itkExceptionMacro(<< "The label " << static_cast<double>(node.value)
+                                  << " is more than one leaf of the label tree");
+            }
+            leafOfLabel[graphNode.label] = iNode;
+        }
+
+        for (unsigned int iNode = 0; iNode + 1 < m_LabelTree.size(); ++iNode) {
+            if (parents[iNode] < 0) {
+                itkExceptionMacro(<< "Node " << iNode << " of the label tree is not connected to the root");
+            }
+        }
+        for (unsigned int iLabel = 0; iLabel < leafOfLabel.size(); ++iLabel) {
+            if (leafOfLabel[iLabel] < 0) {
+                itkExceptionMacro(<< "The label " << static_cast<double>(this->m_LabelValues[iLabel])
+                                  << " is not a leaf of the label tree");
+            }
+        }
+    }
+
+    template<typename TInput, typename TMultiLabel, typename TOutput>
+    void ImageMultiLabelKolmogorovFilter <TInput, TMultiLabel, TOutput>
+    ::CutGraph(ImageContainer images, ProgressReporter &progress){
+
+        // Iterate over the output image, querying the labeling for each pixel
+        itk::ImageRegionIterator<OutputImageType> outputImageIterator(images.output, images.outputRegion);
+        outputImageIterator.GoToBegin();
+
+        const std::vector<LabelType> &labeling = m_Graph->getLabeling();
+
+        while (!outputImageIterator.IsAtEnd()) {
+            itk::Index<3> voxelIndex = outputImageIterator.GetIndex();
+            auto linearIndex = this->ConvertIndexToVertexDescriptor(voxelIndex, images.inputRegion);
+            outputImageIterator.Set(this->m_LabelValues[labeling[linearIndex]]);
+            ++outputImageIterator;
+            progress.CompletedPixel();
+        }
+    }
+}
+#endif //__ImageMultiLabelKolmogorovFilter_hxx_
@@ -11,59 +11,65 @@
 #define __MaxFlowGraphBoost_hxx_
 
 // boost
-#include <boost/assign/list_of.hpp>
-#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/compressed_sparse_row_graph.hpp>
 #include <boost/graph/boykov_kolmogorov_max_flow.hpp>
 
+// STL
+#include <utility>
+#include <vector>
+
 /*
 * Wraps the boosts graph library for easier use of the boykov_kolmogorov_max_flow algorithm.
 *
+* The edges are collected in flat arrays and turned into a compressed sparse row graph right before the calculation.
+* The arcs are bucketed by their source vertex (a counting sort), so the graph is built from sorted edges and the
+* index of an arc in the graph is its position in the sorted arrays. All property maps are plain vectors indexed by it.
 */
 class MaxFlowGraphBoost {
 public:
-    typedef boost::adjacency_list<boost::listS, boost::vecS, boost::directedS,
-            boost::no_property,
-            boost::property<boost::edge_index_t, std::size_t> > GraphType;
+    typedef boost::compressed_sparse_row_graph<boost::directedS, boost::no_property, boost::no_property,
+            boost::no_property, unsigned int, unsigned int> GraphType;
 
+    typedef boost::graph_traits<GraphType>::vertex_descriptor VertexDescriptor;
     typedef boost::graph_traits<GraphType>::edge_descriptor EdgeDescriptor;
 
     MaxFlowGraphBoost(unsigned int dimension1, unsigned int dimension2, unsigned int dimension3)
             : numberOfVertices(dimension1 * dimension2 * dimension3 + 2)
             , SOURCE(numberOfVertices - 2)
             , SINK(numberOfVertices - 1)
-            , currentEdgeIndex(-1)
-            , graph(numberOfVertices)
-            , reverseEdges()
-            , capacity()
+            , graph()
+            , arcSources()
+            , arcTargets()
+            , arcCapacities()
             , groups(numberOfVertices)
     {
+        // both directions of the three edges per voxel of a 6-connected grid
+        arcSources.reserve(6 * (numberOfVertices - 2));
+        arcTargets.reserve(6 * (numberOfVertices - 2));
+        arcCapacities.reserve(6 * (numberOfVertices - 2));
     }
 
-    // boykov_kolmogorov_max_flow requires all edges to have a reverse edge.
+    // boykov_kolmogorov_max_flow requires all edges to have a reverse edge. the reverse of arc i is arc i^1.
     void addBidirectionalEdge(unsigned int source, unsigned int target, float weight, float reverseWeight){
+        arcSources.push_back(source);
+        arcTargets.push_back(target);
+        arcCapacities.push_back(weight);
 
-        // tracking the currentEdgeIndex manually instead of getting it via boost:num_edges(graph) results in a massive
-        // speedup: http://stackoverflow.com/questions/7890857/boost-graph-library-edge-insertion-slow-for-large-graph
-
-        // create both edges
-        EdgeDescriptor edge = boost::add_edge(source, target, ++currentEdgeIndex, graph).first;
-        EdgeDescriptor reverseEdge = boost::add_edge(target, source, ++currentEdgeIndex, graph).first;
-
-        // add them to out property maps
-        reverseEdges.push_back(reverseEdge);
-        reverseEdges.push_back(edge);
-        capacity.push_back(weight);
-        capacity.push_back(weight);
+        arcSources.push_back(target);
+        arcTargets.push_back(source);
+        arcCapacities.push_back(reverseWeight);
     }
 
     void addTerminalEdges(unsigned int node, float sourceWeight, float sinkWeight){
-        addBidirectionalEdge(node, SOURCE, sourceWeight, sinkWeight);
-        addBidirectionalEdge(node, SINK, sinkWeight, sinkWeight);
+        addBidirectionalEdge(SOURCE, node, sourceWeight, 0);
+        addBidirectionalEdge(node, SINK, sinkWeight, 0);
     }
 
     // start the calculation
     void calculateMaxFlow(){
-        std::vector<float> residualCapacity(getNumberOfEdges(), 0);
+        buildGraph();
+
+        std::vector<float> residualCapacity(capacity.size(), 0);
 
         // max flow
         boost::boykov_kolmogorov_max_flow(graph
@@ -76,37 +82,79 @@ public:
                 , SINK);
     }
 
-    // query the resulting segmentation group of a vertex.
+    // query the resulting segmentation group of a vertex. vertices in neither search tree (gray) belong to the source,
+    // like in kolmogorovs MAXFLOW.
     int groupOf(unsigned int vertex){
-        return groups.at(vertex);
+        return groups.at(vertex) == groups[SINK] ? groupOfSink() : groupOfSource();
     }
 
     int groupOfSource(){
-        return groupOf(SOURCE);
+        return groups[SOURCE];
     }
 
     int groupOfSink(){
-        return groupOf(SINK);
+        return groups[SINK];
     }
 
     long getNumberOfVertices(){
-        return boost::num_vertices(graph) - 2;
+        return numberOfVertices - 2;
     }
 
     long getNumberOfEdges(){
-        return boost::num_edges(graph);
+        return arcSources.empty() ? capacity.size() : arcSources.size();
     }
 private:
+    // turns the collected arcs into the compressed sparse row graph
+    void buildGraph(){
+        std::size_t numberOfArcs = arcSources.size();
+
+        // first arc of every vertex
+        std::vector<unsigned int> nextArc(numberOfVertices + 1, 0);
+        for (std::size_t i = 0; i < numberOfArcs; ++i) {
+            nextArc[arcSources[i] + 1]++;
+        }
+        for (long v = 0; v < numberOfVertices; ++v) {
+            nextArc[v + 1] += nextArc[v];
+        }
+
+        std::vector<unsigned int> position(numberOfArcs);
+        for (std::size_t i = 0; i < numberOfArcs; ++i) {
+            position[i] = nextArc[arcSources[i]]++;
+        }
+
+        std::vector<std::pair<unsigned int, unsigned int> > sortedArcs(numberOfArcs);
+        capacity.resize(numberOfArcs);
+        reverseEdges.resize(numberOfArcs);
+        for (std::size_t i = 0; i < numberOfArcs; ++i) {
+            sortedArcs[position[i]] = std::make_pair(arcSources[i], arcTargets[i]);
+            capacity[position[i]] = arcCapacities[i];
+            reverseEdges[position[i]] = EdgeDescriptor(arcTargets[i], position[i ^ 1]);
+        }
+
+        graph = GraphType(boost::edges_are_sorted, sortedArcs.begin(), sortedArcs.end(), numberOfVertices);
+
+        // the graph owns the structure now
+        std::vector<unsigned int>().swap(arcSources);
+        std::vector<unsigned int>().swap(arcTargets);
+        std::vector<float>().swap(arcCapacities);
+    }
+
     long numberOfVertices;
     unsigned int SOURCE;
     unsigned int SINK;
-    long currentEdgeIndex;
 
     GraphType graph;
+
+    // arcs in insertion order, until the graph is built
+    std::vector<unsigned int> arcSources;
+    std::vector<unsigned int> arcTargets;
+    std::vector<float> arcCapacities;
+
+    // property maps, indexed by the edge index of the graph
     std::vector<EdgeDescriptor> reverseEdges;
     std::vector<float> capacity;
     std::vector<int> groups;
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,641 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __MaxFlowGraphOutOfCore_hxx_
+#define __MaxFlowGraphOutOfCore_hxx_
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * Maxflow on a 6-connected grid which does not need to fit into memory.
+ *
+ * The grid is split into blocks of whole z-planes. Blocks are kept in files in a scratch directory and only a bounded
+ * number of them is resident at any time. The maxflow is computed with region discharge push-relabel (Delong & Boykov,
+ * CVPR 2008): a block is discharged with the distance labels of its neighbouring planes held fixed, flow pushed across
+ * the block boundary is stored directly in the (resident) neighbour. Between sweeps the labels are recomputed exactly
+ * with a block-wise backward breadth-first search from the sink, which also detects termination.
+ *
+ * The resulting cut is the same as the one of kolmogorovs MAXFLOW: a node belongs to the sink if it can still reach the
+ * sink in the residual graph, every other node belongs to the source.
+ */
+class MaxFlowGraphOutOfCore {
+public:
+    typedef std::uint64_t NodeType;
+    typedef unsigned int LabelType;
+
+    // arcs leaving a node, the reverse arc of d is d^1
+    enum Direction {
+        MinusX = 0, PlusX, MinusY, PlusY, MinusZ, PlusZ, NumberOfDirections
+    };
+
+    // residual state of a voxel
+    static const std::size_t BytesPerNode = sizeof(float) * (NumberOfDirections + 2) + sizeof(LabelType);
+
+    MaxFlowGraphOutOfCore(unsigned int dimension1, unsigned int dimension2, unsigned int dimension3,
+                          std::size_t memoryBudget, const std::string &scratchDirectory)
+            : sizeX(dimension1)
+            , sizeY(dimension2)
+            , sizeZ(dimension3)
+            , sliceSize(static_cast<NodeType>(dimension1) * dimension2)
+            , scratchDirectory(scratchDirectory)
+            , useCounter(0)
+    {
+        // discharging a block requires it and both of its neighbours to be resident
+        std::size_t bytesPerPlane = sliceSize * BytesPerNode;
+        planesPerBlock = static_cast<unsigned int>(std::max<std::size_t>(1, memoryBudget / (3 * bytesPerPlane)));
+        planesPerBlock = std::min(planesPerBlock, sizeZ);
+        numberOfBlocks = (sizeZ + planesPerBlock - 1) / planesPerBlock;
+        maximumResidentBlocks = std::max<std::size_t>(3, memoryBudget / (planesPerBlock * bytesPerPlane));
+
+        // the address is only unique within the process, several processes may share the scratch directory
+        std::ostringstream prefix;
+        prefix << scratchDirectory << "/graphcut_" << processId() << "_" << reinterpret_cast<std::uintptr_t>(this) << "_";
+        filePrefix = prefix.str();
+
+        residentBlocks.assign(numberOfBlocks, NULL);
+        blockOnDisk.assign(numberOfBlocks, false);
+        blockIsActive.assign(numberOfBlocks, false);
+    }
+
+    ~MaxFlowGraphOutOfCore(){
+        for (unsigned int i = 0; i < numberOfBlocks; ++i) {
+            delete residentBlocks[i];
+            if (blockOnDisk[i]) {
+                std::remove(blockFileName(i).c_str());
+            }
+        }
+    }
+
+    // only edges between grid neighbours are supported
+    void addBidirectionalEdge(NodeType source, NodeType target, float weight, float reverseWeight){
+        int direction = directionBetween(source, target);
+
+        Block *sourceBlock = acquire(blockOf(source));
+        sourceBlock->capacity[direction][localIndex(sourceBlock, source)] += weight;
+        sourceBlock->dirty = true;
+
+        Block *targetBlock = acquire(blockOf(target));
+        targetBlock->capacity[direction ^ 1][localIndex(targetBlock, target)] += reverseWeight;
+        targetBlock->dirty = true;
+    }
+
+    // the source capacity is pushed into the node right away, the sink capacity stays residual
+    void addTerminalEdges(NodeType node, float sourceWeight, float sinkWeight){
+        Block *block = acquire(blockOf(node));
+        NodeType i = localIndex(block, node);
+        block->excess[i] += sourceWeight;
+        block->sinkCapacity[i] += sinkWeight;
+        block->dirty = true;
+        blockIsActive[block->index] = true;
+    }
+
+    // start the calculation
+    void calculateMaxFlow(){
+        globalRelabel();
+
+        bool ascending = true;
+        while (std::find(blockIsActive.begin(), blockIsActive.end(), true) != blockIsActive.end()) {
+            // alternate the sweep direction, flow travels along the sweep within a single round
+            for (unsigned int i = 0; i < numberOfBlocks; ++i) {
+                unsigned int block = ascending ? i : numberOfBlocks - 1 - i;
+                if (blockIsActive[block]) {
+                    discharge(block);
+                }
+            }
+            ascending = !ascending;
+
+            globalRelabel();
+        }
+    }
+
+    // query the resulting segmentation group of a vertex.
+    int groupOf(NodeType vertex){
+        Block *block = acquire(blockOf(vertex));
+        return block->label[localIndex(block, vertex)] == InfiniteLabel ? groupOfSource() : groupOfSink();
+    }
+
+    int groupOfSource(){
+        return 0;
+    }
+
+    int groupOfSink(){
+        return 1;
+    }
+
+    NodeType getNumberOfVertices(){
+        return sliceSize * sizeZ;
+    }
+
+    unsigned int getNumberOfBlocks(){
+        return numberOfBlocks;
+    }
+
+    unsigned int getPlanesPerBlock(){
+        return planesPerBlock;
+    }
+
+    std::size_t getMaximumResidentBlocks(){
+        return maximumResidentBlocks;
+    }
+
+private:
+    static const LabelType InfiniteLabel = std::numeric_limits<LabelType>::max();
+
+    struct Block {
+        unsigned int index;
+        unsigned int firstPlane;
+        unsigned int numberOfPlanes;
+        bool dirty;
+        int pinned;
+        std::uint64_t lastUse;
+
+        std::vector<float> excess;
+        std::vector<float> sinkCapacity;
+        std::vector<LabelType> label;
+        std::vector<float> capacity[NumberOfDirections];
+    };
+
+    // position of a node, z is global
+    struct Coordinate {
+        unsigned int x, y, z;
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    // block cache
+
+    static long processId() {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return getpid();
+#endif
+    }
+
+    std::string blockFileName(unsigned int block) const {
+        std::ostringstream name;
+        name << filePrefix << block << ".raw";
+        return name.str();
+    }
+
+    unsigned int blockOf(NodeType node) const {
+        return static_cast<unsigned int>(node / sliceSize) / planesPerBlock;
+    }
+
+    NodeType localIndex(const Block *block, NodeType node) const {
+        return node - block->firstPlane * sliceSize;
+    }
+
+    Coordinate coordinateOf(const Block *block, NodeType i) const {
+        Coordinate c;
+        c.x = static_cast<unsigned int>(i % sizeX);
+        c.y = static_cast<unsigned int>((i / sizeX) % sizeY);
+        c.z = block->firstPlane + static_cast<unsigned int>(i / sliceSize);
+        return c;
+    }
+
+    Block *acquire(unsigned int index){
+        Block *block = residentBlocks[index];
+        if (!block) {
+            block = load(index);
+        }
+        block->lastUse = ++useCounter;
+        return block;
+    }
+
+    Block *load(unsigned int index){
+        Block *block = NULL;
+        std::size_t numberOfResidentBlocks = numberOfBlocks - std::count(residentBlocks.begin(), residentBlocks.end(), (Block *) NULL);
+        if (numberOfResidentBlocks < maximumResidentBlocks) {
+            block = new Block();
+        } else {
+            // evict the least recently used block which is not pinned
+            for (unsigned int i = 0; i < numberOfBlocks; ++i) {
+                Block *candidate = residentBlocks[i];
+                if (candidate && !candidate->pinned && (!block || candidate->lastUse < block->lastUse)) {
+                    block = candidate;
+                }
+            }
+            if (!block) {
+                throw std::runtime_error("MaxFlowGraphOutOfCore: all resident blocks are pinned");
+            }
+            if (block->dirty) {
+                write(block);
+            }
+            residentBlocks[block->index] = NULL;
+        }
+
+        block->index = index;
+        block->firstPlane = index * planesPerBlock;
+        block->numberOfPlanes = std::min(planesPerBlock, sizeZ - block->firstPlane);
+        block->dirty = false;
+        block->pinned = 0;
+
+        NodeType numberOfNodes = block->numberOfPlanes * sliceSize;
+        block->excess.assign(numberOfNodes, 0);
+        block->sinkCapacity.assign(numberOfNodes, 0);
+        block->label.assign(numberOfNodes, 0);
+        for (int d = 0; d < NumberOfDirections; ++d) {
+            block->capacity[d].assign(numberOfNodes, 0);
+        }
+
+        if (blockOnDisk[index]) {
+            read(block);
+        }
+
+        residentBlocks[index] = block;
+        return block;
+    }
+
+    template<typename T>
+    static void writeArray(std::ofstream &file, const std::vector<T> &data){
+        file.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(T));
+    }
+
+    template<typename T>
+    static void readArray(std::ifstream &file, std::vector<T> &data){
+        file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(T));
+    }
+
+    void write(Block *block){
+        std::ofstream file(blockFileName(block->index).c_str(), std::ios::binary | std::ios::trunc);
+        writeArray(file, block->excess);
+        writeArray(file, block->sinkCapacity);
+        writeArray(file, block->label);
+        for (int d = 0; d < NumberOfDirections; ++d) {
+            writeArray(file, block->capacity[d]);
+        }
+        if (!file) {
+            throw std::runtime_error("MaxFlowGraphOutOfCore: could not write " + blockFileName(block->index));
+        }
+        blockOnDisk[block->index] = true;
+        block->dirty = false;
+    }
+
+    void read(Block *block){
+        std::ifstream file(blockFileName(block->index).c_str(), std::ios::binary);
+        readArray(file, block->excess);
+        readArray(file, block->sinkCapacity);
+        readArray(file, block->label);
+        for (int d = 0; d < NumberOfDirections; ++d) {
+            readArray(file, block->capacity[d]);
+        }
+        if (!file) {
+            throw std::runtime_error("MaxFlowGraphOutOfCore: could not read " + blockFileName(block->index));
+        }
+    }
+
+    // keeps a block and its neighbours resident; neighbours are NULL at the border of the grid
+    void pinNeighbourhood(unsigned int index, Block *neighbourhood[3]){
+        neighbourhood[0] = index > 0 ? acquire(index - 1) : NULL;
+        if (neighbourhood[0]) neighbourhood[0]->pinned++;
+        neighbourhood[1] = acquire(index);
+        neighbourhood[1]->pinned++;
+        neighbourhood[2] = index + 1 < numberOfBlocks ? acquire(index + 1) : NULL;
+        if (neighbourhood[2]) neighbourhood[2]->pinned++;
+    }
+
+    void unpinNeighbourhood(Block *neighbourhood[3]){
+        for (int i = 0; i < 3; ++i) {
+            if (neighbourhood[i]) neighbourhood[i]->pinned--;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // grid
+
+    int directionBetween(NodeType source, NodeType target) const {
+        NodeType low = std::min(source, target);
+        NodeType high = std::max(source, target);
+        int direction;
+        // z before y before x: in a volume one voxel wide y steps differ by one, in one voxel high z steps by sizeX
+        if (high - low == sliceSize) {
+            direction = PlusZ;
+        } else if (high - low == sizeX) {
+            direction = PlusY;
+        } else if (high - low == 1) {
+            direction = PlusX;
+        } else {
+            throw std::invalid_argument("MaxFlowGraphOutOfCore: edges must connect grid neighbours");
+        }
+        return source < target ? direction : direction ^ 1;
+    }
+
+    // finds the neighbour of node i of the centre block in the given direction; false at the border of the grid
+    bool neighbour(Block *neighbourhood[3], NodeType i, const Coordinate &c, int direction, Block *&block, NodeType &j) const {
+        block = neighbourhood[1];
+        switch (direction) {
+            case MinusX: if (c.x == 0) return false; j = i - 1; return true;
+            case PlusX: if (c.x + 1 == sizeX) return false; j = i + 1; return true;
+            case MinusY: if (c.y == 0) return false; j = i - sizeX; return true;
+            case PlusY: if (c.y + 1 == sizeY) return false; j = i + sizeX; return true;
+            case MinusZ:
+                if (c.z == 0) return false;
+                if (c.z == block->firstPlane) {
+                    block = neighbourhood[0];
+                    j = i + (block->numberOfPlanes - 1) * sliceSize;
+                } else {
+                    j = i - sliceSize;
+                }
+                return true;
+            default:
+                if (c.z + 1 == sizeZ) return false;
+                if (c.z + 1 == block->firstPlane + block->numberOfPlanes) {
+                    block = neighbourhood[2];
+                    j = i % sliceSize;
+                } else {
+                    j = i + sliceSize;
+                }
+                return true;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // push-relabel
+
+    // discharges all active nodes of a block; the labels of the neighbouring blocks stay fixed
+    void discharge(unsigned int index){
+        Block *neighbourhood[3];
+        pinNeighbourhood(index, neighbourhood);
+        Block *block = neighbourhood[1];
+        block->dirty = true;
+
+        NodeType numberOfNodes = block->numberOfPlanes * sliceSize;
+        std::deque<NodeType> queue;
+        std::vector<bool> queued(numberOfNodes, false);
+
+        // a node which can still reach the sink has a residual path inside the block to the sink or to one of the
+        // boundary planes, its label can therefore not exceed this bound
+        std::uint64_t labelBound = std::min<std::uint64_t>(InfiniteLabel - 1, numberOfNodes + maximumNeighbourLabel(neighbourhood) + 1);
+
+        bool interrupted = true;
+        while (interrupted) {
+            // exact labels for the block, nodes cut off from the sink drop out. repeated whenever the discharge spent
+            // as many relabels as the block has nodes.
+            regionRelabel(neighbourhood);
+            for (NodeType i = 0; i < numberOfNodes; ++i) {
+                if (block->excess[i] > 0 && block->label[i] != InfiniteLabel) {
+                    queue.push_back(i);
+                    queued[i] = true;
+                }
+            }
+
+            interrupted = false;
+            NodeType numberOfRelabels = 0;
+            while (!queue.empty() && !interrupted) {
+                NodeType i = queue.front();
+                queue.pop_front();
+                queued[i] = false;
+                Coordinate c = coordinateOf(block, i);
+
+                while (block->excess[i] > 0) {
+                    // pushing to the sink is always admissible
+                    if (block->sinkCapacity[i] > 0) {
+                        float delta = std::min(block->excess[i], block->sinkCapacity[i]);
+                        block->excess[i] -= delta;
+                        block->sinkCapacity[i] -= delta;
+                        continue;
+                    }
+
+                    LabelType minimumLabel = InfiniteLabel;
+                    bool pushed = false;
+                    for (int d = 0; d < NumberOfDirections && block->excess[i] > 0; ++d) {
+                        Block *neighbourBlock;
+                        NodeType j;
+                        if (block->capacity[d][i] <= 0 || !neighbour(neighbourhood, i, c, d, neighbourBlock, j)) {
+                            continue;
+                        }
+                        LabelType neighbourLabel = neighbourBlock->label[j];
+                        if (neighbourLabel != InfiniteLabel && neighbourLabel + 1 == block->label[i]) {
+                            float delta = std::min(block->excess[i], block->capacity[d][i]);
+                            block->excess[i] -= delta;
+                            block->capacity[d][i] -= delta;
+                            neighbourBlock->capacity[d ^ 1][j] += delta;
+                            neighbourBlock->excess[j] += delta;
+                            pushed = true;
+
+                            if (neighbourBlock != block) {
+                                neighbourBlock->dirty = true;
+                                blockIsActive[neighbourBlock->index] = true;
+                            } else if (!queued[j]) {
+                                queue.push_back(j);
+                                queued[j] = true;
+                            }
+                        } else if (neighbourLabel != InfiniteLabel) {
+                            minimumLabel = std::min(minimumLabel, neighbourLabel);
+                        }
+                    }
+
+                    if (pushed) {
+                        continue;
+                    }
+
+                    // relabel
+                    if (minimumLabel == InfiniteLabel || minimumLabel + 1 > labelBound) {
+                        block->label[i] = InfiniteLabel;
+                        break;
+                    }
+                    block->label[i] = minimumLabel + 1;
+                    if (++numberOfRelabels > numberOfNodes) {
+                        interrupted = true;
+                        break;
+                    }
+                }
+            }
+
+            queue.clear();
+            std::fill(queued.begin(), queued.end(), false);
+        }
+
+        blockIsActive[index] = false;
+        unpinNeighbourhood(neighbourhood);
+    }
+
+    LabelType maximumNeighbourLabel(Block *neighbourhood[3]) const {
+        LabelType largestLabel = 0;
+        for (int side = 0; side < 2; ++side) {
+            Block *neighbourBlock = neighbourhood[side == 0 ? 0 : 2];
+            if (!neighbourBlock) {
+                continue;
+            }
+            NodeType offset = side == 0 ? (neighbourBlock->numberOfPlanes - 1) * sliceSize : 0;
+            for (NodeType k = 0; k < sliceSize; ++k) {
+                if (neighbourBlock->label[offset + k] != InfiniteLabel) {
+                    largestLabel = std::max(largestLabel, neighbourBlock->label[offset + k]);
+                }
+            }
+        }
+        return largestLabel;
+    }
+
+    // recomputes the labels of the centre block from the sink and the labels of the neighbouring boundary planes
+    void regionRelabel(Block *neighbourhood[3]){
+        std::deque<NodeType> queue;
+        std::vector<bool> queued(neighbourhood[1]->numberOfPlanes * sliceSize, false);
+        bool changedFirstPlane, changedLastPlane;
+        resetLabels(neighbourhood[1], queue, queued);
+        relaxFromNeighbours(neighbourhood, NULL, queue, queued);
+        propagateLabels(neighbourhood, queue, queued, changedFirstPlane, changedLastPlane);
+    }
+
+    // recomputes the exact distance of every node to the sink in the residual graph. nodes which cannot reach the
+    // sink get an infinite label.
+    void globalRelabel(){
+        std::vector<bool> needsRelabel(numberOfBlocks, true);
+        std::vector<bool> isReset(numberOfBlocks, false);
+
+        bool ascending = true;
+        while (std::find(needsRelabel.begin(), needsRelabel.end(), true) != needsRelabel.end()) {
+            for (unsigned int k = 0; k < numberOfBlocks; ++k) {
+                unsigned int index = ascending ? k : numberOfBlocks - 1 - k;
+                if (!needsRelabel[index]) {
+                    continue;
+                }
+                needsRelabel[index] = false;
+
+                Block *neighbourhood[3];
+                pinNeighbourhood(index, neighbourhood);
+                Block *block = neighbourhood[1];
+                block->dirty = true;
+
+                std::deque<NodeType> queue;
+                std::vector<bool> queued(block->numberOfPlanes * sliceSize, false);
+                if (!isReset[index]) {
+                    isReset[index] = true;
+                    resetLabels(block, queue, queued);
+                }
+                relaxFromNeighbours(neighbourhood, &isReset, queue, queued);
+
+                bool changedFirstPlane, changedLastPlane;
+                propagateLabels(neighbourhood, queue, queued, changedFirstPlane, changedLastPlane);
+                if (changedFirstPlane && neighbourhood[0]) needsRelabel[index - 1] = true;
+                if (changedLastPlane && neighbourhood[2]) needsRelabel[index + 1] = true;
+
+                blockIsActive[index] = false;
+                for (NodeType i = 0; i < block->numberOfPlanes * sliceSize && !blockIsActive[index]; ++i) {
+                    blockIsActive[index] = block->excess[i] > 0 && block->label[i] != InfiniteLabel;
+                }
+
+                unpinNeighbourhood(neighbourhood);
+            }
+            ascending = !ascending;
+        }
+    }
+
+    // nodes with residual capacity to the sink are at distance one, all others are unknown
+    void resetLabels(Block *block, std::deque<NodeType> &queue, std::vector<bool> &queued){
+        for (NodeType i = 0; i < queued.size(); ++i) {
+            block->label[i] = block->sinkCapacity[i] > 0 ? 1 : InfiniteLabel;
+            if (block->label[i] != InfiniteLabel) {
+                queue.push_back(i);
+                queued[i] = true;
+            }
+        }
+    }
+
+    // lowers the labels of the boundary planes of the centre block through arcs into the neighbouring blocks. labels
+    // of neighbours which were not reset yet are outdated and ignored.
+    void relaxFromNeighbours(Block *neighbourhood[3], const std::vector<bool> *isReset,
+                             std::deque<NodeType> &queue, std::vector<bool> &queued){
+        Block *block = neighbourhood[1];
+        for (int side = 0; side < 2; ++side) {
+            Block *neighbourBlock = neighbourhood[side == 0 ? 0 : 2];
+            if (!neighbourBlock || (isReset && !(*isReset)[neighbourBlock->index])) {
+                continue;
+            }
+            int direction = side == 0 ? MinusZ : PlusZ;
+            NodeType offset = side == 0 ? 0 : (block->numberOfPlanes - 1) * sliceSize;
+            NodeType neighbourOffset = side == 0 ? (neighbourBlock->numberOfPlanes - 1) * sliceSize : 0;
+            for (NodeType k = 0; k < sliceSize; ++k) {
+                LabelType neighbourLabel = neighbourBlock->label[neighbourOffset + k];
+                NodeType i = offset + k;
+                if (neighbourLabel != InfiniteLabel && block->capacity[direction][i] > 0 && neighbourLabel + 1 < block->label[i]) {
+                    block->label[i] = neighbourLabel + 1;
+                    if (!queued[i]) {
+                        queue.push_back(i);
+                        queued[i] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // label correcting breadth-first search inside the centre block, starting from the queued nodes
+    void propagateLabels(Block *neighbourhood[3], std::deque<NodeType> &queue, std::vector<bool> &queued,
+                         bool &changedFirstPlane, bool &changedLastPlane){
+        Block *block = neighbourhood[1];
+        NodeType numberOfNodes = queued.size();
+        changedFirstPlane = false;
+        changedLastPlane = false;
+
+        while (!queue.empty()) {
+            NodeType j = queue.front();
+            queue.pop_front();
+            queued[j] = false;
+            Coordinate c = coordinateOf(block, j);
+
+            // every queued node got a new label
+            if (j < sliceSize) changedFirstPlane = true;
+            if (j >= numberOfNodes - sliceSize) changedLastPlane = true;
+
+            for (int d = 0; d < NumberOfDirections; ++d) {
+                Block *neighbourBlock;
+                NodeType i;
+                if (!neighbour(neighbourhood, j, c, d, neighbourBlock, i) || neighbourBlock != block) {
+                    continue;
+                }
+                // the arc i->j is the reverse of direction d
+                if (block->capacity[d ^ 1][i] > 0 && block->label[j] + 1 < block->label[i]) {
+                    block->label[i] = block->label[j] + 1;
+                    if (!queued[i]) {
+                        queue.push_back(i);
+                        queued[i] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+
+    unsigned int sizeX;
+    unsigned int sizeY;
+    unsigned int sizeZ;
+    NodeType sliceSize;
+    std::string scratchDirectory;
+    std::string filePrefix;
+
+    unsigned int planesPerBlock;
+    unsigned int numberOfBlocks;
+    std::size_t maximumResidentBlocks;
+    std::uint64_t useCounter;
+
+    // the only state kept for every block
+    std::vector<Block *> residentBlocks;
+    std::vector<bool> blockOnDisk;
+    std::vector<bool> blockIsActive;
+};
+
+#endif
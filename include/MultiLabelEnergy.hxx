@@ -0,0 +1,63 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __MultiLabelEnergy_hxx_
+#define __MultiLabelEnergy_hxx_
+
+#include <algorithm>
+#include <cstddef>
+
+/*
+ * Energy of a labeling of a 6-connected grid of voxels in raster order, as minimized by the multi-label filters.
+ *
+ * A voxel costs 0 for the label of its seed and the default cost otherwise. An edge costs its weight times the cost of
+ * the labels of its voxels, labelCosts[label + otherLabel * numberOfLabels]. The edge weights are given for the edges
+ * of every voxel to its neighbors at +1 in x, y and z, edgeWeights[3 * voxel + d], the seeds in raster order.
+ *
+ * Sums the data costs of the voxels in [firstVoxel, endVoxel) and the smoothness costs of their edges to the next
+ * voxels, so that the energies of consecutive ranges, e.g. slabs of planes, add up to the energy of the labeling.
+ */
+template<typename TDimensions, typename TWeight, typename TLabel, typename TVoxel, typename TLabelNumber>
+double computeMultiLabelEnergy(const TDimensions &dimensions, unsigned int numberOfLabels, const TWeight *edgeWeights,
+                               const TWeight *labelCosts, double defaultCost, std::size_t numberOfSeeds,
+                               const TVoxel *seedVoxels, const TLabel *seedLabels, const TLabelNumber *labeling,
+                               std::size_t firstVoxel, std::size_t endVoxel) {
+    const std::size_t size[3] = {dimensions[0], dimensions[1], dimensions[2]};
+    const std::size_t strides[3] = {1, size[0], size[0] * size[1]};
+    std::size_t seed = std::lower_bound(seedVoxels, seedVoxels + numberOfSeeds, (TVoxel) firstVoxel) - seedVoxels;
+    std::size_t coordinates[3] = {firstVoxel % size[0], (firstVoxel / size[0]) % size[1], firstVoxel / strides[2]};
+
+    double energy = 0;
+    for (std::size_t voxel = firstVoxel; voxel < endVoxel; ++voxel) {
+        if (seed < numberOfSeeds && seedVoxels[seed] == voxel) {
+            energy += labeling[voxel] == seedLabels[seed] ? 0 : defaultCost;
+            ++seed;
+        } else {
+            energy += defaultCost;
+        }
+
+        for (unsigned int d = 0; d < 3; ++d) {
+            if (coordinates[d] + 1 < size[d]) {
+                energy += (double) edgeWeights[3 * voxel + d] *
+                          labelCosts[labeling[voxel] + labeling[voxel + strides[d]] * numberOfLabels];
+            }
+        }
+
+        if (++coordinates[0] == size[0]) {
+            coordinates[0] = 0;
+            if (++coordinates[1] == size[1]) {
+                coordinates[1] = 0;
+                ++coordinates[2];
+            }
+        }
+    }
+    return energy;
+}
+
+#endif // __MultiLabelEnergy_hxx_
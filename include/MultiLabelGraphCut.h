@@ -4,6 +4,8 @@
 #include "lib/gridcut/config.h"
 #ifdef GRIDCUT_LIBRARY_AVAILABLE
 #include "ImageMultiLabelGridCutFilter.h"
+#else
+#include "ImageMultiLabelKolmogorovFilter.h"
 #endif
 
 namespace GraphCut
@@ -11,6 +13,8 @@ namespace GraphCut
     template<typename TInput, typename TMultiLabel, typename TOutput>
     #ifdef GRIDCUT_LIBRARY_AVAILABLE
         using FilterType = itk::ImageMultiLabelGridCutFilter<TInput, TMultiLabel, TOutput>;
+    #else
+        using FilterType = itk::ImageMultiLabelKolmogorovFilter<TInput, TMultiLabel, TOutput>;
     #endif // GRIDCUT_LIBRARY_AVAILABLE
 }
 
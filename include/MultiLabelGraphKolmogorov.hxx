@@ -0,0 +1,927 @@
+/**
+ *  Image GraphCut 3D Segmentation
+ *
+ *  Copyright (c) 2016, Zurich University of Applied Sciences, School of Engineering, T. Fitze, Y. Pauchard
+ *
+ *  Licensed under GNU General Public License 3.0 or later.
+ *  Some rights reserved.
+ */
+
+#ifndef __MultiLabelGraphKolmogorov_hxx_
+#define __MultiLabelGraphKolmogorov_hxx_
+
+#include "lib/kolmogorov-3.03/graph.h"
+#include "MultiLabelEnergy.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+ * Alpha-expansion on kolmogorovs graph library for a 6-connected grid of voxels in raster order.
+ *
+ * The energy of a labeling is the sum of the data costs of the voxels and the smoothness costs of the edges. The data
+ * costs are sparse: every label costs the default cost, except for the seeds, which cost 0 for their own label. The
+ * smoothness cost of an edge is its weight times the cost of the two labels in a matrix shared by all edges, which
+ * must be a metric (e.g. Potts). The edge weights are given for the edges of every voxel to its neighbors at +1 in x,
+ * y and z, edgeWeights[3 * voxel + d]. The costs are referenced, not copied.
+ *
+ * The graph of an expansion move has the topology of the grid for every label, so it is allocated once. An expansion
+ * rewrites the capacities in place and continues with maxflow(true): only the nodes whose capacities changed are
+ * marked, the search trees of the others are reused.
+ *
+ * Alpha-beta swap moves only involve the voxels labeled alpha or beta. Their graph is built over these voxels alone in
+ * a second graph, which is reset and refilled for every swap and so keeps its allocation. Swap cycles, i.e. a swap for
+ * every pair of labels, can precede the expansion cycles.
+ *
+ * The parallel expansion splits the image into two slabs of planes per thread. For every label, the even slabs are
+ * expanded at the same time, then the odd ones, each in a graph of its own with the voxels of the neighboring slabs
+ * keeping their labels. Slabs expanded at the same time share no edge, so their moves add up and never raise the
+ * energy. Sequential expansion cycles follow once the slabs converge, so the result is a local minimum with respect
+ * to expansion moves as in the sequential case.
+ *
+ * A localized expansion only builds the graph of the bounding box of the voxels labeled alpha and the seeds of alpha,
+ * dilated by a margin, in a graph of its own. The voxels outside keep their labels. This is much cheaper if every
+ * label covers a small part of the image, but only moves within the margin are found.
+ *
+ * A fusion move chooses for every voxel between its label and the label of a proposal, e.g. a labeling from another
+ * method, in the graph of the expansion moves. An expansion is the fusion with a constant proposal. The pairwise terms
+ * of a fusion need not be submodular, these are truncated by raising the cost of the current label next to the
+ * proposed one, which keeps the move from raising the energy.
+ *
+ * The hierarchical cut takes a binary tree over the labels instead of cycles. Every internal node of the tree is a
+ * binary cut between the labels of its two subtrees, restricted to the voxels assigned to the node by the cut of its
+ * parent, so a voxel takes part in one cut per level of the tree instead of one expansion per label and cycle. The
+ * cuts of a level cover disjoint voxels and run on several threads.
+ */
+template<typename TWeight, typename TLabel, typename TVoxel>
+class MultiLabelGraphKolmogorov {
+public:
+    // the flow adds up over all moves and cycles of a graph whose search trees are reused
+    typedef Graph<int, int, long long> GraphType;
+    typedef TWeight WeightType;
+    typedef TLabel LabelType;
+    typedef TVoxel VoxelType;
+    typedef double EnergyType;
+
+    // one pass over all labels (expansion) or pairs of labels (swap)
+    struct Cycle {
+        bool swap;
+        bool parallel;          // expansion in slabs
+        bool hierarchical;      // cuts along a label tree
+        bool localized;         // expansion in the dilated bounding box of every label
+        bool fusion;            // fusion with every proposal
+        EnergyType energy;      // after the cycle
+        double seconds;
+        std::size_t changed;    // voxels that changed their label
+    };
+
+    // node of a label tree, a leaf if its children are -1
+    struct LabelTreeNode {
+        int children[2];
+        LabelType label;        // leaves only
+    };
+
+    MultiLabelGraphKolmogorov(unsigned int dimension1, unsigned int dimension2, unsigned int dimension3,
+                              unsigned int numberOfLabels)
+            : numberOfLabels(numberOfLabels), edgeWeights(NULL), labelCosts(NULL), defaultCost(0), numberOfSeeds(0),
+              seedVoxels(NULL), seedLabels(NULL), firstSolve(true), numberOfThreads(1), swapGraph(NULL) {
+        dimensions[0] = dimension1;
+        dimensions[1] = dimension2;
+        dimensions[2] = dimension3;
+        numberOfVoxels = (std::size_t) dimension1 * dimension2 * dimension3;
+
+        std::size_t numberOfEdges = (std::size_t) (dimension1 - 1) * dimension2 * dimension3 +
+                                    (std::size_t) dimension1 * (dimension2 - 1) * dimension3 +
+                                    (std::size_t) dimension1 * dimension2 * (dimension3 - 1);
+        graph = new GraphType(numberOfVoxels, numberOfEdges);
+        graph->add_node(numberOfVoxels);
+
+        // the edges in the order of the sweeps in expand()
+        std::size_t voxel = 0;
+        for (unsigned int z = 0; z < dimension3; ++z) {
+            for (unsigned int y = 0; y < dimension2; ++y) {
+                for (unsigned int x = 0; x < dimension1; ++x, ++voxel) {
+                    const unsigned int coordinates[3] = {x, y, z};
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (coordinates[d] + 1 < dimensions[d]) {
+                            graph->add_edge(voxel, voxel + stride(d), 0, 0);
+                        }
+                    }
+                }
+            }
+        }
+
+        terminalCapacities.resize(numberOfVoxels);
+        resetLabeling();
+    }
+
+    ~MultiLabelGraphKolmogorov() {
+        delete graph;
+        delete swapGraph;
+        for (std::size_t thread = 0; thread < blockGraphs.size(); ++thread) {
+            delete blockGraphs[thread];
+        }
+    }
+
+    // true if the graph can be reused for the given problem
+    bool fits(unsigned int dimension1, unsigned int dimension2, unsigned int dimension3,
+              unsigned int labels) const {
+        return dimensions[0] == dimension1 && dimensions[1] == dimension2 && dimensions[2] == dimension3 &&
+               numberOfLabels == labels;
+    }
+
+    void setSmoothnessCosts(const WeightType *weights, const WeightType *costs) {
+        edgeWeights = weights;
+        labelCosts = costs;
+    }
+
+    // seeds in raster order
+    void setDataCosts(WeightType cost, std::size_t seeds, const VoxelType *voxels, const LabelType *labels) {
+        defaultCost = cost;
+        numberOfSeeds = seeds;
+        seedVoxels = voxels;
+        seedLabels = labels;
+    }
+
+    // every voxel takes the first label, clears the cycles
+    void resetLabeling() {
+        labeling.assign(numberOfVoxels, 0);
+        clearCycles();
+    }
+
+    // keeps the labeling, e.g. to continue after the data costs changed
+    void clearCycles() {
+        cycles.clear();
+        threadEnergies.clear();
+    }
+
+    // Moves every voxel for which it lowers the energy to alpha, returns the number of voxels that changed
+    std::size_t expand(LabelType alpha) {
+        return move([alpha](std::size_t) { return alpha; });
+    }
+
+    // Moves every voxel for which it lowers the energy to the label of the proposal, given as the label values of the
+    // voxels in raster order. labelOf() returns the number of a label value or -1 if it is not a label, those voxels
+    // keep their label. Returns the number of voxels that changed.
+    template<typename TProposalValue, typename TLabelOf>
+    std::size_t fuse(const TProposalValue *proposal, TLabelOf labelOf) {
+        proposedLabels.resize(numberOfVoxels);
+        for (std::size_t voxel = 0; voxel < numberOfVoxels; ++voxel) {
+            const int label = labelOf(proposal[voxel]);
+            proposedLabels[voxel] = label < 0 ? labeling[voxel] : (LabelType) label;
+        }
+        return move([this](std::size_t voxel) { return proposedLabels[voxel]; });
+    }
+
+    // Swaps alpha and beta for every voxel labeled alpha or beta for which it lowers the energy, returns the number
+    // of voxels that changed
+    std::size_t swap(LabelType alpha, LabelType beta) {
+        // the active voxels and their nodes
+        activeVoxels.clear();
+        nodeOfVoxel.resize(numberOfVoxels);
+        for (std::size_t voxel = 0; voxel < numberOfVoxels; ++voxel) {
+            if (labeling[voxel] == alpha || labeling[voxel] == beta) {
+                nodeOfVoxel[voxel] = activeVoxels.size();
+                activeVoxels.push_back(voxel);
+            } else {
+                nodeOfVoxel[voxel] = -1;
+            }
+        }
+        if (activeVoxels.empty()) {
+            return 0;
+        }
+
+        if (swapGraph) {
+            swapGraph->reset();
+        } else {
+            swapGraph = new GraphType(activeVoxels.size(), 3 * activeVoxels.size());
+        }
+        swapGraph->add_node(activeVoxels.size());
+
+        // the sink segment takes beta
+        std::size_t seed = 0;
+        for (std::size_t node = 0; node < activeVoxels.size(); ++node) {
+            const std::size_t voxel = activeVoxels[node];
+            int terminal = 0;
+            while (seed < numberOfSeeds && seedVoxels[seed] < voxel) {
+                ++seed;
+            }
+            if (seed < numberOfSeeds && seedVoxels[seed] == voxel) {
+                terminal += dataCost(seed, beta) - dataCost(seed, alpha);
+            }
+
+            const std::size_t coordinates[3] = {voxel % dimensions[0], (voxel / dimensions[0]) % dimensions[1],
+                                                voxel / ((std::size_t) dimensions[0] * dimensions[1])};
+            for (unsigned int d = 0; d < 3; ++d) {
+                // edge to the next voxel, pairwise if it is active
+                if (coordinates[d] + 1 < dimensions[d]) {
+                    const std::size_t neighbor = voxel + stride(d);
+                    const int weight = edgeWeights[3 * voxel + d];
+                    if (nodeOfVoxel[neighbor] >= 0) {
+                        int terminalNeighbor = 0, forward, backward;
+                        splitPairwise(weight * labelCost(alpha, alpha), weight * labelCost(alpha, beta),
+                                      weight * labelCost(beta, alpha), weight * labelCost(beta, beta),
+                                      terminal, terminalNeighbor, forward, backward);
+                        addTerminalCapacity(swapGraph, nodeOfVoxel[neighbor], terminalNeighbor);
+                        swapGraph->add_edge(node, nodeOfVoxel[neighbor], forward, backward);
+                    } else {
+                        terminal += weight * (labelCost(beta, labeling[neighbor]) - labelCost(alpha, labeling[neighbor]));
+                    }
+                }
+                // edge from the previous voxel, the pairwise terms were added with the previous voxel
+                if (coordinates[d] > 0) {
+                    const std::size_t neighbor = voxel - stride(d);
+                    if (nodeOfVoxel[neighbor] < 0) {
+                        const int weight = edgeWeights[3 * neighbor + d];
+                        terminal += weight * (labelCost(labeling[neighbor], beta) - labelCost(labeling[neighbor], alpha));
+                    }
+                }
+            }
+            addTerminalCapacity(swapGraph, node, terminal);
+        }
+
+        swapGraph->maxflow();
+
+        // nodes in neither tree take alpha, all of them, so the free components are not split
+        std::size_t changed = 0;
+        for (std::size_t node = 0; node < activeVoxels.size(); ++node) {
+            LabelType &label = labeling[activeVoxels[node]];
+            const LabelType swapped = swapGraph->what_segment(node) == GraphType::SINK ? beta : alpha;
+            if (swapped != label) {
+                label = swapped;
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+    // A cycle expands every label or swaps every pair of labels once. It is recorded with the energy after it.
+    const Cycle &performExpansionCycle() {
+        return performCycle(false, 1);
+    }
+
+    // expansion of the given labels only
+    const Cycle &performExpansionCycle(const std::vector<LabelType> &labels) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Cycle c = Cycle();
+        for (std::size_t label = 0; label < labels.size(); ++label) {
+            c.changed += expand(labels[label]);
+        }
+        return recordCycle(c, start);
+    }
+
+    const Cycle &performSwapCycle() {
+        return performCycle(true, 1);
+    }
+
+    // expansion in slabs, sequential if there are less than three planes or one thread
+    const Cycle &performParallelExpansionCycle(unsigned int threads) {
+        return performCycle(false, threads);
+    }
+
+    // expansion of every label in its bounding box dilated by margin voxels
+    const Cycle &performLocalizedExpansionCycle(unsigned int margin) {
+        return performCycle(false, 1, margin);
+    }
+
+    // fusion with every proposal in turn, see fuse()
+    template<typename TProposalValue, typename TLabelOf>
+    const Cycle &performFusionCycle(const std::vector<const TProposalValue *> &proposals, TLabelOf labelOf) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Cycle c = Cycle();
+        c.fusion = true;
+        for (std::size_t proposal = 0; proposal < proposals.size(); ++proposal) {
+            c.changed += fuse(proposals[proposal], labelOf);
+        }
+        return recordCycle(c, start);
+    }
+
+    // Expands every label in turn until a cycle changes nothing, returns the number of cycles
+    unsigned int performExpansion(unsigned int maximumNumberOfCycles) {
+        unsigned int cycle = 0;
+        while (cycle < maximumNumberOfCycles) {
+            ++cycle;
+            if (performExpansionCycle().changed == 0) {
+                break;
+            }
+        }
+        return cycle;
+    }
+
+    // Swaps every pair of labels in turn until a cycle changes nothing, returns the number of cycles
+    unsigned int performSwap(unsigned int maximumNumberOfCycles) {
+        unsigned int cycle = 0;
+        while (cycle < maximumNumberOfCycles) {
+            ++cycle;
+            if (performSwapCycle().changed == 0) {
+                break;
+            }
+        }
+        return cycle;
+    }
+
+    // Expands every label in turn in slabs on the given number of threads until a cycle changes nothing, then
+    // continues with sequential expansion cycles. Returns the number of cycles, at most maximumNumberOfCycles of both
+    // kinds together.
+    unsigned int performParallelExpansion(unsigned int maximumNumberOfCycles, unsigned int threads) {
+        unsigned int cycle = 0;
+        while (cycle < maximumNumberOfCycles) {
+            ++cycle;
+            if (performParallelExpansionCycle(threads).changed == 0) {
+                break;
+            }
+        }
+        return cycle + performExpansion(maximumNumberOfCycles - cycle);
+    }
+
+    // Labels every voxel by binary cuts from the root of the tree down to its leaves, the cuts of a level on the given
+    // number of threads. Every label must be a leaf of exactly one node. The cut of a node separates the labels of its
+    // first child (source) from those of its second (sink): a voxel costs 0 for the side of its seed and the default
+    // cost otherwise, and an edge costs its weight times the least label cost between the two sides if they differ.
+    // Edges to voxels of other subtrees cost the same for both sides with the Potts model and are left out. The
+    // labeling does not depend on the previous one. Recorded as a cycle.
+    const Cycle &performHierarchicalCut(const std::vector<LabelTreeNode> &tree, unsigned int root,
+                                        unsigned int threads) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        threads = std::max(1u, threads);
+        blockGraphs.resize(std::max<std::size_t>(blockGraphs.size(), threads), NULL);
+
+        // side of every label at every internal node, -1 for labels of other subtrees
+        std::vector<std::vector<signed char> > sides(tree.size());
+        std::vector<int> crossCosts(tree.size(), 0);
+        std::vector<std::vector<LabelType> > leaves(tree.size());
+        collectLeaves(tree, root, leaves);
+        for (std::size_t node = 0; node < tree.size(); ++node) {
+            if (tree[node].children[0] < 0) {
+                continue;
+            }
+            sides[node].assign(numberOfLabels, -1);
+            crossCosts[node] = -1;
+            for (unsigned int side = 0; side < 2; ++side) {
+                const std::vector<LabelType> &labels = leaves[tree[node].children[side]];
+                for (std::size_t label = 0; label < labels.size(); ++label) {
+                    sides[node][labels[label]] = side;
+                }
+            }
+            for (std::size_t first = 0; first < leaves[tree[node].children[0]].size(); ++first) {
+                for (std::size_t second = 0; second < leaves[tree[node].children[1]].size(); ++second) {
+                    const int cost = labelCost(leaves[tree[node].children[0]][first],
+                                               leaves[tree[node].children[1]][second]);
+                    crossCosts[node] = crossCosts[node] < 0 ? cost : std::min(crossCosts[node], cost);
+                }
+            }
+        }
+
+        // the tree node of every voxel, read during a level and written to the next one
+        std::vector<int> treeNodes(numberOfVoxels, root), nextTreeNodes(numberOfVoxels, root);
+        nodeOfVoxel.resize(numberOfVoxels);
+        std::vector<unsigned int> level(1, root);
+        while (!level.empty()) {
+            // the voxels of every internal node of the level
+            std::vector<int> cutOfTreeNode(tree.size(), -1);
+            std::vector<unsigned int> cuts;
+            for (std::size_t node = 0; node < level.size(); ++node) {
+                if (tree[level[node]].children[0] >= 0) {
+                    cutOfTreeNode[level[node]] = cuts.size();
+                    cuts.push_back(level[node]);
+                }
+            }
+            std::vector<std::vector<std::size_t> > cutVoxels(cuts.size());
+            for (std::size_t voxel = 0; voxel < numberOfVoxels; ++voxel) {
+                const int cut = cutOfTreeNode[treeNodes[voxel]];
+                if (cut >= 0) {
+                    nodeOfVoxel[voxel] = cutVoxels[cut].size();
+                    cutVoxels[cut].push_back(voxel);
+                }
+            }
+
+            // the threads take the cuts in turn, largest first. Subtrees without voxels are neither cut nor descended.
+            std::vector<std::size_t> order;
+            for (std::size_t cut = 0; cut < cuts.size(); ++cut) {
+                if (!cutVoxels[cut].empty()) {
+                    order.push_back(cut);
+                }
+            }
+            std::sort(order.begin(), order.end(), [&](std::size_t first, std::size_t second) {
+                return cutVoxels[first].size() > cutVoxels[second].size();
+            });
+            std::atomic<std::size_t> nextCut(0);
+            auto cutLevel = [&](unsigned int thread) {
+                for (std::size_t cut = nextCut++; cut < order.size(); cut = nextCut++) {
+                    const unsigned int node = cuts[order[cut]];
+                    cutTreeNode(thread, tree[node], sides[node], crossCosts[node], cutVoxels[order[cut]], treeNodes,
+                                nextTreeNodes);
+                }
+            };
+            std::vector<std::thread> workers;
+            for (unsigned int thread = 1; thread < std::min<std::size_t>(threads, order.size()); ++thread) {
+                workers.push_back(std::thread(cutLevel, thread));
+            }
+            cutLevel(0);
+            for (std::size_t worker = 0; worker < workers.size(); ++worker) {
+                workers[worker].join();
+            }
+            treeNodes = nextTreeNodes;
+
+            std::vector<unsigned int> nextLevel;
+            for (std::size_t cut = 0; cut < order.size(); ++cut) {
+                nextLevel.push_back(tree[cuts[order[cut]]].children[0]);
+                nextLevel.push_back(tree[cuts[order[cut]]].children[1]);
+            }
+            level.swap(nextLevel);
+        }
+
+        Cycle c = Cycle();
+        c.hierarchical = true;
+        for (std::size_t voxel = 0; voxel < numberOfVoxels; ++voxel) {
+            const LabelType label = tree[treeNodes[voxel]].label;
+            if (labeling[voxel] != label) {
+                labeling[voxel] = label;
+                ++c.changed;
+            }
+        }
+        return recordCycle(c, start);
+    }
+
+    // Expands every label in turn in its dilated bounding box until a cycle changes nothing, returns the number of
+    // cycles
+    unsigned int performLocalizedExpansion(unsigned int maximumNumberOfCycles, unsigned int margin) {
+        unsigned int cycle = 0;
+        while (cycle < maximumNumberOfCycles) {
+            ++cycle;
+            if (performLocalizedExpansionCycle(margin).changed == 0) {
+                break;
+            }
+        }
+        return cycle;
+    }
+
+    // threads of computeEnergy()
+    void setNumberOfThreads(unsigned int threads) {
+        numberOfThreads = std::max(1u, threads);
+    }
+
+    // Energy of the slabs of every thread after each of its expansions, since the last resetLabeling(). The energy of
+    // a slab is the data cost of its voxels plus the smoothness costs of their edges to the next voxels.
+    const std::vector<std::vector<EnergyType> > &getThreadEnergies() const {
+        return threadEnergies;
+    }
+
+    // cycles since the last resetLabeling()
+    const std::vector<Cycle> &getCycles() const {
+        return cycles;
+    }
+
+    // sum of the energies of slabs of planes on the threads set by setNumberOfThreads()
+    EnergyType computeEnergy() const {
+        const unsigned int threads = std::min(numberOfThreads, dimensions[2]);
+        if (threads < 2) {
+            return computeEnergy(0, numberOfVoxels);
+        }
+
+        const std::size_t plane = (std::size_t) dimensions[0] * dimensions[1];
+        std::vector<EnergyType> energies(threads, 0);
+        std::vector<std::thread> workers;
+        for (unsigned int thread = 0; thread < threads; ++thread) {
+            workers.push_back(std::thread([&, thread]() {
+                const std::size_t firstPlane = (std::size_t) thread * dimensions[2] / threads;
+                const std::size_t endPlane = (std::size_t) (thread + 1) * dimensions[2] / threads;
+                energies[thread] = computeEnergy(firstPlane * plane, endPlane * plane);
+            }));
+        }
+
+        EnergyType energy = 0;
+        for (unsigned int thread = 0; thread < threads; ++thread) {
+            workers[thread].join();
+            energy += energies[thread];
+        }
+        return energy;
+    }
+
+    // data costs of the voxels in [firstVoxel, endVoxel) and smoothness costs of their edges to the next voxels
+    EnergyType computeEnergy(std::size_t firstVoxel, std::size_t endVoxel) const {
+        return computeMultiLabelEnergy(dimensions, numberOfLabels, edgeWeights, labelCosts, defaultCost, numberOfSeeds,
+                                       seedVoxels, seedLabels, labeling.data(), firstVoxel, endVoxel);
+    }
+
+    const std::vector<LabelType> &getLabeling() const {
+        return labeling;
+    }
+
+    unsigned int getNumberOfLabels() const {
+        return numberOfLabels;
+    }
+
+protected:
+    // a margin < 0 expands in the whole image
+    const Cycle &performCycle(bool swapMoves, unsigned int threads, int margin = -1) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Cycle c = Cycle();
+        c.swap = swapMoves;
+        c.localized = !swapMoves && margin >= 0;
+
+        if (c.localized) {
+            c.changed = expandBoxes(margin);
+        } else if (!swapMoves && threads > 1 && std::min(2 * threads, dimensions[2]) >= 3) {
+            c.parallel = true;
+            c.changed = expandSlabs(threads);
+        } else {
+            for (unsigned int alpha = 0; alpha < numberOfLabels; ++alpha) {
+                if (!swapMoves) {
+                    c.changed += expand(alpha);
+                    continue;
+                }
+                for (unsigned int beta = alpha + 1; beta < numberOfLabels; ++beta) {
+                    c.changed += swap(alpha, beta);
+                }
+            }
+        }
+        return recordCycle(c, start);
+    }
+
+    // adds the time since start and the energy to the cycle and stores it
+    const Cycle &recordCycle(Cycle c, std::chrono::steady_clock::time_point start) {
+        c.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        c.energy = computeEnergy();
+        cycles.push_back(c);
+        return cycles.back();
+    }
+
+    // Expands every label in the slabs, the even ones at the same time, then the odd ones. Returns the number of voxels
+    // that changed.
+    std::size_t expandSlabs(unsigned int threads) {
+        const unsigned int numberOfSlabs = std::min(2 * threads, dimensions[2]);
+        std::vector<unsigned int> slabBegin(numberOfSlabs + 1);
+        for (unsigned int slab = 0; slab <= numberOfSlabs; ++slab) {
+            slabBegin[slab] = (std::size_t) slab * dimensions[2] / numberOfSlabs;
+        }
+        threads = (numberOfSlabs + 1) / 2;
+        blockGraphs.resize(std::max<std::size_t>(blockGraphs.size(), threads), NULL);
+        threadEnergies.resize(std::max<std::size_t>(threadEnergies.size(), threads));
+
+        std::vector<std::size_t> changed(threads, 0);
+        for (unsigned int alpha = 0; alpha < numberOfLabels; ++alpha) {
+            for (unsigned int parity = 0; parity < 2; ++parity) {
+                std::vector<std::thread> workers;
+                for (unsigned int thread = 0; thread < threads; ++thread) {
+                    const unsigned int slab = 2 * thread + parity;
+                    if (slab < numberOfSlabs) {
+                        workers.push_back(std::thread([&, thread, slab]() {
+                            changed[thread] += expandSlab(thread, alpha, slabBegin[slab], slabBegin[slab + 1]);
+                        }));
+                    }
+                }
+                for (std::size_t worker = 0; worker < workers.size(); ++worker) {
+                    workers[worker].join();
+                }
+            }
+        }
+
+        std::size_t total = 0;
+        for (unsigned int thread = 0; thread < threads; ++thread) {
+            total += changed[thread];
+        }
+        return total;
+    }
+
+    // Moves every voxel for which it lowers the energy to the label proposedOf(voxel), returns the number of voxels
+    // that changed
+    template<typename TProposedOf>
+    std::size_t move(TProposedOf proposedOf) {
+        // data costs, only the seeds do not cost the same for all labels
+        std::fill(terminalCapacities.begin(), terminalCapacities.end(), 0);
+        for (std::size_t seed = 0; seed < numberOfSeeds; ++seed) {
+            const VoxelType voxel = seedVoxels[seed];
+            terminalCapacities[voxel] = dataCost(seed, proposedOf(voxel)) - dataCost(seed, labeling[voxel]);
+        }
+
+        // smoothness costs, the sink segment takes the proposed label
+        typename GraphType::arc_id arc = graph->get_first_arc();
+        std::size_t voxel = 0;
+        for (unsigned int z = 0; z < dimensions[2]; ++z) {
+            for (unsigned int y = 0; y < dimensions[1]; ++y) {
+                for (unsigned int x = 0; x < dimensions[0]; ++x, ++voxel) {
+                    const unsigned int coordinates[3] = {x, y, z};
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (coordinates[d] + 1 >= dimensions[d]) {
+                            continue;
+                        }
+
+                        const std::size_t neighbor = voxel + stride(d);
+                        const int weight = edgeWeights[3 * voxel + d];
+                        const LabelType proposed = proposedOf(voxel), proposedNeighbor = proposedOf(neighbor);
+                        const int a = weight * labelCost(labeling[voxel], labeling[neighbor]);
+                        const int c = weight * labelCost(proposed, labeling[neighbor]);
+                        const int e = weight * labelCost(proposed, proposedNeighbor);
+                        // truncated to a submodular term, never for an expansion with a metric
+                        const int b = std::max(weight * labelCost(labeling[voxel], proposedNeighbor), a + e - c);
+                        int forward, backward;
+                        splitPairwise(a, b, c, e, terminalCapacities[voxel], terminalCapacities[neighbor], forward,
+                                      backward);
+
+                        setCapacity(arc, forward, voxel, neighbor);
+                        arc = graph->get_next_arc(arc);
+                        setCapacity(arc, backward, neighbor, voxel);
+                        arc = graph->get_next_arc(arc);
+                    }
+                }
+            }
+        }
+
+        for (std::size_t node = 0; node < numberOfVoxels; ++node) {
+            if (graph->get_trcap(node) != terminalCapacities[node]) {
+                graph->set_trcap(node, terminalCapacities[node]);
+                markNode(node);
+            }
+        }
+
+        graph->maxflow(!firstSolve);
+        firstSolve = false;
+
+        std::size_t changed = 0;
+        for (std::size_t node = 0; node < numberOfVoxels; ++node) {
+            if (graph->what_segment(node) == GraphType::SINK && labeling[node] != proposedOf(node)) {
+                labeling[node] = proposedOf(node);
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+    // Splits the pairwise term E(0, 0) = a, E(0, 1) = b, E(1, 0) = c, E(1, 1) = e of the nodes p and q as kolmogorovs
+    // energy.h: a or e depending on p only, plus b - a on the arc p->q and c - e on the arc q->p. A negative part of
+    // the latter two moves to the terminals. Adds source minus sink capacities to terminalP and terminalQ.
+    static void splitPairwise(int a, int b, int c, int e, int &terminalP, int &terminalQ, int &forward,
+                              int &backward) {
+        terminalP += e - a;
+        forward = b - a;
+        backward = c - e;
+        if (forward < 0) {
+            terminalP -= forward;
+            terminalQ += forward;
+            backward += forward;
+            forward = 0;
+        } else if (backward < 0) {
+            terminalP += backward;
+            terminalQ -= backward;
+            forward += backward;
+            backward = 0;
+        }
+    }
+
+    // Expands every label in the bounding box of its voxels and seeds at the start of the cycle, dilated by the margin.
+    // The other labels only lose voxels to alpha, so their boxes stay valid during the cycle. Returns the number of
+    // voxels that changed.
+    std::size_t expandBoxes(unsigned int margin) {
+        std::vector<unsigned int> first(3 * numberOfLabels), last(3 * numberOfLabels);
+        std::vector<bool> present(numberOfLabels, false);
+        auto addVoxel = [&](std::size_t voxel, LabelType label) {
+            const unsigned int coordinates[3] = {(unsigned int) (voxel % dimensions[0]),
+                                                 (unsigned int) ((voxel / dimensions[0]) % dimensions[1]),
+                                                 (unsigned int) (voxel / ((std::size_t) dimensions[0] * dimensions[1]))};
+            for (unsigned int d = 0; d < 3; ++d) {
+                first[3 * label + d] = present[label] ? std::min(first[3 * label + d], coordinates[d]) : coordinates[d];
+                last[3 * label + d] = present[label] ? std::max(last[3 * label + d], coordinates[d]) : coordinates[d];
+            }
+            present[label] = true;
+        };
+        for (std::size_t voxel = 0; voxel < numberOfVoxels; ++voxel) {
+            addVoxel(voxel, labeling[voxel]);
+        }
+        for (std::size_t seed = 0; seed < numberOfSeeds; ++seed) {
+            addVoxel(seedVoxels[seed], seedLabels[seed]);
+        }
+
+        blockGraphs.resize(std::max<std::size_t>(blockGraphs.size(), 1), NULL);
+        std::size_t changed = 0;
+        for (unsigned int alpha = 0; alpha < numberOfLabels; ++alpha) {
+            if (!present[alpha]) {
+                continue;
+            }
+            unsigned int firstOfBox[3], endOfBox[3];
+            bool wholeImage = true;
+            for (unsigned int d = 0; d < 3; ++d) {
+                firstOfBox[d] = first[3 * alpha + d] > margin ? first[3 * alpha + d] - margin : 0;
+                endOfBox[d] = std::min<std::size_t>((std::size_t) last[3 * alpha + d] + margin + 1, dimensions[d]);
+                wholeImage = wholeImage && firstOfBox[d] == 0 && endOfBox[d] == dimensions[d];
+            }
+            // the graph of the whole image reuses its search trees
+            changed += wholeImage ? expand(alpha) : expandBox(0, alpha, firstOfBox, endOfBox);
+        }
+        return changed;
+    }
+
+    // Expands alpha in the planes [firstPlane, endPlane) with the graph of the thread, returns the number of voxels
+    // that changed
+    std::size_t expandSlab(unsigned int thread, LabelType alpha, unsigned int firstPlane, unsigned int endPlane) {
+        const unsigned int first[3] = {0, 0, firstPlane};
+        const unsigned int end[3] = {dimensions[0], dimensions[1], endPlane};
+        const std::size_t changed = expandBox(thread, alpha, first, end);
+
+        const std::size_t plane = (std::size_t) dimensions[0] * dimensions[1];
+        threadEnergies[thread].push_back(computeEnergy(firstPlane * plane, endPlane * plane));
+        return changed;
+    }
+
+    // Expands alpha in the box [first, end) with the graph of the thread, the voxels outside keep their labels.
+    // Returns the number of voxels that changed.
+    std::size_t expandBox(unsigned int thread, LabelType alpha, const unsigned int first[3], const unsigned int end[3]) {
+        const std::size_t boxStrides[3] = {1, (std::size_t) end[0] - first[0],
+                                           (std::size_t) (end[0] - first[0]) * (end[1] - first[1])};
+        const std::size_t numberOfNodes = boxStrides[2] * (end[2] - first[2]);
+
+        GraphType *&boxGraph = blockGraphs[thread];
+        if (boxGraph) {
+            boxGraph->reset();
+        } else {
+            boxGraph = new GraphType(numberOfNodes, 3 * numberOfNodes);
+        }
+        boxGraph->add_node(numberOfNodes);
+
+        // the sink segment takes alpha
+        std::size_t seed = 0;
+        std::size_t node = 0;
+        for (unsigned int z = first[2]; z < end[2]; ++z) {
+            for (unsigned int y = first[1]; y < end[1]; ++y) {
+                std::size_t voxel = first[0] + y * stride(1) + z * stride(2);
+                seed = std::lower_bound(seedVoxels + seed, seedVoxels + numberOfSeeds, (VoxelType) voxel) - seedVoxels;
+                for (unsigned int x = first[0]; x < end[0]; ++x, ++voxel, ++node) {
+                    int terminal = 0;
+                    if (seed < numberOfSeeds && seedVoxels[seed] == voxel) {
+                        terminal += dataCost(seed, alpha) - dataCost(seed, labeling[voxel]);
+                        ++seed;
+                    }
+
+                    const unsigned int coordinates[3] = {x, y, z};
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (coordinates[d] + 1 < dimensions[d]) {
+                            const std::size_t neighbor = voxel + stride(d);
+                            const int weight = edgeWeights[3 * voxel + d];
+                            if (coordinates[d] + 1 < end[d]) {
+                                int terminalNeighbor = 0, forward, backward;
+                                splitPairwise(weight * labelCost(labeling[voxel], labeling[neighbor]),
+                                              weight * labelCost(labeling[voxel], alpha),
+                                              weight * labelCost(alpha, labeling[neighbor]),
+                                              weight * labelCost(alpha, alpha),
+                                              terminal, terminalNeighbor, forward, backward);
+                                addTerminalCapacity(boxGraph, node + boxStrides[d], terminalNeighbor);
+                                boxGraph->add_edge(node, node + boxStrides[d], forward, backward);
+                            } else {
+                                // the next neighbor is outside the box and keeps its label
+                                terminal += weight * (labelCost(alpha, labeling[neighbor]) -
+                                                      labelCost(labeling[voxel], labeling[neighbor]));
+                            }
+                        }
+
+                        // the previous neighbor is outside the box and keeps its label
+                        if (coordinates[d] == first[d] && coordinates[d] > 0) {
+                            const std::size_t neighbor = voxel - stride(d);
+                            const int weight = edgeWeights[3 * neighbor + d];
+                            terminal += weight * (labelCost(labeling[neighbor], alpha) -
+                                                  labelCost(labeling[neighbor], labeling[voxel]));
+                        }
+                    }
+                    addTerminalCapacity(boxGraph, node, terminal);
+                }
+            }
+        }
+
+        boxGraph->maxflow();
+
+        std::size_t changed = 0;
+        node = 0;
+        for (unsigned int z = first[2]; z < end[2]; ++z) {
+            for (unsigned int y = first[1]; y < end[1]; ++y) {
+                std::size_t voxel = first[0] + y * stride(1) + z * stride(2);
+                for (unsigned int x = first[0]; x < end[0]; ++x, ++voxel, ++node) {
+                    if (labeling[voxel] != alpha && boxGraph->what_segment(node) == GraphType::SINK) {
+                        labeling[voxel] = alpha;
+                        ++changed;
+                    }
+                }
+            }
+        }
+        return changed;
+    }
+
+    // labels of the leaves of every subtree
+    static void collectLeaves(const std::vector<LabelTreeNode> &tree, unsigned int node,
+                              std::vector<std::vector<LabelType> > &leaves) {
+        if (tree[node].children[0] < 0) {
+            leaves[node].assign(1, tree[node].label);
+            return;
+        }
+        leaves[node].clear();
+        for (unsigned int side = 0; side < 2; ++side) {
+            const unsigned int child = tree[node].children[side];
+            collectLeaves(tree, child, leaves);
+            leaves[node].insert(leaves[node].end(), leaves[child].begin(), leaves[child].end());
+        }
+    }
+
+    // Cuts the voxels of an internal tree node between its children with the graph of the thread. The voxels of the
+    // node are numbered in nodeOfVoxel, a neighbor is in the cut if its tree node is the same.
+    void cutTreeNode(unsigned int thread, const LabelTreeNode &treeNode, const std::vector<signed char> &side,
+                     int crossCost, const std::vector<std::size_t> &voxels, const std::vector<int> &treeNodes,
+                     std::vector<int> &nextTreeNodes) {
+        GraphType *&cutGraph = blockGraphs[thread];
+        if (cutGraph) {
+            cutGraph->reset();
+        } else {
+            cutGraph = new GraphType(voxels.size(), 3 * voxels.size());
+        }
+        cutGraph->add_node(voxels.size());
+
+        // the sink segment takes the second child
+        std::size_t seed = 0;
+        for (std::size_t node = 0; node < voxels.size(); ++node) {
+            const std::size_t voxel = voxels[node];
+            const int treeNodeOfVoxel = treeNodes[voxel];
+            seed = std::lower_bound(seedVoxels + seed, seedVoxels + numberOfSeeds, (VoxelType) voxel) - seedVoxels;
+            if (seed < numberOfSeeds && seedVoxels[seed] == voxel && side[seedLabels[seed]] >= 0) {
+                addTerminalCapacity(cutGraph, node, side[seedLabels[seed]] == 0 ? defaultCost : -defaultCost);
+            }
+
+            const std::size_t coordinates[3] = {voxel % dimensions[0], (voxel / dimensions[0]) % dimensions[1],
+                                                voxel / ((std::size_t) dimensions[0] * dimensions[1])};
+            for (unsigned int d = 0; d < 3; ++d) {
+                if (coordinates[d] + 1 < dimensions[d] && treeNodes[voxel + stride(d)] == treeNodeOfVoxel) {
+                    const int capacity = edgeWeights[3 * voxel + d] * crossCost;
+                    cutGraph->add_edge(node, nodeOfVoxel[voxel + stride(d)], capacity, capacity);
+                }
+            }
+        }
+
+        cutGraph->maxflow();
+
+        for (std::size_t node = 0; node < voxels.size(); ++node) {
+            nextTreeNodes[voxels[node]] = treeNode.children[cutGraph->what_segment(node) == GraphType::SINK ? 1 : 0];
+        }
+    }
+
+    static void addTerminalCapacity(GraphType *g, int node, int capacity) {
+        g->add_tweights(node, capacity > 0 ? capacity : 0, capacity < 0 ? -capacity : 0);
+    }
+
+    std::size_t stride(unsigned int d) const {
+        return d == 0 ? 1 : (d == 1 ? dimensions[0] : (std::size_t) dimensions[0] * dimensions[1]);
+    }
+
+    int dataCost(std::size_t seed, LabelType label) const {
+        return seedLabels[seed] == label ? 0 : defaultCost;
+    }
+
+    int labelCost(LabelType label, LabelType otherLabel) const {
+        return labelCosts[label + otherLabel * numberOfLabels];
+    }
+
+    // rewrites the residual capacity of an arc, the flow of the previous expansion is dropped
+    void setCapacity(typename GraphType::arc_id arc, int capacity, std::size_t tail, std::size_t head) {
+        if (graph->get_rcap(arc) != capacity) {
+            graph->set_rcap(arc, capacity);
+            markNode(tail);
+            markNode(head);
+        }
+    }
+
+    void markNode(std::size_t node) {
+        if (!firstSolve) {
+            graph->mark_node(node);
+        }
+    }
+
+    GraphType *graph;
+    unsigned int dimensions[3];
+    std::size_t numberOfVoxels;
+    unsigned int numberOfLabels;
+
+    // costs
+    const WeightType *edgeWeights;
+    const WeightType *labelCosts;
+    int defaultCost;
+    std::size_t numberOfSeeds;
+    const VoxelType *seedVoxels;
+    const LabelType *seedLabels;
+
+    std::vector<LabelType> labeling;
+    std::vector<int> terminalCapacities;    // of the current expansion, source minus sink
+    std::vector<LabelType> proposedLabels;  // of the current fusion
+    bool firstSolve;
+    unsigned int numberOfThreads;           // of computeEnergy()
+    std::vector<Cycle> cycles;
+
+    // swap moves
+    GraphType *swapGraph;
+    std::vector<std::size_t> activeVoxels;
+    std::vector<int> nodeOfVoxel;           // -1 for voxels not in the swap
+
+    // parallel and localized expansion, hierarchical cut
+    std::vector<GraphType *> blockGraphs;   // one per thread
+    std::vector<std::vector<EnergyType> > threadEnergies;
+};
+
+#endif //__MultiLabelGraphKolmogorov_hxx_
@@ -16,7 +16,9 @@ template <typename captype, typename tcaptype, typename flowtype>
 	Graph<captype, tcaptype, flowtype>::Graph(int node_num_max, int edge_num_max, void (*err_function)(const char *))
 	: node_num(0),
 	  nodeptr_block(NULL),
-	  error_function(err_function)
+	  error_function(err_function),
+	  augmentation_budget(0),
+	  time_budget(0)
 {
 	if (node_num_max < 16) node_num_max = 16;
 	if (edge_num_max < 16) edge_num_max = 16;
@@ -32,6 +34,8 @@ template <typename captype, typename tcaptype, typename flowtype>
 
 	maxflow_iteration = 0;
 	flow = 0;
+	interrupted = false;
+	nodes_marked = false;
 }
 
 template <typename captype, typename tcaptype, typename flowtype> 
@@ -61,6 +65,8 @@ template <typename captype, typename tcaptype, typename flowtype>
 
 	maxflow_iteration = 0;
 	flow = 0;
+	interrupted = false;
+	nodes_marked = false;
 }
 
 template <typename captype, typename tcaptype, typename flowtype> 
@@ -122,6 +122,11 @@ public:
 	//       No internal memory is allocated by this call.
 	void add_tweights(node_id i, tcaptype cap_source, tcaptype cap_sink);
 
+	// Same as add_tweights(first+k, cap_source[k], cap_sink[k]) for k<num, e.g. for the
+	// terminal weights of a whole image in node order. A NULL array adds 0 on its side.
+	template <typename T>
+	void add_tweights(node_id first, int num, const T* cap_source, const T* cap_sink);
+
 
 	// Computes the maxflow. Can be called several times.
 	// FOR DESCRIPTION OF reuse_trees, SEE mark_node().
@@ -268,6 +273,24 @@ public:
 		nodes[i].is_in_changed_list = 0;
 	}
 
+	///////////////////////////////////////////
+	// 6. Interrupting and resuming maxflow. //
+	///////////////////////////////////////////
+
+	// Limits the following calls to maxflow(): the computation stops after
+	// max_augmentations augmenting paths or max_seconds of wall-clock time
+	// (0 means no limit). If it stops early, maxflow() returns the flow found
+	// so far, maxflow_interrupted() returns true and what_segment() returns
+	// the cut given by the current search trees, which need not be minimal.
+	// maxflow(true) continues the computation where it stopped. The graph
+	// may be changed before, as described for mark_node().
+	void set_maxflow_budget(int max_augmentations, double max_seconds)
+	{
+		augmentation_budget = max_augmentations;
+		time_budget = max_seconds;
+	}
+	bool maxflow_interrupted() { return interrupted; }
+
 
 
 
@@ -331,6 +354,12 @@ private:
 	int					maxflow_iteration; // counter
 	Block<node_id>		*changed_list;
 
+	// interrupting maxflow
+	int					augmentation_budget;
+	double				time_budget;
+	bool				interrupted;
+	bool				nodes_marked;	// mark_node() was called after the interruption
+
 	/////////////////////////////////////////////////////////////////////////
 
 	node				*queue_first[2], *queue_last[2];	// list of active nodes
@@ -354,6 +383,7 @@ private:
 
 	void maxflow_init();             // called if reuse_trees == false
 	void maxflow_reuse_trees_init(); // called if reuse_trees == true
+	void maxflow_suspend(node *current_node); // called if the budget is exhausted
 	void augment(arc *middle_arc);
 	void process_source_orphan(node *i);
 	void process_sink_orphan(node *i);
@@ -404,6 +434,18 @@ template <typename captype, typename tcaptype, typename flowtype>
 	nodes[i].tr_cap = cap_source - cap_sink;
 }
 
+template <typename captype, typename tcaptype, typename flowtype>
+	template <typename T>
+	inline void Graph<captype,tcaptype,flowtype>::add_tweights(node_id first, int num, const T* cap_source, const T* cap_sink)
+{
+	assert(first >= 0 && first + num <= node_num);
+
+	for (int k=0; k<num; k++)
+	{
+		add_tweights(first + k, cap_source ? (tcaptype) cap_source[k] : 0, cap_sink ? (tcaptype) cap_sink[k] : 0);
+	}
+}
+
 template <typename captype, typename tcaptype, typename flowtype> 
 	inline void Graph<captype,tcaptype,flowtype>::add_edge(node_id _i, node_id _j, captype cap, captype rev_cap)
 {
@@ -508,6 +550,7 @@ template <typename captype, typename tcaptype, typename flowtype>
 		i -> next = i;
 	}
 	i->is_marked = 1;
+	nodes_marked = true;
 }
 
 
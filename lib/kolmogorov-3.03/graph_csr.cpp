@@ -0,0 +1,136 @@
+/* graph_csr.cpp */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "graph_csr.h"
+
+
+template <typename captype, typename tcaptype, typename flowtype>
+	GraphCSR<captype, tcaptype, flowtype>::GraphCSR(int node_num_max, int edge_num_max, void (*err_function)(const char *))
+	: node_num(0),
+	  arc_num(0),
+	  sorted_arc_num(0),
+	  error_function(err_function),
+	  augmentation_budget(0),
+	  time_budget(0)
+{
+	if (node_num_max < 16) node_num_max = 16;
+	if (edge_num_max < 16) edge_num_max = 16;
+
+	tr_cap.reserve(node_num_max);
+	parent.reserve(node_num_max);
+	dist.reserve(node_num_max);
+	flags.reserve(node_num_max);
+	first.reserve(node_num_max + 1);
+	next.reserve(node_num_max);
+	first.push_back(0);
+
+	new_head.reserve(2*edge_num_max);
+	new_cap.reserve(2*edge_num_max);
+
+	maxflow_iteration = 0;
+	flow = 0;
+	interrupted = false;
+	nodes_marked = false;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	GraphCSR<captype,tcaptype,flowtype>::~GraphCSR()
+{
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::reset()
+{
+	tr_cap.clear();
+	parent.clear();
+	dist.clear();
+	flags.clear();
+	first.clear();
+	first.push_back(0);
+	next.clear();
+
+	head.clear();
+	sister.clear();
+	r_cap.clear();
+	arc_position.clear();
+	new_head.clear();
+	new_cap.clear();
+
+	node_num = 0;
+	arc_num = 0;
+	sorted_arc_num = 0;
+
+	maxflow_iteration = 0;
+	flow = 0;
+	interrupted = false;
+	nodes_marked = false;
+}
+
+/*
+	Merges the arcs added since the last call into the sorted arrays
+	(a counting sort by the originating node). Within the range of a node
+	the arcs are stored in reverse order of their addition, which is the order
+	in which Graph visits them. Residual capacities and search trees are kept,
+	parent[] is translated to the new positions.
+*/
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::sort_arcs()
+{
+	unsigned int a, a_new, i;
+	unsigned int arc_num_old = (unsigned int) sorted_arc_num;
+
+	if ((unsigned long) arc_num >= (unsigned long) ORPHAN)
+	{
+		if (error_function) (*error_function)("Too many arcs!");
+		exit(1);
+	}
+
+	std::vector<unsigned int> tail(arc_num);
+	for (a=0; a<arc_num_old; a++) tail[a] = head[sister[arc_position[a]]];
+	for (a=arc_num_old; a<(unsigned int)arc_num; a++) tail[a] = new_head[(a - arc_num_old) ^ 1];
+
+	std::vector<unsigned int> first_new(node_num + 1, 0);
+	for (a=0; a<(unsigned int)arc_num; a++) first_new[tail[a] + 1] ++;
+	for (i=0; i<(unsigned int)node_num; i++) first_new[i + 1] += first_new[i];
+
+	// position of every arc, filling the range of each node from its end
+	std::vector<unsigned int> position(arc_num);
+	{
+		std::vector<unsigned int> fill(first_new.begin() + 1, first_new.end());
+		for (a=0; a<(unsigned int)arc_num; a++) position[a] = -- fill[tail[a]];
+	}
+
+	std::vector<unsigned int> head_new(arc_num), sister_new(arc_num);
+	std::vector<captype> r_cap_new(arc_num);
+	for (a=0; a<(unsigned int)arc_num; a++)
+	{
+		a_new = position[a];
+		head_new[a_new] = (a < arc_num_old) ? head[arc_position[a]] : new_head[a - arc_num_old];
+		r_cap_new[a_new] = (a < arc_num_old) ? r_cap[arc_position[a]] : new_cap[a - arc_num_old];
+		sister_new[a_new] = position[a ^ 1];
+	}
+
+	if (arc_num_old > 0)
+	{
+		// old position -> new position
+		std::vector<unsigned int> moved(arc_num_old);
+		for (a=0; a<arc_num_old; a++) moved[arc_position[a]] = position[a];
+		for (i=0; i<(unsigned int)node_num; i++)
+		{
+			if (parent[i] < arc_num_old) parent[i] = moved[parent[i]];
+		}
+	}
+
+	first.swap(first_new);
+	head.swap(head_new);
+	sister.swap(sister_new);
+	r_cap.swap(r_cap_new);
+	arc_position.swap(position);
+	new_head.clear();
+	new_cap.clear();
+	sorted_arc_num = arc_num;
+}
+
+#include "instances_csr.inc"
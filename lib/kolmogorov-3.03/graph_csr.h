@@ -0,0 +1,384 @@
+/* graph_csr.h */
+/*
+    Copyright Vladimir Kolmogorov (vnk@ist.ac.at), Yuri Boykov (yuri@csd.uwo.ca)
+
+    This file is part of MAXFLOW.
+
+    MAXFLOW is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MAXFLOW is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MAXFLOW.  If not, see <http://www.gnu.org/licenses/>.
+
+========================
+
+	Variant of Graph (graph.h) with index based, structure-of-arrays storage.
+
+	Graph links nodes and arcs with pointers, a node takes 48 and an arc 32 bytes
+	on 64-bit systems and the fields used in the inner loops are spread over
+	several cache lines. GraphCSR stores
+
+		- 32-bit indices instead of pointers,
+		- one array per node field; tr_cap, parent, TS/DIST and flags are read in
+		  every step of the growth and adoption stages and kept apart from the
+		  rest,
+		- the arcs of a node contiguously (compressed sparse row). The arcs are
+		  sorted by their originating node when maxflow() is called, edges added
+		  later are merged in by the next call.
+
+	The sister of an arc is kept in an index array. In a general graph the
+	reverse arc lies in the range of the other node, its position depends on the
+	degrees of all nodes in between and can not be computed from the position of
+	the arc.
+
+	The arcs of a node are visited in the same order as in Graph, the search
+	trees and therefore the results of both implementations are identical.
+
+	The interface is the one of Graph, except that arc_id is an index into the
+	arcs in the order they were added (the values returned by get_first_arc()
+	and get_next_arc() are the same as before, only their type differs).
+*/
+
+#ifndef __GRAPH_CSR_H__
+#define __GRAPH_CSR_H__
+
+#include <vector>
+#include "block.h"
+
+#include <assert.h>
+// NOTE: in UNIX you need to use -DNDEBUG preprocessor option to supress assert's!!!
+
+
+
+// captype: type of edge capacities (excluding t-links)
+// tcaptype: type of t-links (edges between nodes and terminals)
+// flowtype: type of total flow
+//
+// Current instantiations are in instances_csr.inc
+template <typename captype, typename tcaptype, typename flowtype> class GraphCSR
+{
+public:
+	typedef enum
+	{
+		SOURCE	= 0,
+		SINK	= 1
+	} termtype; // terminals
+	typedef int node_id;
+	typedef int arc_id;
+
+	/////////////////////////////////////////////////////////////////////////
+	//                     BASIC INTERFACE FUNCTIONS                       //
+	//                      (see graph.h for details)                      //
+	/////////////////////////////////////////////////////////////////////////
+
+	GraphCSR(int node_num_max, int edge_num_max, void (*err_function)(const char *) = NULL);
+
+	~GraphCSR();
+
+	node_id add_node(int num = 1);
+
+	void add_edge(node_id i, node_id j, captype cap, captype rev_cap);
+
+	void add_tweights(node_id i, tcaptype cap_source, tcaptype cap_sink);
+
+	template <typename T>
+	void add_tweights(node_id first, int num, const T* cap_source, const T* cap_sink);
+
+	flowtype maxflow(bool reuse_trees = false, Block<node_id>* changed_list = NULL);
+
+	termtype what_segment(node_id i, termtype default_segm = SOURCE);
+
+	//////////////////////////////////////////////
+	//       ADVANCED INTERFACE FUNCTIONS       //
+	//////////////////////////////////////////////
+
+	void reset();
+
+	arc_id get_first_arc() { return 0; }
+	arc_id get_next_arc(arc_id a) { return a + 1; }
+
+	int get_node_num() { return node_num; }
+	int get_arc_num() { return arc_num; }
+	void get_arc_ends(arc_id a, node_id& i, node_id& j); // returns i,j to that a = i->j
+
+	tcaptype get_trcap(node_id i);
+	captype get_rcap(arc_id a);
+
+	void set_trcap(node_id i, tcaptype trcap);
+	void set_rcap(arc_id a, captype rcap);
+
+	void mark_node(node_id i);
+
+	void remove_from_changed_list(node_id i)
+	{
+		assert(i>=0 && i<node_num && (flags[i] & IS_IN_CHANGED_LIST));
+		flags[i] &= ~IS_IN_CHANGED_LIST;
+	}
+
+	// see graph.h
+	void set_maxflow_budget(int max_augmentations, double max_seconds)
+	{
+		augmentation_budget = max_augmentations;
+		time_budget = max_seconds;
+	}
+	bool maxflow_interrupted() { return interrupted; }
+
+
+
+/////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////
+
+private:
+	// internal variables and functions
+
+	// special values of parent[] and next[]
+	enum
+	{
+		NONE		= 0xFFFFFFFF,	// no parent / not in the active list
+		TERMINAL	= 0xFFFFFFFE,	// to terminal
+		ORPHAN		= 0xFFFFFFFD	// orphan
+	};
+
+	// bits of flags[]
+	enum
+	{
+		IS_SINK				= 1,	// node is in the sink tree (if parent!=NONE)
+		IS_MARKED			= 2,	// set by mark_node()
+		IS_IN_CHANGED_LIST	= 4		// set by maxflow if the node is added to changed_list
+	};
+
+	struct distance
+	{
+		int			TS;			// timestamp showing when DIST was computed
+		int			DIST;		// distance to the terminal
+	};
+
+	// nodes, hot
+	std::vector<tcaptype>		tr_cap;		// if tr_cap > 0 then tr_cap is residual capacity of the arc SOURCE->node
+											// otherwise         -tr_cap is residual capacity of the arc node->SINK
+	std::vector<unsigned int>	parent;		// arc to the node's parent
+	std::vector<distance>		dist;
+	std::vector<unsigned char>	flags;
+	// nodes, cold
+	std::vector<unsigned int>	first;		// arcs of node i are first[i] .. first[i+1]-1
+	std::vector<unsigned int>	next;		// next active node (or the node itself if it is the last node in the list)
+
+	// arcs, sorted by their originating node
+	std::vector<unsigned int>	head;		// node the arc points to
+	std::vector<unsigned int>	sister;		// reverse arc
+	std::vector<captype>		r_cap;		// residual capacity
+
+	// arcs in the order they were added
+	std::vector<unsigned int>	arc_position;	// position of the arc in the sorted arrays
+	std::vector<unsigned int>	new_head;		// head of the arcs added since the last sort
+	std::vector<captype>		new_cap;		// capacity of the arcs added since the last sort
+
+	int					node_num;
+	int					arc_num;
+	int					sorted_arc_num;
+
+	void	(*error_function)(const char *);	// this function is called if a error occurs,
+										// with a corresponding error message
+										// (or exit(1) is called if it's NULL)
+
+	flowtype			flow;		// total flow
+
+	// reusing trees & list of changed pixels
+	int					maxflow_iteration; // counter
+	Block<node_id>		*changed_list;
+
+	// interrupting maxflow
+	int					augmentation_budget;
+	double				time_budget;
+	bool				interrupted;
+	bool				nodes_marked;	// mark_node() was called after the interruption
+
+	/////////////////////////////////////////////////////////////////////////
+
+	unsigned int			queue_first[2], queue_last[2];	// list of active nodes
+	std::vector<unsigned int>	orphan_front;	// orphans added to the beginning of the list, last one first
+	std::vector<unsigned int>	orphan_rear;	// orphans added to the end of the list
+	int					TIME;								// monotonically increasing global counter
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void sort_arcs(); // merges the new arcs into the sorted arrays
+
+	// functions for processing active list
+	void set_active(unsigned int i);
+	unsigned int next_active();
+
+	// functions for processing orphans list
+	void set_orphan_front(unsigned int i); // add to the beginning of the list
+	void set_orphan_rear(unsigned int i);  // add to the end of the list
+	void process_orphans();
+
+	void add_to_changed_list(unsigned int i);
+
+	void maxflow_init();             // called if reuse_trees == false
+	void maxflow_reuse_trees_init(); // called if reuse_trees == true
+	void maxflow_suspend(unsigned int current_node); // called if the budget is exhausted
+	void augment(unsigned int middle_arc);
+	void process_source_orphan(unsigned int i);
+	void process_sink_orphan(unsigned int i);
+};
+
+
+
+
+
+
+
+
+
+
+
+///////////////////////////////////////
+// Implementation - inline functions //
+///////////////////////////////////////
+
+
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline typename GraphCSR<captype,tcaptype,flowtype>::node_id GraphCSR<captype,tcaptype,flowtype>::add_node(int num)
+{
+	assert(num > 0);
+
+	node_id i = node_num;
+	node_num += num;
+
+	unsigned int last_arc = first[i];
+	tr_cap.resize(node_num, 0);
+	parent.resize(node_num, NONE);
+	distance d = { 0, 0 };
+	dist.resize(node_num, d);
+	flags.resize(node_num, 0);
+	first.resize(node_num + 1, last_arc);
+	next.resize(node_num, NONE);
+	return i;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::add_tweights(node_id i, tcaptype cap_source, tcaptype cap_sink)
+{
+	assert(i >= 0 && i < node_num);
+
+	tcaptype delta = tr_cap[i];
+	if (delta > 0) cap_source += delta;
+	else           cap_sink   -= delta;
+	flow += (cap_source < cap_sink) ? cap_source : cap_sink;
+	tr_cap[i] = cap_source - cap_sink;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	template <typename T>
+	inline void GraphCSR<captype,tcaptype,flowtype>::add_tweights(node_id first, int num, const T* cap_source, const T* cap_sink)
+{
+	assert(first >= 0 && first + num <= node_num);
+
+	for (int k=0; k<num; k++)
+	{
+		add_tweights(first + k, cap_source ? (tcaptype) cap_source[k] : 0, cap_sink ? (tcaptype) cap_sink[k] : 0);
+	}
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::add_edge(node_id _i, node_id _j, captype cap, captype rev_cap)
+{
+	assert(_i >= 0 && _i < node_num);
+	assert(_j >= 0 && _j < node_num);
+	assert(_i != _j);
+	assert(cap >= 0);
+	assert(rev_cap >= 0);
+
+	new_head.push_back(_j);
+	new_cap.push_back(cap);
+	new_head.push_back(_i);
+	new_cap.push_back(rev_cap);
+	arc_num += 2;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::get_arc_ends(arc_id a, node_id& i, node_id& j)
+{
+	assert(a >= 0 && a < arc_num);
+	if (a < sorted_arc_num)
+	{
+		i = (node_id) head[sister[arc_position[a]]];
+		j = (node_id) head[arc_position[a]];
+	}
+	else
+	{
+		i = (node_id) new_head[(a - sorted_arc_num) ^ 1];
+		j = (node_id) new_head[a - sorted_arc_num];
+	}
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline tcaptype GraphCSR<captype,tcaptype,flowtype>::get_trcap(node_id i)
+{
+	assert(i>=0 && i<node_num);
+	return tr_cap[i];
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline captype GraphCSR<captype,tcaptype,flowtype>::get_rcap(arc_id a)
+{
+	assert(a >= 0 && a < arc_num);
+	return (a < sorted_arc_num) ? r_cap[arc_position[a]] : new_cap[a - sorted_arc_num];
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::set_trcap(node_id i, tcaptype trcap)
+{
+	assert(i>=0 && i<node_num);
+	tr_cap[i] = trcap;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::set_rcap(arc_id a, captype rcap)
+{
+	assert(a >= 0 && a < arc_num);
+	if (a < sorted_arc_num) r_cap[arc_position[a]] = rcap;
+	else                    new_cap[a - sorted_arc_num] = rcap;
+}
+
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline typename GraphCSR<captype,tcaptype,flowtype>::termtype GraphCSR<captype,tcaptype,flowtype>::what_segment(node_id i, termtype default_segm)
+{
+	if (parent[i] != NONE)
+	{
+		return (flags[i] & IS_SINK) ? SINK : SOURCE;
+	}
+	else
+	{
+		return default_segm;
+	}
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::mark_node(node_id i)
+{
+	if (next[i] == NONE)
+	{
+		/* it's not in the list yet */
+		if (queue_last[1] != NONE) next[queue_last[1]] = i;
+		else                       queue_first[1]      = i;
+		queue_last[1] = i;
+		next[i] = i;
+	}
+	flags[i] |= IS_MARKED;
+	nodes_marked = true;
+}
+
+
+#endif
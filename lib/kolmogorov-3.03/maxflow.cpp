@@ -2,6 +2,7 @@
 
 
 #include <stdio.h>
+#include <chrono>
 #include "graph.h"
 
 
@@ -175,6 +176,12 @@ template <typename captype, typename tcaptype, typename flowtype>
 		queue = i->next;
 		if (queue == i) queue = NULL;
 		i->next = NULL;
+		if (!i->is_marked)
+		{
+			/* still active from an interrupted maxflow() */
+			set_active(i);
+			continue;
+		}
 		i->is_marked = 0;
 		set_active(i);
 
@@ -240,6 +247,29 @@ template <typename captype, typename tcaptype, typename flowtype>
 	//test_consistency();
 }
 
+/*
+	Moves all active nodes to the second queue, where
+	maxflow_reuse_trees_init() expects the marked nodes,
+	so that maxflow(true) continues with them.
+*/
+template <typename captype, typename tcaptype, typename flowtype> 
+	void Graph<captype,tcaptype,flowtype>::maxflow_suspend(node *current_node)
+{
+	if (current_node)
+	{
+		current_node -> next = NULL;
+		if (current_node->parent) set_active(current_node);
+	}
+	if (queue_first[0])
+	{
+		if (queue_first[1]) queue_last[0] -> next = queue_first[1];
+		else                queue_last[1] = queue_last[0];
+		queue_first[1] = queue_first[0];
+		queue_first[0] = queue_last[0] = NULL;
+	}
+	interrupted = true;
+}
+
 template <typename captype, typename tcaptype, typename flowtype> 
 	void Graph<captype,tcaptype,flowtype>::augment(arc *middle_arc)
 {
@@ -474,6 +504,8 @@ template <typename captype, typename tcaptype, typename flowtype>
 	node *i, *j, *current_node = NULL;
 	arc *a;
 	nodeptr *np, *np_next;
+	int augmentations = 0, steps = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
 	if (!nodeptr_block)
 	{
@@ -484,14 +516,25 @@ template <typename captype, typename tcaptype, typename flowtype>
 	if (maxflow_iteration == 0 && reuse_trees) { if (error_function) (*error_function)("reuse_trees cannot be used in the first call to maxflow()!"); exit(1); }
 	if (changed_list && !reuse_trees) { if (error_function) (*error_function)("changed_list cannot be used without reuse_trees!"); exit(1); }
 
-	if (reuse_trees) maxflow_reuse_trees_init();
-	else             maxflow_init();
+	if (!reuse_trees) maxflow_init();
+	else if (!interrupted || nodes_marked) maxflow_reuse_trees_init();
+	/* else the trees and active nodes are still as maxflow_suspend() left them */
+	interrupted = false;
+	nodes_marked = false;
 
 	// main loop
 	while ( 1 )
 	{
 		// test_consistency(current_node);
 
+		if ((augmentation_budget > 0 && augmentations >= augmentation_budget) ||
+		    (time_budget > 0 && (++steps & 255) == 0 &&
+		     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= time_budget))
+		{
+			maxflow_suspend(current_node);
+			break;
+		}
+
 		if ((i=current_node))
 		{
 			i -> next = NULL; /* remove active flag */
@@ -567,6 +610,7 @@ template <typename captype, typename tcaptype, typename flowtype>
 
 			/* augmentation */
 			augment(a);
+			augmentations ++;
 			/* augmentation end */
 
 			/* adoption */
@@ -0,0 +1,624 @@
+/* maxflow_csr.cpp */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "graph_csr.h"
+
+
+/*
+	Same algorithm as maxflow.cpp, with nodes and arcs addressed by index.
+	The arcs of node i are first[i] .. first[i+1]-1.
+*/
+
+
+#define INFINITE_D ((int)(((unsigned)-1)/2))		/* infinite distance to the terminal */
+
+/***********************************************************************/
+
+/*
+	Functions for processing active list.
+	next[i] is the next node in the list
+	(or i, if i is the last node in the list).
+	next[i] is NONE iff i is not in the list.
+
+	There are two queues. Active nodes are added
+	to the end of the second queue and read from
+	the front of the first queue. If the first queue
+	is empty, it is replaced by the second queue
+	(and the second queue becomes empty).
+*/
+
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::set_active(unsigned int i)
+{
+	if (next[i] == NONE)
+	{
+		/* it's not in the list yet */
+		if (queue_last[1] != NONE) next[queue_last[1]] = i;
+		else                       queue_first[1]      = i;
+		queue_last[1] = i;
+		next[i] = i;
+	}
+}
+
+/*
+	Returns the next active node.
+	If it is connected to the sink, it stays in the list,
+	otherwise it is removed from the list
+*/
+template <typename captype, typename tcaptype, typename flowtype>
+	inline unsigned int GraphCSR<captype,tcaptype,flowtype>::next_active()
+{
+	unsigned int i;
+
+	while ( 1 )
+	{
+		if ((i=queue_first[0]) == NONE)
+		{
+			queue_first[0] = i = queue_first[1];
+			queue_last[0]  = queue_last[1];
+			queue_first[1] = NONE;
+			queue_last[1]  = NONE;
+			if (i == NONE) return NONE;
+		}
+
+		/* remove it from the active list */
+		if (next[i] == i) queue_first[0] = queue_last[0] = NONE;
+		else              queue_first[0] = next[i];
+		next[i] = NONE;
+
+		/* a node in the list is active iff it has a parent */
+		if (parent[i] != NONE) return i;
+	}
+}
+
+/***********************************************************************/
+
+/*
+	The orphans of an augmentation are added to the front of the list, the
+	orphans found while processing one of them to the rear. Graph processes
+	the first orphan together with everything added behind it before it moves
+	on to the second one, so the list is kept as a stack (front) and a queue
+	(rear).
+*/
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::set_orphan_front(unsigned int i)
+{
+	parent[i] = ORPHAN;
+	orphan_front.push_back(i);
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::set_orphan_rear(unsigned int i)
+{
+	parent[i] = ORPHAN;
+	orphan_rear.push_back(i);
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::process_orphans()
+{
+	unsigned int i;
+	size_t np;
+
+	for (np=0; np<orphan_rear.size(); np++)
+	{
+		i = orphan_rear[np];
+		if (flags[i] & IS_SINK) process_sink_orphan(i);
+		else                    process_source_orphan(i);
+	}
+	orphan_rear.clear();
+}
+
+/***********************************************************************/
+
+template <typename captype, typename tcaptype, typename flowtype>
+	inline void GraphCSR<captype,tcaptype,flowtype>::add_to_changed_list(unsigned int i)
+{
+	if (changed_list && !(flags[i] & IS_IN_CHANGED_LIST))
+	{
+		node_id* ptr = changed_list->New();
+		*ptr = (node_id) i;
+		flags[i] |= IS_IN_CHANGED_LIST;
+	}
+}
+
+/***********************************************************************/
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::maxflow_init()
+{
+	unsigned int i;
+
+	queue_first[0] = queue_last[0] = NONE;
+	queue_first[1] = queue_last[1] = NONE;
+	orphan_front.clear();
+	orphan_rear.clear();
+
+	TIME = 0;
+
+	for (i=0; i<(unsigned int)node_num; i++)
+	{
+		next[i] = NONE;
+		flags[i] &= ~(IS_MARKED | IS_IN_CHANGED_LIST);
+		dist[i].TS = TIME;
+		if (tr_cap[i] > 0)
+		{
+			/* i is connected to the source */
+			flags[i] &= ~IS_SINK;
+			parent[i] = TERMINAL;
+			set_active(i);
+			dist[i].DIST = 1;
+		}
+		else if (tr_cap[i] < 0)
+		{
+			/* i is connected to the sink */
+			flags[i] |= IS_SINK;
+			parent[i] = TERMINAL;
+			set_active(i);
+			dist[i].DIST = 1;
+		}
+		else
+		{
+			parent[i] = NONE;
+		}
+	}
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::maxflow_reuse_trees_init()
+{
+	unsigned int i, j, a;
+	unsigned int queue = queue_first[1];
+
+	queue_first[0] = queue_last[0] = NONE;
+	queue_first[1] = queue_last[1] = NONE;
+	orphan_front.clear();
+	orphan_rear.clear();
+
+	TIME ++;
+
+	while ((i=queue) != NONE)
+	{
+		queue = next[i];
+		if (queue == i) queue = NONE;
+		next[i] = NONE;
+		if (!(flags[i] & IS_MARKED))
+		{
+			/* still active from an interrupted maxflow() */
+			set_active(i);
+			continue;
+		}
+		flags[i] &= ~IS_MARKED;
+		set_active(i);
+
+		if (tr_cap[i] == 0)
+		{
+			if (parent[i] != NONE) set_orphan_rear(i);
+			continue;
+		}
+
+		if (tr_cap[i] > 0)
+		{
+			if (parent[i] == NONE || (flags[i] & IS_SINK))
+			{
+				flags[i] &= ~IS_SINK;
+				for (a=first[i]; a<first[i+1]; a++)
+				{
+					j = head[a];
+					if (!(flags[j] & IS_MARKED))
+					{
+						if (parent[j] == sister[a]) set_orphan_rear(j);
+						if (parent[j] != NONE && (flags[j] & IS_SINK) && r_cap[a] > 0) set_active(j);
+					}
+				}
+				add_to_changed_list(i);
+			}
+		}
+		else
+		{
+			if (parent[i] == NONE || !(flags[i] & IS_SINK))
+			{
+				flags[i] |= IS_SINK;
+				for (a=first[i]; a<first[i+1]; a++)
+				{
+					j = head[a];
+					if (!(flags[j] & IS_MARKED))
+					{
+						if (parent[j] == sister[a]) set_orphan_rear(j);
+						if (parent[j] != NONE && !(flags[j] & IS_SINK) && r_cap[sister[a]] > 0) set_active(j);
+					}
+				}
+				add_to_changed_list(i);
+			}
+		}
+		parent[i] = TERMINAL;
+		dist[i].TS = TIME;
+		dist[i].DIST = 1;
+	}
+
+	/* adoption */
+	process_orphans();
+	/* adoption end */
+}
+
+/*
+	Moves all active nodes to the second queue, where
+	maxflow_reuse_trees_init() expects the marked nodes,
+	so that maxflow(true) continues with them.
+*/
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::maxflow_suspend(unsigned int current_node)
+{
+	if (current_node != NONE)
+	{
+		next[current_node] = NONE;
+		if (parent[current_node] != NONE) set_active(current_node);
+	}
+	if (queue_first[0] != NONE)
+	{
+		if (queue_first[1] != NONE) next[queue_last[0]] = queue_first[1];
+		else                        queue_last[1] = queue_last[0];
+		queue_first[1] = queue_first[0];
+		queue_first[0] = queue_last[0] = NONE;
+	}
+	interrupted = true;
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::augment(unsigned int middle_arc)
+{
+	unsigned int i, a;
+	tcaptype bottleneck;
+
+
+	/* 1. Finding bottleneck capacity */
+	/* 1a - the source tree */
+	bottleneck = r_cap[middle_arc];
+	for (i=head[sister[middle_arc]]; ; i=head[a])
+	{
+		a = parent[i];
+		if (a == TERMINAL) break;
+		if (bottleneck > r_cap[sister[a]]) bottleneck = r_cap[sister[a]];
+	}
+	if (bottleneck > tr_cap[i]) bottleneck = tr_cap[i];
+	/* 1b - the sink tree */
+	for (i=head[middle_arc]; ; i=head[a])
+	{
+		a = parent[i];
+		if (a == TERMINAL) break;
+		if (bottleneck > r_cap[a]) bottleneck = r_cap[a];
+	}
+	if (bottleneck > - tr_cap[i]) bottleneck = - tr_cap[i];
+
+
+	/* 2. Augmenting */
+	/* 2a - the source tree */
+	r_cap[sister[middle_arc]] += bottleneck;
+	r_cap[middle_arc] -= bottleneck;
+	for (i=head[sister[middle_arc]]; ; i=head[a])
+	{
+		a = parent[i];
+		if (a == TERMINAL) break;
+		r_cap[a] += bottleneck;
+		r_cap[sister[a]] -= bottleneck;
+		if (!r_cap[sister[a]])
+		{
+			set_orphan_front(i); // add i to the beginning of the adoption list
+		}
+	}
+	tr_cap[i] -= bottleneck;
+	if (!tr_cap[i])
+	{
+		set_orphan_front(i); // add i to the beginning of the adoption list
+	}
+	/* 2b - the sink tree */
+	for (i=head[middle_arc]; ; i=head[a])
+	{
+		a = parent[i];
+		if (a == TERMINAL) break;
+		r_cap[sister[a]] += bottleneck;
+		r_cap[a] -= bottleneck;
+		if (!r_cap[a])
+		{
+			set_orphan_front(i); // add i to the beginning of the adoption list
+		}
+	}
+	tr_cap[i] += bottleneck;
+	if (!tr_cap[i])
+	{
+		set_orphan_front(i); // add i to the beginning of the adoption list
+	}
+
+
+	flow += bottleneck;
+}
+
+/***********************************************************************/
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::process_source_orphan(unsigned int i)
+{
+	unsigned int j, a0, a0_min = NONE, a;
+	int d, d_min = INFINITE_D;
+
+	/* trying to find a new parent */
+	for (a0=first[i]; a0<first[i+1]; a0++)
+	if (r_cap[sister[a0]])
+	{
+		j = head[a0];
+		if (!(flags[j] & IS_SINK) && parent[j] != NONE)
+		{
+			/* checking the origin of j */
+			d = 0;
+			while ( 1 )
+			{
+				if (dist[j].TS == TIME)
+				{
+					d += dist[j].DIST;
+					break;
+				}
+				a = parent[j];
+				d ++;
+				if (a==TERMINAL)
+				{
+					dist[j].TS = TIME;
+					dist[j].DIST = 1;
+					break;
+				}
+				if (a==ORPHAN) { d = INFINITE_D; break; }
+				j = head[a];
+			}
+			if (d<INFINITE_D) /* j originates from the source - done */
+			{
+				if (d<d_min)
+				{
+					a0_min = a0;
+					d_min = d;
+				}
+				/* set marks along the path */
+				for (j=head[a0]; dist[j].TS!=TIME; j=head[parent[j]])
+				{
+					dist[j].TS = TIME;
+					dist[j].DIST = d --;
+				}
+			}
+		}
+	}
+
+	if ((parent[i] = a0_min) != NONE)
+	{
+		dist[i].TS = TIME;
+		dist[i].DIST = d_min + 1;
+	}
+	else
+	{
+		/* no parent is found */
+		add_to_changed_list(i);
+
+		/* process neighbors */
+		for (a0=first[i]; a0<first[i+1]; a0++)
+		{
+			j = head[a0];
+			if (!(flags[j] & IS_SINK) && (a=parent[j]) != NONE)
+			{
+				if (r_cap[sister[a0]]) set_active(j);
+				if (a!=TERMINAL && a!=ORPHAN && head[a]==i)
+				{
+					set_orphan_rear(j); // add j to the end of the adoption list
+				}
+			}
+		}
+	}
+}
+
+template <typename captype, typename tcaptype, typename flowtype>
+	void GraphCSR<captype,tcaptype,flowtype>::process_sink_orphan(unsigned int i)
+{
+	unsigned int j, a0, a0_min = NONE, a;
+	int d, d_min = INFINITE_D;
+
+	/* trying to find a new parent */
+	for (a0=first[i]; a0<first[i+1]; a0++)
+	if (r_cap[a0])
+	{
+		j = head[a0];
+		if ((flags[j] & IS_SINK) && parent[j] != NONE)
+		{
+			/* checking the origin of j */
+			d = 0;
+			while ( 1 )
+			{
+				if (dist[j].TS == TIME)
+				{
+					d += dist[j].DIST;
+					break;
+				}
+				a = parent[j];
+				d ++;
+				if (a==TERMINAL)
+				{
+					dist[j].TS = TIME;
+					dist[j].DIST = 1;
+					break;
+				}
+				if (a==ORPHAN) { d = INFINITE_D; break; }
+				j = head[a];
+			}
+			if (d<INFINITE_D) /* j originates from the sink - done */
+			{
+				if (d<d_min)
+				{
+					a0_min = a0;
+					d_min = d;
+				}
+				/* set marks along the path */
+				for (j=head[a0]; dist[j].TS!=TIME; j=head[parent[j]])
+				{
+					dist[j].TS = TIME;
+					dist[j].DIST = d --;
+				}
+			}
+		}
+	}
+
+	if ((parent[i] = a0_min) != NONE)
+	{
+		dist[i].TS = TIME;
+		dist[i].DIST = d_min + 1;
+	}
+	else
+	{
+		/* no parent is found */
+		add_to_changed_list(i);
+
+		/* process neighbors */
+		for (a0=first[i]; a0<first[i+1]; a0++)
+		{
+			j = head[a0];
+			if ((flags[j] & IS_SINK) && (a=parent[j]) != NONE)
+			{
+				if (r_cap[a0]) set_active(j);
+				if (a!=TERMINAL && a!=ORPHAN && head[a]==i)
+				{
+					set_orphan_rear(j); // add j to the end of the adoption list
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************************/
+
+template <typename captype, typename tcaptype, typename flowtype>
+	flowtype GraphCSR<captype,tcaptype,flowtype>::maxflow(bool reuse_trees, Block<node_id>* _changed_list)
+{
+	unsigned int i, j, a, middle_arc, current_node = NONE;
+	int augmentations = 0, steps = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	changed_list = _changed_list;
+	if (maxflow_iteration == 0 && reuse_trees) { if (error_function) (*error_function)("reuse_trees cannot be used in the first call to maxflow()!"); exit(1); }
+	if (changed_list && !reuse_trees) { if (error_function) (*error_function)("changed_list cannot be used without reuse_trees!"); exit(1); }
+
+	if (!new_head.empty()) sort_arcs();
+
+	if (!reuse_trees) maxflow_init();
+	else if (!interrupted || nodes_marked) maxflow_reuse_trees_init();
+	/* else the trees and active nodes are still as maxflow_suspend() left them */
+	interrupted = false;
+	nodes_marked = false;
+
+	// main loop
+	while ( 1 )
+	{
+		if ((augmentation_budget > 0 && augmentations >= augmentation_budget) ||
+		    (time_budget > 0 && (++steps & 255) == 0 &&
+		     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= time_budget))
+		{
+			maxflow_suspend(current_node);
+			break;
+		}
+
+		if ((i=current_node) != NONE)
+		{
+			next[i] = NONE; /* remove active flag */
+			if (parent[i] == NONE) i = NONE;
+		}
+		if (i == NONE)
+		{
+			if ((i = next_active()) == NONE) break;
+		}
+
+		/* growth */
+		middle_arc = NONE;
+		if (!(flags[i] & IS_SINK))
+		{
+			/* grow source tree */
+			for (a=first[i]; a<first[i+1]; a++)
+			if (r_cap[a])
+			{
+				j = head[a];
+				if (parent[j] == NONE)
+				{
+					flags[j] &= ~IS_SINK;
+					parent[j] = sister[a];
+					dist[j].TS = dist[i].TS;
+					dist[j].DIST = dist[i].DIST + 1;
+					set_active(j);
+					add_to_changed_list(j);
+				}
+				else if (flags[j] & IS_SINK) { middle_arc = a; break; }
+				else if (dist[j].TS <= dist[i].TS &&
+				         dist[j].DIST > dist[i].DIST)
+				{
+					/* heuristic - trying to make the distance from j to the source shorter */
+					parent[j] = sister[a];
+					dist[j].TS = dist[i].TS;
+					dist[j].DIST = dist[i].DIST + 1;
+				}
+			}
+		}
+		else
+		{
+			/* grow sink tree */
+			for (a=first[i]; a<first[i+1]; a++)
+			if (r_cap[sister[a]])
+			{
+				j = head[a];
+				if (parent[j] == NONE)
+				{
+					flags[j] |= IS_SINK;
+					parent[j] = sister[a];
+					dist[j].TS = dist[i].TS;
+					dist[j].DIST = dist[i].DIST + 1;
+					set_active(j);
+					add_to_changed_list(j);
+				}
+				else if (!(flags[j] & IS_SINK)) { middle_arc = sister[a]; break; }
+				else if (dist[j].TS <= dist[i].TS &&
+				         dist[j].DIST > dist[i].DIST)
+				{
+					/* heuristic - trying to make the distance from j to the sink shorter */
+					parent[j] = sister[a];
+					dist[j].TS = dist[i].TS;
+					dist[j].DIST = dist[i].DIST + 1;
+				}
+			}
+		}
+
+		TIME ++;
+
+		if (middle_arc != NONE)
+		{
+			next[i] = i; /* set active flag */
+			current_node = i;
+
+			/* augmentation */
+			augment(middle_arc);
+			augmentations ++;
+			/* augmentation end */
+
+			/* adoption */
+			while (!orphan_front.empty())
+			{
+				i = orphan_front.back();
+				orphan_front.pop_back();
+				if (flags[i] & IS_SINK) process_sink_orphan(i);
+				else                    process_source_orphan(i);
+				process_orphans();
+			}
+			/* adoption end */
+		}
+		else current_node = NONE;
+	}
+
+	maxflow_iteration ++;
+	return flow;
+}
+
+#include "instances_csr.inc"
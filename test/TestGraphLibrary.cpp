@@ -17,6 +17,12 @@
 //
 #include "MaxFlowGraphBoost.hxx"
 #include "MaxFlowGraphKolmogorov.hxx"
+#include "MaxFlowGraphOutOfCore.hxx"
+#include "MultiLabelGraphKolmogorov.hxx"
+#include "lib/kolmogorov-3.03/graph_csr.h"
+
+// STL
+#include <random>
 
 class TestGraphLibrary : public ::testing::Test {
 protected:
@@ -41,6 +47,286 @@ protected:
         capacity.push_back(weight);
     }
 
+    typedef MultiLabelGraphKolmogorov<unsigned char, unsigned short, std::size_t> MultiLabelGraphType;
+
+    // a multi-label problem on a 6-connected grid as MultiLabelGraphKolmogorov takes it, with Potts label costs
+    struct MultiLabelProblem {
+        unsigned int dimensions[3];
+        unsigned int numberOfLabels;
+        int defaultCost;
+        std::vector<unsigned char> edgeWeights;     // 3 per voxel, 0 at the border
+        std::vector<unsigned char> labelCosts;
+        std::vector<std::size_t> seedVoxels;
+        std::vector<unsigned short> seedLabels;
+
+        MultiLabelProblem(unsigned int dimension1, unsigned int dimension2, unsigned int dimension3,
+                          unsigned int numberOfLabels, int defaultCost)
+                : numberOfLabels(numberOfLabels), defaultCost(defaultCost),
+                  edgeWeights(3 * (std::size_t) dimension1 * dimension2 * dimension3, 0),
+                  labelCosts(numberOfLabels * numberOfLabels, 1) {
+            dimensions[0] = dimension1;
+            dimensions[1] = dimension2;
+            dimensions[2] = dimension3;
+            for (unsigned int label = 0; label < numberOfLabels; ++label) {
+                labelCosts[label + label * numberOfLabels] = 0;
+            }
+        }
+
+        std::size_t numberOfVoxels() const {
+            return (std::size_t) dimensions[0] * dimensions[1] * dimensions[2];
+        }
+
+        std::size_t stride(unsigned int d) const {
+            return d == 0 ? 1 : (d == 1 ? dimensions[0] : (std::size_t) dimensions[0] * dimensions[1]);
+        }
+
+        // the graph keeps pointers to the costs
+        void setCosts(MultiLabelGraphType &graph) const {
+            graph.setSmoothnessCosts(edgeWeights.data(), labelCosts.data());
+            graph.setDataCosts(defaultCost, seedVoxels.size(), seedVoxels.data(), seedLabels.data());
+        }
+
+        double energy(const std::vector<unsigned short> &labeling) const {
+            double energy = 0;
+            for (std::size_t voxel = 0; voxel < numberOfVoxels(); ++voxel) {
+                const std::size_t seed = std::find(seedVoxels.begin(), seedVoxels.end(), voxel) - seedVoxels.begin();
+                energy += seed < seedVoxels.size() && seedLabels[seed] == labeling[voxel] ? 0 : defaultCost;
+
+                const std::size_t coordinates[3] = {voxel % dimensions[0], (voxel / dimensions[0]) % dimensions[1],
+                                                    voxel / stride(2)};
+                for (unsigned int d = 0; d < 3; ++d) {
+                    if (coordinates[d] + 1 < dimensions[d]) {
+                        energy += edgeWeights[3 * voxel + d] *
+                                  labelCosts[labeling[voxel] + labeling[voxel + stride(d)] * numberOfLabels];
+                    }
+                }
+            }
+            return energy;
+        }
+    };
+
+    // A chain of voxels along dimension d with a default cost of 100 and the seeds of the labels 0, 1, ... in order.
+    // The edges after the given voxels are weak (1), the others strong (10).
+    static MultiLabelProblem chainProblem(unsigned int d, unsigned int length, unsigned int numberOfLabels,
+                                          const std::vector<std::size_t> &weakEdges,
+                                          const std::vector<std::size_t> &seedVoxels) {
+        MultiLabelProblem problem(d == 0 ? length : 1, d == 1 ? length : 1, d == 2 ? length : 1, numberOfLabels, 100);
+        for (std::size_t voxel = 0; voxel + 1 < length; ++voxel) {
+            const bool weak = std::find(weakEdges.begin(), weakEdges.end(), voxel) != weakEdges.end();
+            problem.edgeWeights[3 * voxel + d] = weak ? 1 : 10;
+        }
+        problem.seedVoxels = seedVoxels;
+        for (std::size_t seed = 0; seed < seedVoxels.size(); ++seed) {
+            problem.seedLabels.push_back(seed);
+        }
+        return problem;
+    }
+
+    // random edge weights in [0, 20] and every fourth voxel a seed of a random label
+    static MultiLabelProblem randomMultiLabelProblem(unsigned int dimension1, unsigned int dimension2,
+                                                     unsigned int dimension3, unsigned int numberOfLabels,
+                                                     std::mt19937 &random) {
+        MultiLabelProblem problem(dimension1, dimension2, dimension3, numberOfLabels, 30);
+        for (std::size_t voxel = 0; voxel < problem.numberOfVoxels(); ++voxel) {
+            const std::size_t coordinates[3] = {voxel % dimension1, (voxel / dimension1) % dimension2,
+                                                voxel / problem.stride(2)};
+            for (unsigned int d = 0; d < 3; ++d) {
+                if (coordinates[d] + 1 < problem.dimensions[d]) {
+                    problem.edgeWeights[3 * voxel + d] = random() % 21;
+                }
+            }
+            if (random() % 4 == 0) {
+                problem.seedVoxels.push_back(voxel);
+                problem.seedLabels.push_back(random() % numberOfLabels);
+            }
+        }
+        return problem;
+    }
+
+    // Lowest energy of a labeling in which every voxel takes its label in first or in second, by enumeration
+    static double bestFusionEnergy(const MultiLabelProblem &problem, const std::vector<unsigned short> &first,
+                                   const std::vector<unsigned short> &second) {
+        std::vector<std::size_t> free;
+        for (std::size_t voxel = 0; voxel < first.size(); ++voxel) {
+            if (first[voxel] != second[voxel]) {
+                free.push_back(voxel);
+            }
+        }
+        std::vector<unsigned short> labeling = first;
+        double best = problem.energy(labeling);
+        for (unsigned long assignment = 0; assignment < (1ul << free.size()); ++assignment) {
+            for (std::size_t voxel = 0; voxel < free.size(); ++voxel) {
+                labeling[free[voxel]] = ((assignment >> voxel) & 1 ? second : first)[free[voxel]];
+            }
+            best = std::min(best, problem.energy(labeling));
+        }
+        return best;
+    }
+
+    // the best swap of alpha and beta
+    static double bestSwapEnergy(const MultiLabelProblem &problem, const std::vector<unsigned short> &labeling,
+                                 unsigned short alpha, unsigned short beta) {
+        std::vector<unsigned short> first = labeling, second = labeling;
+        for (std::size_t voxel = 0; voxel < labeling.size(); ++voxel) {
+            if (labeling[voxel] == alpha || labeling[voxel] == beta) {
+                first[voxel] = alpha;
+                second[voxel] = beta;
+            }
+        }
+        return bestFusionEnergy(problem, first, second);
+    }
+
+    // the best expansion of alpha
+    static double bestExpansionEnergy(const MultiLabelProblem &problem, const std::vector<unsigned short> &labeling,
+                                      unsigned short alpha) {
+        return bestFusionEnergy(problem, labeling, std::vector<unsigned short>(labeling.size(), alpha));
+    }
+
+    // The 3x5 example of MaxFlowGraphKolmogorov in a Graph or a GraphCSR: strong edges (1000) but five weak ones (1),
+    // the sources 0, 1, 6, 10, 11 and the sinks 3, 4, 8, 13, 14. Its minimum cut separates exampleForeground().
+    template<typename TGraph>
+    static void addExampleGraph(TGraph &graph) {
+        const float smallWeight = 1;
+        const float largeWeight = 1000;
+        graph.add_node(3 * 5);
+
+        // horizontal and vertical edges
+        const int edges[22][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {5, 6}, {6, 7}, {7, 8}, {8, 9}, {10, 11}, {11, 12},
+                                  {12, 13}, {13, 14}, {0, 5}, {1, 6}, {2, 7}, {3, 8}, {4, 9}, {5, 10}, {6, 11},
+                                  {7, 12}, {8, 13}, {9, 14}};
+        std::set<int> smallEdges = boost::assign::list_of(2)(5)(10)(14)(19);
+        for (int i = 0; i < 22; ++i) {
+            float weight = smallEdges.count(i) ? smallWeight : largeWeight;
+            graph.add_edge(edges[i][0], edges[i][1], weight, weight);
+        }
+
+        // connect the sources and sinks
+        const int sourceNodes[5] = {0, 1, 6, 10, 11};
+        const int sinkNodes[5] = {3, 4, 8, 13, 14};
+        for (int i = 0; i < 5; ++i) {
+            graph.add_tweights(sourceNodes[i], largeWeight, smallWeight);
+            graph.add_tweights(sinkNodes[i], smallWeight, largeWeight);
+        }
+    }
+
+    static std::set<int> exampleForeground() {
+        return boost::assign::list_of(0)(1)(2)(5)(6)(10)(11)(12);
+    }
+
+    // A random graph of integer capacities for Graph and GraphCSR. It keeps its capacities, also through changes, to
+    // compute the capacity of the cut of a solved graph.
+    struct RandomGraph {
+        int numberOfNodes;
+        std::vector<int> tails, heads;
+        std::vector<int> capacities;        // 2 per edge, of the arcs tail->head and head->tail
+        std::vector<int> sourceCapacities, sinkCapacities;
+
+        // a change of the capacity of an arc (by delta > 0) or of a terminal, to the source for delta > 0 and to the
+        // sink for delta < 0
+        struct Change {
+            bool terminal;
+            int index;      // of the arc or the node
+            int delta;
+        };
+        std::vector<Change> changes;
+
+        // capacities in [0, 20], every third node connected to a terminal with a capacity in [0, 50]
+        RandomGraph(int numberOfNodes, int numberOfEdges, std::mt19937 &random)
+                : numberOfNodes(numberOfNodes), sourceCapacities(numberOfNodes, 0), sinkCapacities(numberOfNodes, 0) {
+            for (int edge = 0; edge < numberOfEdges; ++edge) {
+                const int tail = random() % numberOfNodes;
+                tails.push_back(tail);
+                heads.push_back((tail + 1 + random() % (numberOfNodes - 1)) % numberOfNodes);
+                capacities.push_back(random() % 21);
+                capacities.push_back(random() % 21);
+            }
+            for (int node = 0; node < numberOfNodes; ++node) {
+                if (random() % 3 == 0) {
+                    (random() % 2 ? sourceCapacities : sinkCapacities)[node] = random() % 51;
+                }
+            }
+        }
+
+        int numberOfEdges() const {
+            return tails.size();
+        }
+
+        template<typename TGraph>
+        void fill(TGraph &graph) const {
+            graph.add_node(numberOfNodes);
+            for (int edge = 0; edge < numberOfEdges(); ++edge) {
+                graph.add_edge(tails[edge], heads[edge], capacities[2 * edge], capacities[2 * edge + 1]);
+            }
+            for (int node = 0; node < numberOfNodes; ++node) {
+                graph.add_tweights(node, sourceCapacities[node], sinkCapacities[node]);
+            }
+        }
+
+        // random changes, applied to the capacities here and to solved graphs by applyChanges()
+        void change(int numberOfChanges, std::mt19937 &random) {
+            changes.clear();
+            for (int i = 0; i < numberOfChanges; ++i) {
+                Change change = {random() % 2 == 0, 0, 0};
+                if (change.terminal) {
+                    change.index = random() % numberOfNodes;
+                    change.delta = (int) (random() % 41) - 20;
+                    if (change.delta > 0) {
+                        sourceCapacities[change.index] += change.delta;
+                    } else {
+                        sinkCapacities[change.index] -= change.delta;
+                    }
+                } else {
+                    change.index = random() % capacities.size();
+                    change.delta = 1 + random() % 20;
+                    capacities[change.index] += change.delta;
+                }
+                changes.push_back(change);
+            }
+        }
+
+        // Raises the residual capacities by the changes with set_rcap() and set_trcap() and marks the nodes involved.
+        // The flow of a later maxflow(true) need not be that of the changed graph, as a terminal capacity added to
+        // a node with residual capacity to the other terminal is not counted as flow, but its cut is a minimum cut.
+        template<typename TGraph>
+        void applyChanges(TGraph &graph) const {
+            for (std::size_t i = 0; i < changes.size(); ++i) {
+                const Change &change = changes[i];
+                if (change.terminal) {
+                    graph.set_trcap(change.index, graph.get_trcap(change.index) + change.delta);
+                    graph.mark_node(change.index);
+                } else {
+                    // the arcs are numbered in the order they were added
+                    typename TGraph::arc_id arc = graph.get_first_arc();
+                    for (int j = 0; j < change.index; ++j) {
+                        arc = graph.get_next_arc(arc);
+                    }
+                    graph.set_rcap(arc, graph.get_rcap(arc) + change.delta);
+                    graph.mark_node(tails[change.index / 2]);
+                    graph.mark_node(heads[change.index / 2]);
+                }
+            }
+        }
+
+        // capacity of the cut of a solved graph
+        template<typename TGraph>
+        int cutCapacity(TGraph &graph) const {
+            int capacity = 0;
+            for (int node = 0; node < numberOfNodes; ++node) {
+                capacity += graph.what_segment(node) == TGraph::SOURCE ? sinkCapacities[node] : sourceCapacities[node];
+            }
+            for (int edge = 0; edge < numberOfEdges(); ++edge) {
+                const bool tailIsSource = graph.what_segment(tails[edge]) == TGraph::SOURCE;
+                const bool headIsSource = graph.what_segment(heads[edge]) == TGraph::SOURCE;
+                if (tailIsSource && !headIsSource) {
+                    capacity += capacities[2 * edge];
+                } else if (!tailIsSource && headIsSource) {
+                    capacity += capacities[2 * edge + 1];
+                }
+            }
+            return capacity;
+        }
+    };
+
     virtual void SetUp() {
 
     }
@@ -364,4 +650,487 @@ TEST_F(TestGraphLibrary, MaxFlowGraphKolmogorov){
     // both containers should now be empty
     EXPECT_EQ(0, expectedForeground.size());
     EXPECT_EQ(0, expectedBackground.size());
-}
\ No newline at end of file
+}
+
+TEST_F(TestGraphLibrary, MaxFlowGraphCSR){
+    // same example as in MaxFlowGraphKolmogorov, solved with the index based graph and compared to Graph
+    typedef Graph<float, float, float> ReferenceGraphType;
+    typedef GraphCSR<float, float, float> GraphType;
+
+    int numberOfVertices = 3*5;
+    float smallWeight = 1;
+    float largeWeight = 1000;
+
+    ReferenceGraphType reference(numberOfVertices, 22);
+    GraphType graph(numberOfVertices, 22);
+    addExampleGraph(reference);
+    addExampleGraph(graph);
+
+    // the arcs are reported in the order they were added
+    EXPECT_EQ(numberOfVertices, graph.get_node_num());
+    EXPECT_EQ(22 * 2, graph.get_arc_num());
+    int i, j;
+    graph.get_arc_ends(graph.get_next_arc(graph.get_first_arc()), i, j);
+    EXPECT_EQ(1, i);
+    EXPECT_EQ(0, j);
+
+    EXPECT_FLOAT_EQ(reference.maxflow(), graph.maxflow());
+
+    std::set<int> expectedForeground = exampleForeground();
+    for (int index = 0; index < numberOfVertices; ++index) {
+        EXPECT_EQ(expectedForeground.count(index) ? GraphType::SOURCE : GraphType::SINK, graph.what_segment(index))
+                            << "vertex " << index;
+    }
+
+    // turn vertex 12 into a sink, add an edge and solve again reusing the search trees
+    reference.add_tweights(12, 0, 2 * largeWeight);
+    graph.add_tweights(12, 0, 2 * largeWeight);
+    reference.mark_node(12);
+    graph.mark_node(12);
+    reference.add_edge(2, 12, smallWeight, smallWeight);
+    graph.add_edge(2, 12, smallWeight, smallWeight);
+    reference.mark_node(2);
+    graph.mark_node(2);
+
+    EXPECT_FLOAT_EQ(reference.maxflow(true), graph.maxflow(true));
+    for (int index = 0; index < numberOfVertices; ++index) {
+        EXPECT_EQ((int) reference.what_segment(index), (int) graph.what_segment(index)) << "vertex " << index;
+    }
+    EXPECT_EQ(GraphType::SINK, graph.what_segment(12));
+}
+
+TEST_F(TestGraphLibrary, MaxFlowGraphCSRRandom){
+    // Random graphs solved with GraphCSR and Graph, then changed with set_rcap() and set_trcap() and solved again
+    // reusing the search trees. Minimum cuts need not be unique, so the cuts are compared by their capacity.
+    typedef Graph<int, int, int> ReferenceGraphType;
+    typedef GraphCSR<int, int, int> GraphType;
+    std::mt19937 random(30);
+
+    for (int trial = 0; trial < 50; ++trial) {
+        RandomGraph randomGraph(40, 120, random);
+        ReferenceGraphType reference(randomGraph.numberOfNodes, randomGraph.numberOfEdges());
+        GraphType graph(randomGraph.numberOfNodes, randomGraph.numberOfEdges());
+        randomGraph.fill(reference);
+        randomGraph.fill(graph);
+
+        const int flow = reference.maxflow();
+        EXPECT_EQ(flow, graph.maxflow()) << "trial " << trial;
+        EXPECT_EQ(flow, randomGraph.cutCapacity(reference)) << "trial " << trial;
+        EXPECT_EQ(flow, randomGraph.cutCapacity(graph)) << "trial " << trial;
+
+        randomGraph.change(10, random);
+        randomGraph.applyChanges(reference);
+        randomGraph.applyChanges(graph);
+        reference.maxflow(true);
+        graph.maxflow(true);
+
+        ReferenceGraphType changed(randomGraph.numberOfNodes, randomGraph.numberOfEdges());
+        randomGraph.fill(changed);
+        const int changedFlow = changed.maxflow();
+        EXPECT_EQ(changedFlow, randomGraph.cutCapacity(changed)) << "trial " << trial;
+        EXPECT_EQ(changedFlow, randomGraph.cutCapacity(reference)) << "trial " << trial;
+        EXPECT_EQ(changedFlow, randomGraph.cutCapacity(graph)) << "trial " << trial;
+    }
+}
+
+TEST_F(TestGraphLibrary, MaxFlowGraphKolmogorovBudget){
+    // same example as in MaxFlowGraphKolmogorov, interrupted after every augmenting path and resumed
+    typedef Graph<float, float, float> GraphType;
+
+    int numberOfVertices = 3*5;
+    GraphType reference(numberOfVertices, 22);
+    GraphType graph(numberOfVertices, 22);
+    addExampleGraph(reference);
+    addExampleGraph(graph);
+
+    graph.set_maxflow_budget(1, 0);
+    float flow = graph.maxflow();
+    EXPECT_TRUE(graph.maxflow_interrupted());
+
+    int calls = 1;
+    while (graph.maxflow_interrupted() && calls < 100) {
+        flow = graph.maxflow(true);
+        calls++;
+    }
+    EXPECT_FALSE(graph.maxflow_interrupted());
+    EXPECT_GT(calls, 2);
+
+    EXPECT_FLOAT_EQ(reference.maxflow(), flow);
+    for (int index = 0; index < numberOfVertices; ++index) {
+        EXPECT_EQ((int) reference.what_segment(index), (int) graph.what_segment(index)) << "vertex " << index;
+    }
+}
+
+TEST_F(TestGraphLibrary, MaxFlowGraphKolmogorovBudgetChanges){
+    // the budget runs out, the graph is changed while suspended and resumed without a budget, compared to a fresh
+    // solve of the changed graph
+    typedef Graph<float, float, float> GraphType;
+    float smallWeight = 1;
+    float largeWeight = 1000;
+
+    // the example, with vertex 12 turned into a sink and an edge added as in MaxFlowGraphCSR
+    int numberOfVertices = 3*5;
+    GraphType reference(numberOfVertices, 23);
+    GraphType graph(numberOfVertices, 23);
+    addExampleGraph(reference);
+    addExampleGraph(graph);
+    reference.add_tweights(12, 0, 2 * largeWeight);
+    reference.add_edge(2, 12, smallWeight, smallWeight);
+
+    graph.set_maxflow_budget(1, 0);
+    graph.maxflow();
+    ASSERT_TRUE(graph.maxflow_interrupted());
+    graph.add_tweights(12, 0, 2 * largeWeight);
+    graph.mark_node(12);
+    graph.add_edge(2, 12, smallWeight, smallWeight);
+    graph.mark_node(2);
+
+    graph.set_maxflow_budget(0, 0);
+    float flow = graph.maxflow(true);
+    EXPECT_FALSE(graph.maxflow_interrupted());
+    EXPECT_FLOAT_EQ(reference.maxflow(), flow);
+    for (int index = 0; index < numberOfVertices; ++index) {
+        EXPECT_EQ((int) reference.what_segment(index), (int) graph.what_segment(index)) << "vertex " << index;
+    }
+    EXPECT_EQ(GraphType::SINK, graph.what_segment(12));
+
+    // random graphs with residual capacities raised while suspended, see RandomGraph::applyChanges()
+    typedef Graph<int, int, int> IntegerGraphType;
+    std::mt19937 random(32);
+    int interruptions = 0;
+    for (int trial = 0; trial < 50; ++trial) {
+        RandomGraph randomGraph(40, 120, random);
+        IntegerGraphType suspended(randomGraph.numberOfNodes, randomGraph.numberOfEdges());
+        randomGraph.fill(suspended);
+        suspended.set_maxflow_budget(3, 0);
+        suspended.maxflow();
+        interruptions += suspended.maxflow_interrupted();
+
+        randomGraph.change(10, random);
+        randomGraph.applyChanges(suspended);
+        suspended.set_maxflow_budget(0, 0);
+        suspended.maxflow(true);
+        EXPECT_FALSE(suspended.maxflow_interrupted());
+
+        IntegerGraphType changed(randomGraph.numberOfNodes, randomGraph.numberOfEdges());
+        randomGraph.fill(changed);
+        EXPECT_EQ(changed.maxflow(), randomGraph.cutCapacity(suspended)) << "trial " << trial;
+    }
+    EXPECT_GT(interruptions, 0);
+}
+
+TEST_F(TestGraphLibrary, MaxFlowGraphOutOfCoreThinVolumes){
+    // volumes one voxel wide have no x edges, their y edges differ by one node and must not be taken for x edges
+    std::mt19937 random(27);
+    const unsigned int dimensions[4][3] = {{1, 4, 3}, {1, 5, 1}, {4, 1, 3}, {3, 4, 2}};
+
+    for (int trial = 0; trial < 40; ++trial) {
+        const unsigned int *size = dimensions[trial % 4];
+        // a budget of one plane per block, the cut crosses the blocks
+        MaxFlowGraphOutOfCore graph(size[0], size[1], size[2], 0, ".");
+        MaxFlowGraphKolmogorov reference(size[0], size[1], size[2]);
+
+        const unsigned int strides[3] = {1, size[0], size[0] * size[1]};
+        const unsigned int numberOfVertices = size[0] * size[1] * size[2];
+        for (unsigned int vertex = 0; vertex < numberOfVertices; ++vertex) {
+            const unsigned int coordinates[3] = {vertex % size[0], (vertex / size[0]) % size[1], vertex / strides[2]};
+            for (unsigned int d = 0; d < 3; ++d) {
+                if (coordinates[d] + 1 < size[d]) {
+                    float weight = 1 + random() % 10, reverseWeight = 1 + random() % 10;
+                    graph.addBidirectionalEdge(vertex, vertex + strides[d], weight, reverseWeight);
+                    reference.addBidirectionalEdge(vertex, vertex + strides[d], weight, reverseWeight);
+                }
+            }
+            float sourceWeight = random() % 20, sinkWeight = random() % 20;
+            graph.addTerminalEdges(vertex, sourceWeight, sinkWeight);
+            reference.addTerminalEdges(vertex, sourceWeight, sinkWeight);
+        }
+
+        graph.calculateMaxFlow();
+        reference.calculateMaxFlow();
+        for (unsigned int vertex = 0; vertex < numberOfVertices; ++vertex) {
+            EXPECT_EQ(reference.groupOf(vertex) == reference.groupOfSource(), graph.groupOf(vertex) == graph.groupOfSource())
+                                << "trial " << trial << ", vertex " << vertex;
+        }
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorov){
+    /*
+     *  seeds       0 . . . 1 . . . 2
+     *  edges        = = - = = = - = =      (=: 10, -: 1)
+     *  expected    0 0 0 1 1 1 2 2 2
+     */
+    unsigned short expected[9] = {0, 0, 0, 1, 1, 1, 2, 2, 2};
+
+    // the chain along every dimension
+    for (unsigned int d = 0; d < 3; ++d) {
+        const MultiLabelProblem problem = chainProblem(d, 9, 3, boost::assign::list_of(2)(5),
+                                                       boost::assign::list_of(0)(4)(8));
+        MultiLabelGraphType graph(problem.dimensions[0], problem.dimensions[1], problem.dimensions[2], 3);
+        problem.setCosts(graph);
+
+        // the second run reuses the graph and its search trees, the third swaps instead of expanding
+        for (int run = 0; run < 3; ++run) {
+            graph.resetLabeling();
+            EXPECT_EQ(2, run < 2 ? graph.performExpansion(50) : graph.performSwap(50));
+            EXPECT_EQ(2, graph.getCycles().size());
+            EXPECT_EQ(0, graph.getCycles().back().changed);
+            EXPECT_DOUBLE_EQ(6 * 100 + 2, graph.computeEnergy());
+            for (int voxel = 0; voxel < 9; ++voxel) {
+                EXPECT_EQ(expected[voxel], graph.getLabeling()[voxel])
+                                    << "dimension " << d << ", run " << run << ", voxel " << voxel;
+            }
+        }
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovParallel){
+    /*
+     *  seeds along z   0 . . . . 1 . . . . . 2
+     *  edges            = = - = = = = - = = =      (=: 10, -: 1)
+     *  expected        0 0 0 1 1 1 1 1 2 2 2 2
+     */
+    const MultiLabelProblem problem = chainProblem(2, 12, 3, boost::assign::list_of(2)(7),
+                                                   boost::assign::list_of(0)(5)(11));
+    MultiLabelGraphType graph(1, 1, 12, 3);
+    problem.setCosts(graph);
+    graph.performParallelExpansion(50, 2);
+
+    // parallel cycles, then sequential ones, the last one without changes
+    const std::vector<MultiLabelGraphType::Cycle> &cycles = graph.getCycles();
+    ASSERT_LE(2, cycles.size());
+    EXPECT_TRUE(cycles.front().parallel);
+    EXPECT_FALSE(cycles.back().parallel);
+    EXPECT_EQ(0, cycles.back().changed);
+    for (std::size_t cycle = 1; cycle < cycles.size(); ++cycle) {
+        EXPECT_LE(cycles[cycle].energy, cycles[cycle - 1].energy);
+    }
+
+    // two threads, each expanding an even and an odd slab for every label of a parallel cycle
+    std::size_t parallelCycles = 0;
+    for (std::size_t cycle = 0; cycle < cycles.size(); ++cycle) {
+        parallelCycles += cycles[cycle].parallel;
+    }
+    ASSERT_EQ(2, graph.getThreadEnergies().size());
+    EXPECT_EQ(2 * 3 * parallelCycles, graph.getThreadEnergies()[0].size());
+    EXPECT_EQ(2 * 3 * parallelCycles, graph.getThreadEnergies()[1].size());
+
+    unsigned short expected[12] = {0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 2};
+    EXPECT_DOUBLE_EQ(9 * 100 + 2, graph.computeEnergy());
+
+    // the energy summed over slabs by several threads
+    graph.setNumberOfThreads(5);
+    EXPECT_DOUBLE_EQ(9 * 100 + 2, graph.computeEnergy());
+    for (int voxel = 0; voxel < 12; ++voxel) {
+        EXPECT_EQ(expected[voxel], graph.getLabeling()[voxel]) << "voxel " << voxel;
+    }
+
+    // the parallel and the sequential cycles share the maximum number of cycles
+    for (unsigned int maximumNumberOfCycles = 1; maximumNumberOfCycles <= cycles.size(); ++maximumNumberOfCycles) {
+        MultiLabelGraphType limitedGraph(1, 1, 12, 3);
+        problem.setCosts(limitedGraph);
+        EXPECT_EQ(maximumNumberOfCycles, limitedGraph.performParallelExpansion(maximumNumberOfCycles, 2));
+        EXPECT_EQ(maximumNumberOfCycles, limitedGraph.getCycles().size());
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovHierarchical){
+    /*
+     *  seeds       0 . . . 1 . . 2 . . . 3
+     *  edges        = = - = = - = = - = =      (=: 10, -: 1)
+     *  tree        ((0, 1), (2, 3))
+     *  expected    0 0 0 1 1 1 2 2 2 3 3 3
+     */
+    MultiLabelProblem problem = chainProblem(0, 12, 4, boost::assign::list_of(2)(5)(8),
+                                             boost::assign::list_of(0)(4)(7)(11));
+
+    // leaves 0 - 3, then the two subtrees and the root
+    std::vector<MultiLabelGraphType::LabelTreeNode> tree(7);
+    for (int node = 0; node < 4; ++node) {
+        tree[node].children[0] = tree[node].children[1] = -1;
+        tree[node].label = node;
+    }
+    for (int node = 4; node < 6; ++node) {
+        tree[node].children[0] = 2 * (node - 4);
+        tree[node].children[1] = 2 * (node - 4) + 1;
+    }
+    tree[6].children[0] = 4;
+    tree[6].children[1] = 5;
+
+    MultiLabelGraphType graph(12, 1, 1, 4);
+    problem.setCosts(graph);
+
+    // the subtrees of the root are cut on two threads
+    const MultiLabelGraphType::Cycle &cycle = graph.performHierarchicalCut(tree, 6, 2);
+    EXPECT_TRUE(cycle.hierarchical);
+    EXPECT_EQ(9, cycle.changed);
+    EXPECT_DOUBLE_EQ(8 * 100 + 3, cycle.energy);
+
+    unsigned short expected[12] = {0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3};
+    for (int voxel = 0; voxel < 12; ++voxel) {
+        EXPECT_EQ(expected[voxel], graph.getLabeling()[voxel]) << "voxel " << voxel;
+    }
+
+    // without seeds of 2 and 3 their subtree gets no voxels and is not cut
+    problem.seedVoxels.resize(2);
+    problem.seedLabels.resize(2);
+    problem.setCosts(graph);
+    EXPECT_DOUBLE_EQ(10 * 100 + 1, graph.performHierarchicalCut(tree, 6, 2).energy);
+    for (int voxel = 0; voxel < 12; ++voxel) {
+        EXPECT_EQ(voxel < 3 ? 0 : 1, graph.getLabeling()[voxel]) << "voxel " << voxel;
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovLocalized){
+    /*
+     *  seeds along y   0 . . . 1 . . 2 . . . 3
+     *  edges            = = - = = - = = - = =      (=: 10, -: 1)
+     *  expected        0 0 0 1 1 1 2 2 2 3 3 3     margin 2
+     *                  0 0 0 0 1 0 0 2 0 0 0 3     margin 0, only the seeds are in the boxes
+     */
+    const MultiLabelProblem problem = chainProblem(1, 12, 4, boost::assign::list_of(2)(5)(8),
+                                                   boost::assign::list_of(0)(4)(7)(11));
+    MultiLabelGraphType graph(1, 12, 1, 4);
+    problem.setCosts(graph);
+
+    unsigned short expected[2][12] = {{0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3},
+                                      {0, 0, 0, 0, 1, 0, 0, 2, 0, 0, 0, 3}};
+    const unsigned int margins[2] = {2, 0};
+    for (int run = 0; run < 2; ++run) {
+        graph.resetLabeling();
+        EXPECT_EQ(2, graph.performLocalizedExpansion(50, margins[run]));
+        EXPECT_TRUE(graph.getCycles().front().localized);
+        EXPECT_EQ(0, graph.getCycles().back().changed);
+        for (int voxel = 0; voxel < 12; ++voxel) {
+            EXPECT_EQ(expected[run][voxel], graph.getLabeling()[voxel]) << "margin " << margins[run] << ", voxel " << voxel;
+        }
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovFusion){
+    /*
+     *  seeds       0 . . . 1 . . . 2
+     *  edges        = = - = = = - = =      (=: 10, -: 1)
+     *  proposals   1 1 1 1 2 2 2 3 3       label values, label + 1
+     *              1 1 1 2 2 2 3 3 0       0 is no label
+     *  expected    0 0 0 1 1 1 2 2 2
+     */
+    const MultiLabelProblem problem = chainProblem(0, 9, 3, boost::assign::list_of(2)(5),
+                                                   boost::assign::list_of(0)(4)(8));
+
+    short proposalValues[2][9] = {{1, 1, 1, 1, 2, 2, 2, 3, 3},
+                                  {1, 1, 1, 2, 2, 2, 3, 3, 0}};
+    std::vector<const short *> proposals(1, proposalValues[0]);
+    proposals.push_back(proposalValues[1]);
+    auto labelOf = [](short value) { return value - 1; };
+
+    MultiLabelGraphType graph(9, 1, 1, 3);
+    problem.setCosts(graph);
+
+    // the first cycle takes the first proposal (5 voxels), then the second one except for the last voxel (2 voxels)
+    EXPECT_EQ(7, graph.performFusionCycle(proposals, labelOf).changed);
+    EXPECT_EQ(0, graph.performFusionCycle(proposals, labelOf).changed);
+    EXPECT_TRUE(graph.getCycles().front().fusion);
+    EXPECT_DOUBLE_EQ(6 * 100 + 2, graph.computeEnergy());
+
+    unsigned short expected[9] = {0, 0, 0, 1, 1, 1, 2, 2, 2};
+    for (int voxel = 0; voxel < 9; ++voxel) {
+        EXPECT_EQ(expected[voxel], graph.getLabeling()[voxel]) << "voxel " << voxel;
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovSeedEdit){
+    /*
+     *  seeds along y   0 . . . 1 . . . 2       edited to 0 . . . 2 . . . 2
+     *  edges            = = - = = = - = =      (=: 10, -: 1)
+     *  expected        0 0 0 1 1 1 2 2 2       edited      0 0 0 2 2 2 2 2 2
+     */
+    MultiLabelProblem problem = chainProblem(1, 9, 3, boost::assign::list_of(2)(5), boost::assign::list_of(0)(4)(8));
+    MultiLabelGraphType graph(1, 9, 1, 3);
+    problem.setCosts(graph);
+    graph.performExpansion(50);
+
+    // the labels of the edited seed, before and after, are expanded from the previous labeling
+    problem.seedLabels[1] = 2;
+    graph.clearCycles();
+    std::vector<unsigned short> changedLabels(1, 1);
+    changedLabels.push_back(2);
+    EXPECT_EQ(3, graph.performExpansionCycle(changedLabels).changed);
+    EXPECT_EQ(0, graph.performExpansionCycle(changedLabels).changed);
+    EXPECT_EQ(2, graph.getCycles().size());
+    EXPECT_DOUBLE_EQ(6 * 100 + 1, graph.computeEnergy());
+
+    unsigned short expected[9] = {0, 0, 0, 2, 2, 2, 2, 2, 2};
+    for (int voxel = 0; voxel < 9; ++voxel) {
+        EXPECT_EQ(expected[voxel], graph.getLabeling()[voxel]) << "voxel " << voxel;
+    }
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovSwapBruteForce){
+    // every swap on random 3 x 2 x 2 grids reaches the best labeling of its voxels, also when free nodes tie
+    std::mt19937 random(43);
+
+    for (int trial = 0; trial < 50; ++trial) {
+        const MultiLabelProblem problem = randomMultiLabelProblem(3, 2, 2, 3, random);
+        MultiLabelGraphType graph(3, 2, 2, 3);
+        problem.setCosts(graph);
+
+        for (int cycle = 0; cycle < 2; ++cycle) {
+            for (unsigned short alpha = 0; alpha < 3; ++alpha) {
+                for (unsigned short beta = alpha + 1; beta < 3; ++beta) {
+                    const double best = bestSwapEnergy(problem, graph.getLabeling(), alpha, beta);
+                    graph.swap(alpha, beta);
+                    EXPECT_DOUBLE_EQ(best, problem.energy(graph.getLabeling()))
+                                        << "trial " << trial << ", swap " << alpha << " " << beta;
+                    EXPECT_DOUBLE_EQ(problem.energy(graph.getLabeling()), graph.computeEnergy());
+                }
+            }
+        }
+    }
+
+    // two voxels labeled (1, 0) by their seeds, without the seeds both labels tie and the swap has to join them
+    MultiLabelProblem problem(1, 1, 2, 2, 30);
+    problem.edgeWeights[2] = 15;
+    problem.seedVoxels = boost::assign::list_of(0)(1).convert_to_container<std::vector<std::size_t> >();
+    problem.seedLabels = boost::assign::list_of(1)(0).convert_to_container<std::vector<unsigned short> >();
+    MultiLabelGraphType graph(1, 1, 2, 2);
+    problem.setCosts(graph);
+    graph.expand(1);
+    ASSERT_EQ(1, graph.getLabeling()[0]);
+    ASSERT_EQ(0, graph.getLabeling()[1]);
+
+    graph.setDataCosts(30, 0, NULL, NULL);
+    EXPECT_EQ(1, graph.swap(0, 1));
+    EXPECT_EQ(graph.getLabeling()[0], graph.getLabeling()[1]);
+    EXPECT_DOUBLE_EQ(2 * 30, graph.computeEnergy());
+}
+
+TEST_F(TestGraphLibrary, MultiLabelGraphKolmogorovExpansionBruteForce){
+    // every expansion on random 3 x 2 x 2 grids reaches the best labeling of its voxels
+    std::mt19937 random(48);
+
+    for (int trial = 0; trial < 50; ++trial) {
+        const MultiLabelProblem problem = randomMultiLabelProblem(3, 2, 2, 3, random);
+        MultiLabelGraphType graph(3, 2, 2, 3);
+        problem.setCosts(graph);
+
+        for (int cycle = 0; cycle < 2; ++cycle) {
+            for (unsigned short alpha = 0; alpha < 3; ++alpha) {
+                const double best = bestExpansionEnergy(problem, graph.getLabeling(), alpha);
+                graph.expand(alpha);
+                EXPECT_DOUBLE_EQ(best, problem.energy(graph.getLabeling())) << "trial " << trial << ", alpha " << alpha;
+                EXPECT_DOUBLE_EQ(problem.energy(graph.getLabeling()), graph.computeEnergy());
+            }
+        }
+
+        // localized and parallel expansions converge to a labeling no expansion improves
+        graph.resetLabeling();
+        graph.performLocalizedExpansion(50, 3);
+        graph.performParallelExpansion(50, 2);
+        for (unsigned short alpha = 0; alpha < 3; ++alpha) {
+            EXPECT_DOUBLE_EQ(bestExpansionEnergy(problem, graph.getLabeling(), alpha), graph.computeEnergy())
+                                << "trial " << trial << ", alpha " << alpha;
+        }
+    }
+}
@@ -16,6 +16,21 @@
 
 #include "IOHelper.hxx"
 #include "ImageGraphCut3DFilter.h"
+#include "ImageGraphCut3DKolmogorovFilter.hxx"
+#include "ImageGraphCut3DBoostFilter.hxx"
+#include "ImageGraphCut3DSlabKolmogorovFilter.h"
+#include "ImageGraphCut3DOutOfCoreSegmentation.h"
+#include "ImageGraphCut3DBatchSegmentation.h"
+#include "ImageMultiLabelKolmogorovFilter.h"
+#include "lib/gridcut/config.h"
+#ifdef GRIDCUT_LIBRARY_AVAILABLE
+#include "ImageGridCutFilter.h"
+#include "ImageMultiLabelGridCutFilter.h"
+#endif
+
+// STL
+#include <random>
+#include <sstream>
 
 class TestSegmentation : public ::testing::Test {
 protected:
@@ -242,4 +257,897 @@ TEST_F(TestSegmentation, SetPixelValues){
 
     double pixelSum = statisticsFilter->GetSum();
     ASSERT_DOUBLE_EQ(expectedPixelSum, pixelSum);
-}
\ No newline at end of file
+}
+
+TEST_F(TestSegmentation, CubeSlabGraphCutTest){
+    // same as CubeGraphCutTest, but the volume is cut into slabs which are reconciled by dual decomposition
+    typedef itk::ImageGraphCut3DSlabKolmogorovFilter<TInput, TForeground, TBackground, TOutput> SlabFilterType;
+    SlabFilterType::Pointer slabFilter = SlabFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cube.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    slabFilter->SetInputImage(inputImage);
+    slabFilter->SetForegroundImage(foregroundMask);
+    slabFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    slabFilter->SetForegroundPixelValue(255);
+    slabFilter->SetBackgroundPixelValue(0);
+    slabFilter->SetSigma(50.0);
+    slabFilter->SetBoundaryDirectionTypeToBrightDark();
+    slabFilter->SetNumberOfSlabs(3);
+    const unsigned int maximumNumberOfDualIterations = 100;
+    slabFilter->SetMaximumNumberOfDualIterations(maximumNumberOfDualIterations);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(slabFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+
+    // the slabs agreed, the result is not the one of the fallback to the whole volume
+    EXPECT_TRUE(slabFilter->GetDualDecompositionConverged());
+    EXPECT_LT(slabFilter->GetNumberOfDualIterations(), maximumNumberOfDualIterations);
+}
+
+TEST_F(TestSegmentation, CubeOutOfCoreGraphCutTest){
+    // same as CubeGraphCutTest, but with a budget so low that only three planes of the solver are resident
+    typedef itk::ImageGraphCut3DOutOfCoreSegmentation<TInput, TForeground, TBackground, TOutput> OutOfCoreType;
+    OutOfCoreType::Pointer outOfCore = OutOfCoreType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cube.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+    std::string outputPath = "data/test/cube10x10x10/outputOutOfCore.mhd";
+
+    // set files
+    outOfCore->SetInputFileName(inputPath);
+    outOfCore->SetForegroundFileName(forgroundPath);
+    outOfCore->SetBackgroundFileName(backgroundPath);
+    outOfCore->SetOutputFileName(outputPath);
+
+    // set parameters
+    outOfCore->SetForegroundPixelValue(255);
+    outOfCore->SetBackgroundPixelValue(0);
+    outOfCore->SetSigma(50.0);
+    outOfCore->SetBoundaryDirectionTypeToBrightDark();
+    outOfCore->SetMemoryBudget(1);
+    outOfCore->SetScratchDirectory("data/test/cube10x10x10");
+    outOfCore->Update();
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    TOutput::Pointer resultImage = IOHelper::readImage<TOutput>(outputPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+    substractFilter->SetInput1(resultImage);
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+}
+
+TEST_F(TestSegmentation, CubeQuantizedGraphCutTest){
+    // same as CubeGraphCutTest, but with 16-bit integer capacities
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput, short> QuantizedFilterType;
+    QuantizedFilterType::Pointer quantizedFilter = QuantizedFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cube.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    quantizedFilter->SetInputImage(inputImage);
+    quantizedFilter->SetForegroundImage(foregroundMask);
+    quantizedFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    quantizedFilter->SetForegroundPixelValue(255);
+    quantizedFilter->SetBackgroundPixelValue(0);
+    quantizedFilter->SetSigma(50.0);
+    quantizedFilter->SetBoundaryDirectionTypeToBrightDark();
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(quantizedFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+
+    // rounding is at most half a quantization step
+    EXPECT_LE(quantizedFilter->GetMaximumQuantizationError(), 0.5 / quantizedFilter->GetCapacityScale() + 1e-9);
+}
+
+TEST_F(TestSegmentation, CubeBrickOrderGraphCutTest){
+    // same as CubeGraphCutTest, but with the voxels numbered brick by brick. 3 does not divide 10, so the bricks at the
+    // borders are clipped
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    KolmogorovFilterType::Pointer brickFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cube.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    brickFilter->SetInputImage(inputImage);
+    brickFilter->SetForegroundImage(foregroundMask);
+    brickFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    brickFilter->SetForegroundPixelValue(255);
+    brickFilter->SetBackgroundPixelValue(0);
+    brickFilter->SetSigma(50.0);
+    brickFilter->SetBoundaryDirectionTypeToBrightDark();
+    brickFilter->SetNodeOrderToBrick();
+    brickFilter->SetBrickSize(3);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(brickFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+}
+
+TEST_F(TestSegmentation, CubeRegionalTermGraphCutTest){
+    // same as CubeGraphCutTestWithNoise, but with the intensity histograms of the seeds as regional term
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    KolmogorovFilterType::Pointer regionalFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    regionalFilter->SetInputImage(inputImage);
+    regionalFilter->SetForegroundImage(foregroundMask);
+    regionalFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    regionalFilter->SetForegroundPixelValue(255);
+    regionalFilter->SetBackgroundPixelValue(0);
+    regionalFilter->SetSigma(50.0);
+    regionalFilter->SetBoundaryDirectionTypeToBrightDark();
+    regionalFilter->SetLambda(1.0);
+    regionalFilter->SetNumberOfHistogramBins(32);
+    regionalFilter->SetNumberOfThreads(2);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(regionalFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+}
+
+TEST_F(TestSegmentation, CubeBoostGraphCutTest){
+    // boosts maxflow on the same graph as kolmogorovs, with every boundary direction, with and without regional term
+    typedef itk::ImageGraphCut3DBoostFilter<TInput, TForeground, TBackground, TOutput> BoostFilterType;
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+
+    for (int run = 0; run < 6; ++run) {
+        BoostFilterType::Pointer boostFilter = BoostFilterType::New();
+        KolmogorovFilterType::Pointer kolmogorovFilter = KolmogorovFilterType::New();
+        GraphCutFilterType *filters[2] = {boostFilter, kolmogorovFilter};
+        for (int i = 0; i < 2; ++i) {
+            filters[i]->SetInputImage(inputImage);
+            filters[i]->SetForegroundImage(foregroundMask);
+            filters[i]->SetBackgroundImage(backgroundMask);
+            filters[i]->SetForegroundPixelValue(255);
+            filters[i]->SetBackgroundPixelValue(0);
+            filters[i]->SetSigma(50.0);
+            if (run % 3 == 0) {
+                filters[i]->SetBoundaryDirectionTypeToNoDirection();
+            } else if (run % 3 == 1) {
+                filters[i]->SetBoundaryDirectionTypeToBrightDark();
+            } else {
+                filters[i]->SetBoundaryDirectionTypeToDarkBright();
+            }
+            if (run >= 3) {
+                filters[i]->SetLambda(1.0);
+                filters[i]->SetNumberOfHistogramBins(32);
+            }
+            filters[i]->Update();
+        }
+
+        itk::ImageRegionConstIterator<TOutput> boostIterator(boostFilter->GetOutput(),
+                                                             boostFilter->GetOutput()->GetLargestPossibleRegion());
+        itk::ImageRegionConstIterator<TOutput> kolmogorovIterator(kolmogorovFilter->GetOutput(),
+                                                                  kolmogorovFilter->GetOutput()->GetLargestPossibleRegion());
+        unsigned int differences = 0;
+        for (; !boostIterator.IsAtEnd(); ++boostIterator, ++kolmogorovIterator) {
+            if (boostIterator.Get() != kolmogorovIterator.Get()) {
+                differences++;
+            }
+        }
+        EXPECT_EQ(0u, differences) << "run " << run;
+    }
+}
+
+TEST_F(TestSegmentation, CubeIterativeGraphCutTest){
+    // same as CubeRegionalTermGraphCutTest, refined with Gaussian mixtures fitted to the segmentation
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    KolmogorovFilterType::Pointer iterativeFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    iterativeFilter->SetInputImage(inputImage);
+    iterativeFilter->SetForegroundImage(foregroundMask);
+    iterativeFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    iterativeFilter->SetForegroundPixelValue(255);
+    iterativeFilter->SetBackgroundPixelValue(0);
+    iterativeFilter->SetSigma(50.0);
+    iterativeFilter->SetBoundaryDirectionTypeToBrightDark();
+    iterativeFilter->SetLambda(1.0);
+    iterativeFilter->SetNumberOfIterations(5);
+    iterativeFilter->SetNumberOfGaussians(3);
+    iterativeFilter->SetNumberOfThreads(2);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(iterativeFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+
+    // the labels do not change after the first refinement
+    EXPECT_EQ(2u, iterativeFilter->GetNumberOfPerformedIterations());
+}
+
+TEST_F(TestSegmentation, CubeIterativeCostImagesGraphCutTest){
+    // same as CubeIterativeGraphCutTest, with a source cost image that forces a block of background voxels into the
+    // foreground. The refinement keeps the costs.
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    typedef KolmogorovFilterType::CostImageType CostImageType;
+    KolmogorovFilterType::Pointer iterativeFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+
+    // the source cost is paid for the background, far more than the boundary and the regional term of the block
+    TInput::IndexType blockIndex = {{7, 1, 4}};
+    TInput::SizeType blockSize = {{2, 2, 2}};
+    TInput::RegionType block(blockIndex, blockSize);
+    CostImageType::Pointer sourceCost = CostImageType::New();
+    sourceCost->CopyInformation(inputImage);
+    sourceCost->SetRegions(inputImage->GetLargestPossibleRegion());
+    sourceCost->Allocate();
+    sourceCost->FillBuffer(0);
+    itk::ImageRegionIterator<CostImageType> costIterator(sourceCost, block);
+    for (; !costIterator.IsAtEnd(); ++costIterator) {
+        costIterator.Set(1000);
+    }
+
+    // set images
+    iterativeFilter->SetInputImage(inputImage);
+    iterativeFilter->SetForegroundImage(foregroundMask);
+    iterativeFilter->SetBackgroundImage(backgroundMask);
+    iterativeFilter->SetSourceCostImage(sourceCost);
+
+    // set parameters
+    iterativeFilter->SetForegroundPixelValue(255);
+    iterativeFilter->SetBackgroundPixelValue(0);
+    iterativeFilter->SetSigma(50.0);
+    iterativeFilter->SetBoundaryDirectionTypeToBrightDark();
+    iterativeFilter->SetLambda(1.0);
+    iterativeFilter->SetNumberOfIterations(5);
+    iterativeFilter->SetNumberOfGaussians(3);
+    iterativeFilter->Update();
+
+    EXPECT_GT(iterativeFilter->GetNumberOfPerformedIterations(), 1u);
+    itk::ImageRegionConstIterator<TOutput> outputIterator(iterativeFilter->GetOutput(), block);
+    for (; !outputIterator.IsAtEnd(); ++outputIterator) {
+        EXPECT_EQ(255u, outputIterator.Get()) << outputIterator.GetIndex();
+    }
+}
+
+TEST_F(TestSegmentation, CubeCostImagesGraphCutTest){
+    // same as CubeGraphCutTestWithNoise, with the intensity as probability of the foreground in the cost images
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    typedef KolmogorovFilterType::CostImageType CostImageType;
+    KolmogorovFilterType::Pointer costFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // the source cost is paid for the background, the sink cost for the foreground
+    CostImageType::Pointer sourceCost = CostImageType::New();
+    CostImageType::Pointer sinkCost = CostImageType::New();
+    CostImageType::Pointer costImages[2] = {sourceCost, sinkCost};
+    for (unsigned int i = 0; i < 2; ++i) {
+        costImages[i]->CopyInformation(inputImage);
+        costImages[i]->SetRegions(inputImage->GetLargestPossibleRegion());
+        costImages[i]->Allocate();
+    }
+    itk::ImageRegionConstIterator<TInput> inputIterator(inputImage, inputImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<CostImageType> sourceIterator(sourceCost, sourceCost->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<CostImageType> sinkIterator(sinkCost, sinkCost->GetLargestPossibleRegion());
+    for (; !inputIterator.IsAtEnd(); ++inputIterator, ++sourceIterator, ++sinkIterator) {
+        sourceIterator.Set(inputIterator.Get() / 255.0f);
+        sinkIterator.Set(1.0f - inputIterator.Get() / 255.0f);
+    }
+
+    // set images
+    costFilter->SetInputImage(inputImage);
+    costFilter->SetForegroundImage(foregroundMask);
+    costFilter->SetBackgroundImage(backgroundMask);
+    costFilter->SetSourceCostImage(sourceCost);
+    costFilter->SetSinkCostImage(sinkCost);
+
+    // set parameters
+    costFilter->SetForegroundPixelValue(255);
+    costFilter->SetBackgroundPixelValue(0);
+    costFilter->SetSigma(50.0);
+    costFilter->SetBoundaryDirectionTypeToBrightDark();
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(costFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+}
+
+TEST_F(TestSegmentation, CubeBoundaryWeightImageGraphCutTest){
+    // same as CubeGraphCutTestWithNoise, with the boundary weights of every direction precomputed in an image
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    typedef KolmogorovFilterType::BoundaryWeightImageType BoundaryWeightImageType;
+    KolmogorovFilterType::Pointer boundaryFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // the weights the filter computes with sigma 50
+    double sigma = 50.0;
+    TInput::RegionType region = inputImage->GetLargestPossibleRegion();
+    BoundaryWeightImageType::Pointer boundaryWeights = BoundaryWeightImageType::New();
+    boundaryWeights->CopyInformation(inputImage);
+    boundaryWeights->SetRegions(region);
+    boundaryWeights->SetNumberOfComponentsPerPixel(3);
+    boundaryWeights->Allocate();
+    itk::ImageRegionIteratorWithIndex<BoundaryWeightImageType> weightIterator(boundaryWeights, region);
+    for (; !weightIterator.IsAtEnd(); ++weightIterator) {
+        BoundaryWeightImageType::PixelType weights(3);
+        weights.Fill(0);
+        for (unsigned int d = 0; d < 3; ++d) {
+            TInput::IndexType neighbor = weightIterator.GetIndex();
+            neighbor[d]++;
+            if (region.IsInside(neighbor)) {
+                double difference = inputImage->GetPixel(weightIterator.GetIndex()) - inputImage->GetPixel(neighbor);
+                weights[d] = exp(-pow(difference, 2) / (2.0 * sigma * sigma));
+            }
+        }
+        weightIterator.Set(weights);
+    }
+
+    // set images
+    boundaryFilter->SetInputImage(inputImage);
+    boundaryFilter->SetForegroundImage(foregroundMask);
+    boundaryFilter->SetBackgroundImage(backgroundMask);
+    boundaryFilter->SetBoundaryWeightImage(boundaryWeights);
+
+    // set parameters
+    boundaryFilter->SetForegroundPixelValue(255);
+    boundaryFilter->SetBackgroundPixelValue(0);
+    boundaryFilter->SetBoundaryDirectionTypeToBrightDark();
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(boundaryFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+    statisticsFilter->Update();
+
+    double pixelSum = statisticsFilter->GetSum();
+    ASSERT_DOUBLE_EQ(0, pixelSum);
+}
+
+TEST_F(TestSegmentation, CubeWarmStartGraphCutTest){
+    // a series of three frames: the noise free cube, the noisy cube and the noise free cube again. Only the first one
+    // builds the graph, the others update its capacities and must give the same result as a cold solve.
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    KolmogorovFilterType::Pointer warmStartFilter = KolmogorovFilterType::New();
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cube.mhd";
+    std::string noisyInputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TInput::Pointer noisyInputImage = IOHelper::readImage<TInput>(noisyInputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+
+    // set images
+    warmStartFilter->SetForegroundImage(foregroundMask);
+    warmStartFilter->SetBackgroundImage(backgroundMask);
+
+    // set parameters
+    warmStartFilter->SetForegroundPixelValue(255);
+    warmStartFilter->SetBackgroundPixelValue(0);
+    warmStartFilter->SetSigma(50.0);
+    warmStartFilter->SetBoundaryDirectionTypeToBrightDark();
+    warmStartFilter->SetWarmStart(true);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    substractFilter->SetInput1(warmStartFilter->GetOutput());
+    substractFilter->SetInput2(expectedResultImage);
+    statisticsFilter->SetInput(substractFilter->GetOutput());
+
+    TInput::Pointer frames[3] = {inputImage, noisyInputImage, inputImage};
+    for (int frame = 0; frame < 3; ++frame) {
+        warmStartFilter->SetInputImage(frames[frame]);
+        statisticsFilter->Update();
+
+        EXPECT_EQ(frame > 0, warmStartFilter->WasWarmStarted()) << "frame " << frame;
+        ASSERT_DOUBLE_EQ(0, statisticsFilter->GetSum()) << "frame " << frame;
+    }
+    EXPECT_GT(warmStartFilter->GetNumberOfUpdatedCapacities(), 0);
+}
+
+TEST_F(TestSegmentation, CubeBatchGraphCutTest){
+    // the cubes of CubeGraphCutTest and CubeGraphCutTestWithNoise segmented twice on two threads, plus a job which fails
+    typedef itk::ImageGraphCut3DBatchSegmentation<TInput, TForeground, TBackground, TOutput> BatchType;
+    BatchType::Pointer batch = BatchType::New();
+
+    // path to files
+    std::string inputPaths[2] = {"data/test/cube10x10x10/cube.mhd", "data/test/cube10x10x10/cubeNoisy_0p01.mhd"};
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    for (int i = 0; i < 4; ++i) {
+        std::ostringstream outputPath;
+        outputPath << "data/test/cube10x10x10/outputBatch" << i << ".mhd";
+        batch->AddJob(inputPaths[i % 2], forgroundPath, backgroundPath, outputPath.str(), 50.0, BatchType::FilterType::BrightDark);
+    }
+    batch->AddJob("data/test/cube10x10x10/missing.mhd", forgroundPath, backgroundPath,
+                  "data/test/cube10x10x10/outputBatchMissing.mhd", 50.0);
+
+    // set parameters
+    batch->SetForegroundPixelValue(255);
+    batch->SetBackgroundPixelValue(0);
+    batch->SetNumberOfThreads(2);
+    batch->Update();
+
+    EXPECT_EQ(1, batch->GetNumberOfFailedJobs());
+    EXPECT_FALSE(batch->GetJobResult(4).succeeded);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(batch->GetJobResult(i).succeeded) << batch->GetJobResult(i).errorMessage;
+
+        std::ostringstream outputPath;
+        outputPath << "data/test/cube10x10x10/outputBatch" << i << ".mhd";
+        TOutput::Pointer resultImage = IOHelper::readImage<TOutput>(outputPath.str().c_str());
+        substractFilter->SetInput1(resultImage);
+        substractFilter->SetInput2(expectedResultImage);
+        statisticsFilter->SetInput(substractFilter->GetOutput());
+        statisticsFilter->Update();
+
+        ASSERT_DOUBLE_EQ(0, statisticsFilter->GetSum()) << "job " << i;
+    }
+}
+
+TEST_F(TestSegmentation, CubePipelinedBatchGraphCutTest){
+    // same as CubeBatchGraphCutTest, with the stages of the jobs overlapping instead of the jobs
+    typedef itk::ImageGraphCut3DBatchSegmentation<TInput, TForeground, TBackground, TOutput> BatchType;
+    BatchType::Pointer batch = BatchType::New();
+
+    // path to files
+    std::string inputPaths[2] = {"data/test/cube10x10x10/cube.mhd", "data/test/cube10x10x10/cubeNoisy_0p01.mhd"};
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+    std::string expectedPath = "data/test/cube10x10x10/expectedResult.mhd";
+
+    // the failing job is in the middle of the pipeline
+    for (int i = 0; i < 5; ++i) {
+        std::ostringstream outputPath;
+        outputPath << "data/test/cube10x10x10/outputPipelined" << i << ".mhd";
+        std::string inputPath = i == 2 ? "data/test/cube10x10x10/missing.mhd" : inputPaths[i % 2];
+        batch->AddJob(inputPath, forgroundPath, backgroundPath, outputPath.str(), 50.0, BatchType::FilterType::BrightDark);
+    }
+
+    // set parameters
+    batch->SetForegroundPixelValue(255);
+    batch->SetBackgroundPixelValue(0);
+    batch->SetPipelined(true);
+    batch->Update();
+
+    EXPECT_EQ(1, batch->GetNumberOfFailedJobs());
+    EXPECT_FALSE(batch->GetJobResult(2).succeeded);
+
+    // compare the results: I_Result(x)-I_Expected(x)==0
+    TOutput::Pointer expectedResultImage = IOHelper::readImage<TOutput>(expectedPath.c_str());
+    for (int i = 0; i < 5; ++i) {
+        if (i == 2) {
+            continue;
+        }
+        ASSERT_TRUE(batch->GetJobResult(i).succeeded) << batch->GetJobResult(i).errorMessage;
+
+        std::ostringstream outputPath;
+        outputPath << "data/test/cube10x10x10/outputPipelined" << i << ".mhd";
+        TOutput::Pointer resultImage = IOHelper::readImage<TOutput>(outputPath.str().c_str());
+        substractFilter->SetInput1(resultImage);
+        substractFilter->SetInput2(expectedResultImage);
+        statisticsFilter->SetInput(substractFilter->GetOutput());
+        statisticsFilter->Update();
+
+        ASSERT_DOUBLE_EQ(0, statisticsFilter->GetSum()) << "job " << i;
+    }
+}
+
+TEST_F(TestSegmentation, MultiLabelMoveTypesTest){
+    // Three slabs of intensity along x with noise, one line of seeds of a label in each. No move raises the energy. A
+    // swap is the weaker move, it may end in a lower local minimum than the expansions but not by more than 1%. A fusion
+    // with the labeling of the expansions as its proposal ends at most at its energy.
+    typedef itk::Image<unsigned short, 3> TMultiLabel;
+    typedef itk::ImageMultiLabelKolmogorovFilter<TInput, TMultiLabel, TMultiLabel> KolmogorovFilterType;
+
+    TInput::SizeType size = {{20, 16, 12}};
+    TInput::Pointer inputImage = TInput::New();
+    inputImage->SetRegions(size);
+    inputImage->Allocate();
+    TMultiLabel::Pointer multiLabelImage = TMultiLabel::New();
+    multiLabelImage->SetRegions(size);
+    multiLabelImage->Allocate();
+
+    std::mt19937 generator(42);
+    itk::ImageRegionIteratorWithIndex<TInput> inputIterator(inputImage, inputImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<TMultiLabel> multiLabelIterator(multiLabelImage,
+                                                             multiLabelImage->GetLargestPossibleRegion());
+    for (; !inputIterator.IsAtEnd(); ++inputIterator, ++multiLabelIterator) {
+        const TInput::IndexType index = inputIterator.GetIndex();
+        const short noise = static_cast<short>(generator() % 81) - 40;
+        inputIterator.Set((index[0] < 7 ? 0 : (index[0] < 14 ? 300 : 600)) + noise);
+
+        TMultiLabel::PixelType label = 0;
+        if (index[1] >= 2 && index[1] < 14 && index[2] == 6) {
+            label = index[0] == 1 ? 10 : (index[0] == 10 ? 20 : (index[0] == 18 ? 30 : 0));
+        }
+        multiLabelIterator.Set(label);
+    }
+
+    KolmogorovFilterType::Pointer expansionFilter = KolmogorovFilterType::New();
+    expansionFilter->SetInputImage(inputImage);
+    expansionFilter->SetMultiLabelImage(multiLabelImage);
+    expansionFilter->SetSigma(50.0);
+    expansionFilter->Update();
+
+    KolmogorovFilterType::Pointer swapFilter = KolmogorovFilterType::New();
+    swapFilter->SetInputImage(inputImage);
+    swapFilter->SetMultiLabelImage(multiLabelImage);
+    swapFilter->SetSigma(50.0);
+    swapFilter->SetMoveTypeToSwap();
+    swapFilter->Update();
+
+    KolmogorovFilterType::Pointer fusionFilter = KolmogorovFilterType::New();
+    fusionFilter->SetInputImage(inputImage);
+    fusionFilter->SetMultiLabelImage(multiLabelImage);
+    fusionFilter->SetSigma(50.0);
+    fusionFilter->SetMoveTypeToFusion();
+    fusionFilter->AddProposal(expansionFilter->GetOutput());
+    fusionFilter->Update();
+    EXPECT_TRUE(fusionFilter->GetCycles().front().fusion);
+
+    KolmogorovFilterType *filters[3] = {expansionFilter, swapFilter, fusionFilter};
+    for (int i = 0; i < 3; ++i) {
+        const std::vector<double> &energies = filters[i]->GetCycleEnergies();
+        ASSERT_FALSE(energies.empty());
+        for (unsigned int iCycle = 1; iCycle < energies.size(); ++iCycle) {
+            EXPECT_LE(energies[iCycle], energies[iCycle - 1]) << "filter " << i << ", cycle " << iCycle;
+        }
+    }
+
+    const double expansionEnergy = expansionFilter->GetCycleEnergies().back();
+    EXPECT_GE(swapFilter->GetCycleEnergies().back(), 0.99 * expansionEnergy);
+    EXPECT_LE(fusionFilter->GetCycleEnergies().back(), expansionEnergy);
+}
+
+TEST_F(TestSegmentation, FemurMultiLabelIncrementalTest){
+    // after an edit of the seeds the update only re-solves the labels involved and must give the result of a solve from
+    // scratch, changes of sigma or the input image solve from scratch
+    std::string inputPath = "data/test/left_femur/input.nrrd";
+    std::string multiLabelPath = "data/test/left_femur/multiLabels.nrrd";
+
+    typedef itk::Image<unsigned short, 3> TMultiLabel;
+    typedef itk::ImageMultiLabelKolmogorovFilter<TInput, TMultiLabel, TMultiLabel> KolmogorovFilterType;
+
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TMultiLabel::Pointer multiLabelImage = IOHelper::readImage<TMultiLabel>(multiLabelPath.c_str());
+
+    KolmogorovFilterType::Pointer incrementalFilter = KolmogorovFilterType::New();
+    incrementalFilter->SetInputImage(inputImage);
+    incrementalFilter->SetMultiLabelImage(multiLabelImage);
+    incrementalFilter->SetSigma(50.0);
+    incrementalFilter->SetIncrementalUpdate(true);
+    incrementalFilter->Update();
+    EXPECT_FALSE(incrementalFilter->GetUpdatedIncrementally());
+
+    // remove the first seed, relabel the first seed of another label to its label and add a seed of that label
+    TMultiLabel::IndexType removed, relabeled, added;
+    TMultiLabel::PixelType firstValue = 0, secondValue = 0;
+    bool foundAdded = false;
+    itk::ImageRegionConstIteratorWithIndex<TMultiLabel> labelIterator(multiLabelImage,
+                                                                     multiLabelImage->GetLargestPossibleRegion());
+    for (; !labelIterator.IsAtEnd() && (!secondValue || !foundAdded); ++labelIterator) {
+        if (labelIterator.Get() == 0 && !foundAdded) {
+            added = labelIterator.GetIndex();
+            foundAdded = true;
+        } else if (labelIterator.Get() != 0 && !firstValue) {
+            removed = labelIterator.GetIndex();
+            firstValue = labelIterator.Get();
+        } else if (labelIterator.Get() != 0 && labelIterator.Get() != firstValue && !secondValue) {
+            relabeled = labelIterator.GetIndex();
+            secondValue = labelIterator.Get();
+        }
+    }
+    ASSERT_TRUE(secondValue && foundAdded);
+    multiLabelImage->SetPixel(removed, 0);
+    multiLabelImage->SetPixel(relabeled, firstValue);
+    multiLabelImage->SetPixel(added, secondValue);
+    multiLabelImage->Modified();
+
+    incrementalFilter->Update();
+    EXPECT_TRUE(incrementalFilter->GetUpdatedIncrementally());
+    EXPECT_EQ(3, incrementalFilter->GetChangedSeedVoxels().size());
+
+    KolmogorovFilterType::Pointer scratchFilter = KolmogorovFilterType::New();
+    scratchFilter->SetInputImage(inputImage);
+    scratchFilter->SetMultiLabelImage(multiLabelImage);
+    scratchFilter->SetSigma(50.0);
+    scratchFilter->Update();
+
+    // both are local minima of the same energy, reached from different labelings
+    itk::ImageRegionConstIterator<TMultiLabel> incrementalIterator(incrementalFilter->GetOutput(),
+                                                                   incrementalFilter->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<TMultiLabel> scratchIterator(scratchFilter->GetOutput(),
+                                                               scratchFilter->GetOutput()->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    unsigned int voxels = 0;
+    for (; !incrementalIterator.IsAtEnd(); ++incrementalIterator, ++scratchIterator, ++voxels) {
+        if (incrementalIterator.Get() != scratchIterator.Get()) {
+            differences++;
+        }
+    }
+    EXPECT_LE(differences, voxels / 1000);
+    EXPECT_NEAR(scratchFilter->GetCycleEnergies().back(), incrementalFilter->GetCycleEnergies().back(),
+                1e-3 * scratchFilter->GetCycleEnergies().back());
+
+    // the edge weights are out of date
+    incrementalFilter->SetSigma(40.0);
+    incrementalFilter->Modified();
+    incrementalFilter->Update();
+    EXPECT_FALSE(incrementalFilter->GetUpdatedIncrementally());
+    inputImage->Modified();
+    incrementalFilter->Update();
+    EXPECT_FALSE(incrementalFilter->GetUpdatedIncrementally());
+
+    // nothing changed
+    incrementalFilter->Modified();
+    incrementalFilter->Update();
+    EXPECT_TRUE(incrementalFilter->GetUpdatedIncrementally());
+    EXPECT_TRUE(incrementalFilter->GetChangedSeedVoxels().empty());
+}
+
+#ifdef GRIDCUT_LIBRARY_AVAILABLE
+TEST_F(TestSegmentation, FemurMultiLabelKolmogorovTest){
+    // path to files
+    std::string inputPath = "data/test/left_femur/input.nrrd";
+    std::string multiLabelPath = "data/test/left_femur/multiLabels.nrrd";
+
+    typedef itk::Image<unsigned short, 3> TMultiLabel;
+    typedef itk::ImageMultiLabelKolmogorovFilter<TInput, TMultiLabel, TMultiLabel> KolmogorovFilterType;
+    typedef itk::ImageMultiLabelGridCutFilter<TInput, TMultiLabel, TMultiLabel> GridCutFilterType;
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TMultiLabel::Pointer multiLabelImage = IOHelper::readImage<TMultiLabel>(multiLabelPath.c_str());
+
+    KolmogorovFilterType::Pointer kolmogorovFilter = KolmogorovFilterType::New();
+    kolmogorovFilter->SetInputImage(inputImage);
+    kolmogorovFilter->SetMultiLabelImage(multiLabelImage);
+    kolmogorovFilter->SetSigma(50.0);
+    kolmogorovFilter->Update();
+
+    GridCutFilterType::Pointer gridCutFilter = GridCutFilterType::New();
+    gridCutFilter->SetInputImage(inputImage);
+    gridCutFilter->SetMultiLabelImage(multiLabelImage);
+    gridCutFilter->SetSigma(50.0);
+    gridCutFilter->Update();
+
+    // both minimize the same energy in the same order of labels, only cuts of equal energy may be chosen differently
+    itk::ImageRegionConstIterator<TMultiLabel> kolmogorovIterator(kolmogorovFilter->GetOutput(),
+                                                                  kolmogorovFilter->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<TMultiLabel> gridCutIterator(gridCutFilter->GetOutput(),
+                                                               gridCutFilter->GetOutput()->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    unsigned int voxels = 0;
+    for (; !kolmogorovIterator.IsAtEnd(); ++kolmogorovIterator, ++gridCutIterator, ++voxels) {
+        if (kolmogorovIterator.Get() != gridCutIterator.Get()) {
+            differences++;
+        }
+    }
+    EXPECT_LE(differences, voxels / 1000);
+}
+
+TEST_F(TestSegmentation, CubeGridCutBoundaryDirectionTest){
+    // GridCut against kolmogorovs maxflow for every boundary direction, with the boundary weights computed from the
+    // intensities and taken from an image of the same weights
+    typedef itk::ImageGridCutFilter<TInput, TForeground, TBackground, TOutput> GridCutFilterType;
+    typedef itk::ImageGraphCut3DKolmogorovFilter<TInput, TForeground, TBackground, TOutput> KolmogorovFilterType;
+    typedef KolmogorovFilterType::BoundaryWeightImageType BoundaryWeightImageType;
+
+    // path to files
+    std::string inputPath = "data/test/cube10x10x10/cubeNoisy_0p01.mhd";
+    std::string forgroundPath = "data/test/cube10x10x10/foregroundMask.mhd";
+    std::string backgroundPath = "data/test/cube10x10x10/backgroundMask.mhd";
+
+    // read the images
+    TInput::Pointer inputImage = IOHelper::readImage<TInput>(inputPath.c_str());
+    TForeground::Pointer foregroundMask = IOHelper::readImage<TForeground>(forgroundPath.c_str());
+    TBackground::Pointer backgroundMask = IOHelper::readImage<TBackground>(backgroundPath.c_str());
+
+    // the weights the filters compute with sigma 50
+    double sigma = 50.0;
+    TInput::RegionType region = inputImage->GetLargestPossibleRegion();
+    BoundaryWeightImageType::Pointer boundaryWeights = BoundaryWeightImageType::New();
+    boundaryWeights->CopyInformation(inputImage);
+    boundaryWeights->SetRegions(region);
+    boundaryWeights->SetNumberOfComponentsPerPixel(3);
+    boundaryWeights->Allocate();
+    itk::ImageRegionIteratorWithIndex<BoundaryWeightImageType> weightIterator(boundaryWeights, region);
+    for (; !weightIterator.IsAtEnd(); ++weightIterator) {
+        BoundaryWeightImageType::PixelType weights(3);
+        weights.Fill(0);
+        for (unsigned int d = 0; d < 3; ++d) {
+            TInput::IndexType neighbor = weightIterator.GetIndex();
+            neighbor[d]++;
+            if (region.IsInside(neighbor)) {
+                double difference = inputImage->GetPixel(weightIterator.GetIndex()) - inputImage->GetPixel(neighbor);
+                weights[d] = exp(-pow(difference, 2) / (2.0 * sigma * sigma));
+            }
+        }
+        weightIterator.Set(weights);
+    }
+
+    for (int run = 0; run < 6; ++run) {
+        GridCutFilterType::Pointer gridCutFilter = GridCutFilterType::New();
+        KolmogorovFilterType::Pointer kolmogorovFilter = KolmogorovFilterType::New();
+        GraphCutFilterType *filters[2] = {gridCutFilter, kolmogorovFilter};
+        for (int i = 0; i < 2; ++i) {
+            filters[i]->SetInputImage(inputImage);
+            filters[i]->SetForegroundImage(foregroundMask);
+            filters[i]->SetBackgroundImage(backgroundMask);
+            filters[i]->SetForegroundPixelValue(255);
+            filters[i]->SetBackgroundPixelValue(0);
+            filters[i]->SetSigma(sigma);
+            if (run % 3 == 0) {
+                filters[i]->SetBoundaryDirectionTypeToNoDirection();
+            } else if (run % 3 == 1) {
+                filters[i]->SetBoundaryDirectionTypeToBrightDark();
+            } else {
+                filters[i]->SetBoundaryDirectionTypeToDarkBright();
+            }
+            if (run >= 3) {
+                filters[i]->SetBoundaryWeightImage(boundaryWeights);
+            }
+            filters[i]->Update();
+        }
+
+        itk::ImageRegionConstIterator<TOutput> gridCutIterator(gridCutFilter->GetOutput(),
+                                                               gridCutFilter->GetOutput()->GetLargestPossibleRegion());
+        itk::ImageRegionConstIterator<TOutput> kolmogorovIterator(kolmogorovFilter->GetOutput(),
+                                                                  kolmogorovFilter->GetOutput()->GetLargestPossibleRegion());
+        unsigned int differences = 0;
+        for (; !gridCutIterator.IsAtEnd(); ++gridCutIterator, ++kolmogorovIterator) {
+            if (gridCutIterator.Get() != kolmogorovIterator.Get()) {
+                differences++;
+            }
+        }
+        EXPECT_EQ(0u, differences) << "run " << run;
+    }
+}
+#endif // GRIDCUT_LIBRARY_AVAILABLE